@@ -1,6 +1,7 @@
 #include "simulator.h"
 #include "cache.h"
 #include "log.h"
+#include "checkpoint_manager.h"
 
 // Cache class
 // constructors/destructors
@@ -31,6 +32,9 @@ Cache::Cache(
       m_sets[i] = CacheSet::createCacheSet(cfgname, core_id, replacement_policy, m_cache_type, m_associativity, m_blocksize, m_set_info);
    }
 
+   if (Sim()->getCheckpointManager())
+      Sim()->getCheckpointManager()->registerObject(name, core_id, this);
+
    #ifdef ENABLE_SET_USAGE_HIST
    m_set_usage_hist = new UInt64[m_num_sets];
    for (UInt32 i = 0; i < m_num_sets; i++)
@@ -169,9 +173,10 @@ Cache::updateCounters(bool cache_hit)
 {
    if (m_enabled)
    {
-      m_num_accesses ++;
+      // Shared caches are updated by all sharers, each holding only the lock for the set they access
+      __sync_fetch_and_add(&m_num_accesses, 1);
       if (cache_hit)
-         m_num_hits ++;
+         __sync_fetch_and_add(&m_num_hits, 1);
    }
 }
 
@@ -184,3 +189,23 @@ Cache::updateHits(Core::mem_op_t mem_op_type, UInt64 hits)
       m_num_hits += hits;
    }
 }
+
+void
+Cache::saveCheckpoint(CheckpointWriter &writer)
+{
+   writer.write(m_num_sets);
+   writer.write(m_associativity);
+   writer.write(m_blocksize);
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i]->saveCheckpoint(writer);
+}
+
+void
+Cache::loadCheckpoint(CheckpointReader &reader)
+{
+   reader.readExpect(m_num_sets, "number of sets");
+   reader.readExpect(m_associativity, "associativity");
+   reader.readExpect(m_blocksize, "block size");
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i]->loadCheckpoint(reader);
+}
@@ -11,11 +11,12 @@
 #include "log.h"
 #include "core.h"
 #include "fault_injection.h"
+#include "checkpoint.h"
 
 // Define to enable the set usage histogram
 //#define ENABLE_SET_USAGE_HIST
 
-class Cache : public CacheBase
+class Cache : public CacheBase, public Checkpointable
 {
    private:
       bool m_enabled;
@@ -68,6 +69,9 @@ class Cache : public CacheBase
 
       void enable() { m_enabled = true; }
       void disable() { m_enabled = false; }
+
+      void saveCheckpoint(CheckpointWriter &writer);
+      void loadCheckpoint(CheckpointReader &reader);
 };
 
 template <class T>
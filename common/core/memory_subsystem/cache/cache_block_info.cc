@@ -3,6 +3,7 @@
 #include "pr_l2_cache_block_info.h"
 #include "shared_cache_block_info.h"
 #include "log.h"
+#include "checkpoint.h"
 
 const char* CacheBlockInfo::option_names[] =
 {
@@ -59,6 +60,28 @@ CacheBlockInfo::invalidate()
    m_cstate = CacheState::INVALID;
 }
 
+void
+CacheBlockInfo::saveCheckpoint(CheckpointWriter &writer) const
+{
+   writer.write(m_tag);
+   writer.write(m_cstate);
+   writer.write(m_owner);
+   writer.write(m_used);
+   writer.write(m_options);
+}
+
+void
+CacheBlockInfo::loadCheckpoint(CheckpointReader &reader)
+{
+   // Reset any state kept by derived classes before taking over the saved line
+   invalidate();
+   m_tag = reader.read<IntPtr>();
+   m_cstate = reader.read<CacheState::cstate_t>();
+   m_owner = reader.read<UInt64>();
+   m_used = reader.read<BitsUsedType>();
+   m_options = reader.read<UInt8>();
+}
+
 void
 CacheBlockInfo::clone(CacheBlockInfo* cache_block_info)
 {
@@ -5,6 +5,9 @@
 #include "cache_state.h"
 #include "cache_base.h"
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class CacheBlockInfo
 {
    public:
@@ -60,6 +63,9 @@ class CacheBlockInfo
       bool updateUsage(BitsUsedType used);
 
       static const char* getOptionName(option_t option);
+
+      void saveCheckpoint(CheckpointWriter &writer) const;
+      void loadCheckpoint(CheckpointReader &reader);
 };
 
 class CacheCntlr
@@ -12,15 +12,22 @@
 #include "simulator.h"
 #include "config.h"
 #include "config.hpp"
+#include "checkpoint.h"
+
+#if defined(__x86_64__) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
 
 CacheSet::CacheSet(CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize):
       m_associativity(associativity), m_blocksize(blocksize)
 {
    m_cache_block_info_array = new CacheBlockInfo*[m_associativity];
+   m_tags = new IntPtr[m_associativity];
    for (UInt32 i = 0; i < m_associativity; i++)
    {
       m_cache_block_info_array[i] = CacheBlockInfo::create(cache_type);
+      m_tags[i] = m_cache_block_info_array[i]->getTag();
    }
 
    if (Sim()->getFaultinjectionManager())
@@ -37,9 +44,29 @@ CacheSet::~CacheSet()
    for (UInt32 i = 0; i < m_associativity; i++)
       delete m_cache_block_info_array[i];
    delete [] m_cache_block_info_array;
+   delete [] m_tags;
    delete [] m_blocks;
 }
 
+void
+CacheSet::saveCheckpoint(CheckpointWriter &writer)
+{
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_cache_block_info_array[i]->saveCheckpoint(writer);
+   saveReplacementState(writer);
+}
+
+void
+CacheSet::loadCheckpoint(CheckpointReader &reader)
+{
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      m_cache_block_info_array[i]->loadCheckpoint(reader);
+      m_tags[i] = m_cache_block_info_array[i]->getTag();
+   }
+   loadReplacementState(reader);
+}
+
 void
 CacheSet::read_line(UInt32 line_index, UInt32 offset, Byte *out_buff, UInt32 bytes, bool update_replacement)
 {
@@ -66,33 +93,67 @@ CacheSet::write_line(UInt32 line_index, UInt32 offset, Byte *in_buff, UInt32 byt
       updateReplacementIndex(line_index);
 }
 
-CacheBlockInfo*
-CacheSet::find(IntPtr tag, UInt32* line_index)
+SInt32
+CacheSet::findWay(IntPtr tag) const
 {
-   for (SInt32 index = m_associativity-1; index >= 0; index--)
+   // Compare the tags of several ways at once. When (invalid) tags occur more than once,
+   // return the highest matching way, like the scalar search from m_associativity-1 down to 0 did.
+   UInt32 index = 0;
+   SInt32 found = -1;
+
+#if defined(__x86_64__) && defined(__AVX2__)
+   const __m256i needle = _mm256_set1_epi64x(tag);
+   for ( ; index + 4 <= m_associativity; index += 4)
    {
-      if (m_cache_block_info_array[index]->getTag() == tag)
-      {
-         if (line_index != NULL)
-            *line_index = index;
-         return (m_cache_block_info_array[index]);
-      }
+      __m256i ways = _mm256_loadu_si256((const __m256i*)&m_tags[index]);
+      int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(ways, needle)));
+      if (mask)
+         found = index + 31 - __builtin_clz(mask);
    }
-   return NULL;
+#elif defined(__x86_64__) && defined(__SSE2__)
+   const __m128i needle = _mm_set1_epi64x(tag);
+   for ( ; index + 2 <= m_associativity; index += 2)
+   {
+      __m128i eq32 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&m_tags[index]), needle);
+      // SSE2 has no 64-bit compare: a tag matches only when both of its 32-bit halves do
+      __m128i eq64 = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+      int mask = _mm_movemask_pd(_mm_castsi128_pd(eq64));
+      if (mask)
+         found = index + 31 - __builtin_clz(mask);
+   }
+#endif
+
+   for ( ; index < m_associativity; index++)
+   {
+      if (m_tags[index] == tag)
+         found = index;
+   }
+
+   return found;
+}
+
+CacheBlockInfo*
+CacheSet::find(IntPtr tag, UInt32* line_index)
+{
+   SInt32 index = findWay(tag);
+   if (index < 0)
+      return NULL;
+
+   if (line_index != NULL)
+      *line_index = index;
+   return (m_cache_block_info_array[index]);
 }
 
 bool
 CacheSet::invalidate(IntPtr& tag)
 {
-   for (SInt32 index = m_associativity-1; index >= 0; index--)
-   {
-      if (m_cache_block_info_array[index]->getTag() == tag)
-      {
-         m_cache_block_info_array[index]->invalidate();
-         return true;
-      }
-   }
-   return false;
+   SInt32 index = findWay(tag);
+   if (index < 0)
+      return false;
+
+   m_cache_block_info_array[index]->invalidate();
+   m_tags[index] = m_cache_block_info_array[index]->getTag();
+   return true;
 }
 
 void
@@ -105,7 +166,7 @@ CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* evicti
 
    assert(eviction != NULL);
 
-   if (m_cache_block_info_array[index]->isValid())
+   if (isValidWay(index))
    {
       *eviction = true;
       // FIXME: This is a hack. I dont know if this is the best way to do
@@ -120,6 +181,7 @@ CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* evicti
 
    // FIXME: This is a hack. I dont know if this is the best way to do
    m_cache_block_info_array[index]->clone(cache_block_info);
+   m_tags[index] = cache_block_info->getTag();
 
    if (fill_buff != NULL && m_blocks != NULL)
       memcpy(&m_blocks[index * m_blocksize], (void*) fill_buff, m_blocksize);
@@ -10,6 +10,9 @@
 
 #include <cstring>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 // Per-cache object to store replacement-policy related info (e.g. statistics),
 // can collect data from all CacheSet* objects which are per set and implement the actual replacement policy
 class CacheSetInfo
@@ -30,11 +33,16 @@ class CacheSet
 
    protected:
       CacheBlockInfo** m_cache_block_info_array;
+      // Tags of all ways stored contiguously, mirroring m_cache_block_info_array[i]->getTag(),
+      // so a lookup is a (vectorized) compare over a single array without touching the block infos
+      IntPtr* m_tags;
       char* m_blocks;
       UInt32 m_associativity;
       UInt32 m_blocksize;
       Lock m_lock;
 
+      SInt32 findWay(IntPtr tag) const;
+
    public:
 
       CacheSet(CacheBase::cache_t cache_type,
@@ -52,6 +60,7 @@ class CacheSet
       void insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* eviction, CacheBlockInfo* evict_block_info, Byte* evict_buff, CacheCntlr *cntlr = NULL);
 
       CacheBlockInfo* peekBlock(UInt32 way) const { return m_cache_block_info_array[way]; }
+      bool isValidWay(UInt32 way) const { return m_tags[way] != ((IntPtr) ~0); }
 
       char* getDataPtr(UInt32 line_index, UInt32 offset = 0);
       UInt32 getBlockSize(void) const { return m_blocksize; }
@@ -60,6 +69,12 @@ class CacheSet
       virtual void updateReplacementIndex(UInt32) = 0;
 
       bool isValidReplacement(UInt32 index);
+
+      // Save and restore the tags and states of all ways, and the replacement state. Data is not saved.
+      void saveCheckpoint(CheckpointWriter &writer);
+      void loadCheckpoint(CheckpointReader &reader);
+      virtual void saveReplacementState(CheckpointWriter &writer) {}
+      virtual void loadReplacementState(CheckpointReader &reader) {}
 };
 
 #endif /* CACHE_SET_H */
@@ -1,4 +1,5 @@
 #include "cache_set_lru.h"
+#include "checkpoint.h"
 #include "log.h"
 #include "stats.h"
 
@@ -27,7 +28,7 @@ CacheSetLRU::getReplacementIndex(CacheCntlr *cntlr)
    // First try to find an invalid block
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          // Mark our newly-inserted line as most-recently used
          moveToMRU(i);
@@ -123,3 +124,15 @@ CacheSetInfoLRU::~CacheSetInfoLRU()
    if (m_attempts)
       delete [] m_attempts;
 }
+
+void
+CacheSetLRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+}
+
+void
+CacheSetLRU::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(m_lru_bits, m_associativity);
+}
@@ -1,4 +1,5 @@
 #include "cache_set_mru.h"
+#include "checkpoint.h"
 #include "log.h"
 
 // MRU: Most Recently Used
@@ -25,7 +26,7 @@ CacheSetMRU::getReplacementIndex(CacheCntlr *cntlr)
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          updateReplacementIndex(i);
          return i;
@@ -59,3 +60,15 @@ CacheSetMRU::updateReplacementIndex(UInt32 accessed_index)
    }
    m_lru_bits[accessed_index] = 0;
 }
+
+void
+CacheSetMRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+}
+
+void
+CacheSetMRU::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(m_lru_bits, m_associativity);
+}
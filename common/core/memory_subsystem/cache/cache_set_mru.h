@@ -12,6 +12,8 @@ class CacheSetMRU : public CacheSet
 
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader &reader);
 
    private:
       UInt8* m_lru_bits;
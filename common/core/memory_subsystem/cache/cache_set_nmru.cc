@@ -1,4 +1,5 @@
 #include "cache_set_nmru.h"
+#include "checkpoint.h"
 #include "log.h"
 
 // NMRU: Not Most Recently Used
@@ -27,7 +28,7 @@ CacheSetNMRU::getReplacementIndex(CacheCntlr *cntlr)
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          updateReplacementIndex(i);
          return i;
@@ -61,3 +62,17 @@ CacheSetNMRU::updateReplacementIndex(UInt32 accessed_index)
    }
    m_lru_bits[accessed_index] = 0;
 }
+
+void
+CacheSetNMRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetNMRU::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(m_lru_bits, m_associativity);
+   m_replacement_pointer = reader.read<UInt8>();
+}
@@ -1,4 +1,5 @@
 #include "cache_set_nru.h"
+#include "checkpoint.h"
 #include "log.h"
 
 // NRU: Not Recently Used. Some sort of Pseudo LRU policy.
@@ -30,7 +31,7 @@ CacheSetNRU::getReplacementIndex(CacheCntlr *cntlr)
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
          // Mark our newly-inserted line as recently used
@@ -83,3 +84,19 @@ CacheSetNRU::updateReplacementIndex(UInt32 accessed_index)
       }
    }
 }
+
+void
+CacheSetNRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+   writer.write(m_num_bits_set);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetNRU::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(m_lru_bits, m_associativity);
+   m_num_bits_set = reader.read<UInt8>();
+   m_replacement_pointer = reader.read<UInt8>();
+}
@@ -1,4 +1,5 @@
 #include "cache_set_plru.h"
+#include "checkpoint.h"
 #include "log.h"
 
 // Tree LRU for 4 and 8 way caches
@@ -25,7 +26,7 @@ CacheSetPLRU::getReplacementIndex(CacheCntlr *cntlr)
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          updateReplacementIndex(i);
          return i;
@@ -113,3 +114,15 @@ CacheSetPLRU::updateReplacementIndex(UInt32 accessed_index)
       LOG_PRINT_ERROR("PLRU doesn't support associativity %d", m_associativity);
    }
 }
+
+void
+CacheSetPLRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(b, sizeof(b));
+}
+
+void
+CacheSetPLRU::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(b, sizeof(b));
+}
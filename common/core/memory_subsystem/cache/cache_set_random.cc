@@ -24,7 +24,7 @@ CacheSetRandom::getReplacementIndex(CacheCntlr *cntlr)
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-       if (!m_cache_block_info_array[i]->isValid())
+       if (!isValidWay(i))
           return i;   // if there is an invalid line, use that line
    }
 
@@ -1,4 +1,5 @@
 #include "cache_set_round_robin.h"
+#include "checkpoint.h"
 
 CacheSetRoundRobin::CacheSetRoundRobin(
       CacheBase::cache_t cache_type,
@@ -28,3 +29,15 @@ CacheSetRoundRobin::updateReplacementIndex(UInt32 accessed_index)
 {
    return;
 }
+
+void
+CacheSetRoundRobin::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_replacement_index);
+}
+
+void
+CacheSetRoundRobin::loadReplacementState(CheckpointReader &reader)
+{
+   m_replacement_index = reader.read<UInt32>();
+}
@@ -12,6 +12,8 @@ class CacheSetRoundRobin : public CacheSet
 
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader &reader);
 
    private:
       UInt32 m_replacement_index;
@@ -1,4 +1,5 @@
 #include "cache_set_srrip.h"
+#include "checkpoint.h"
 #include "simulator.h"
 #include "config.hpp"
 #include "log.h"
@@ -32,7 +33,7 @@ CacheSetSRRIP::getReplacementIndex(CacheCntlr *cntlr)
 {
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      if (!isValidWay(i))
       {
          // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
          // Prepare way for a new line: set prediction to 'long'
@@ -103,3 +104,17 @@ CacheSetSRRIP::updateReplacementIndex(UInt32 accessed_index)
    if (m_rrip_bits[accessed_index] > 0)
       m_rrip_bits[accessed_index]--;
 }
+
+void
+CacheSetSRRIP::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_rrip_bits, m_associativity);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetSRRIP::loadReplacementState(CheckpointReader &reader)
+{
+   reader.read(m_rrip_bits, m_associativity);
+   m_replacement_pointer = reader.read<UInt8>();
+}
@@ -34,6 +34,8 @@ class Directory
       ~Directory();
 
       DirectoryEntry* getDirectoryEntry(UInt32 entry_num);
+      // Like getDirectoryEntry, but returns NULL rather than allocating entries that were never used
+      DirectoryEntry* peekDirectoryEntry(UInt32 entry_num) const { return m_directory_entry_list[entry_num]; }
       void setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry);
       DirectoryEntry* createDirectoryEntry();
       template <class DirectorySharers> DirectoryEntry* createDirectoryEntrySized();
@@ -63,3 +63,19 @@ std::vector<IntPtr> A53Prefetcher::getNextAddress(IntPtr currentAddress, core_id
    prevAddress = currentAddress;
    return prefetchAddress;
 }
+
+void A53Prefetcher::saveCheckpoint(CheckpointWriter &writer) {
+   writer.write(firstAddress);
+   writer.write(stride);
+   writer.write(prevAddress);
+   writer.write(currentPatternLength);
+   writer.write(currentConsecutivePatternLength);
+}
+
+void A53Prefetcher::loadCheckpoint(CheckpointReader &reader) {
+   firstAddress = reader.read<bool>();
+   stride = reader.read<intptr_t>();
+   prevAddress = reader.read<IntPtr>();
+   currentPatternLength = reader.read<unsigned int>();
+   currentConsecutivePatternLength = reader.read<unsigned int>();
+}
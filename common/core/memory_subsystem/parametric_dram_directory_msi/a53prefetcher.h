@@ -16,6 +16,9 @@ class A53Prefetcher : public Prefetcher
 public:
    A53Prefetcher(String configName, core_id_t core_id);
    std::vector<IntPtr> getNextAddress(IntPtr currentAddress, core_id_t core_id) override;
+
+   void saveCheckpoint(CheckpointWriter &writer) override;
+   void loadCheckpoint(CheckpointReader &reader) override;
 };
 
 #endif // A53PREFETCHER_H
@@ -7,7 +7,11 @@
 #include "fault_injection.h"
 #include "hooks_manager.h"
 #include "cache_atd.h"
+#include "cache_sweep.h"
 #include "shmem_perf.h"
+#include "timer.h"
+#include "self_profile.h"
+#include "checkpoint_manager.h"
 
 #include <cstring>
 
@@ -80,6 +84,19 @@ PrevCacheIndex CacheCntlrList::find(core_id_t core_id, MemComponent::component_t
 }
 #endif
 
+void
+ShardLock::acquire()
+{
+   if (pthread_mutex_trylock(&m_mutex) != 0)
+   {
+      UInt64 t_start = Timer::now();
+      pthread_mutex_lock(&m_mutex);
+      wait_time += SubsecondTime::NS(Timer::now() - t_start);
+      ++contended;
+   }
+   ++acquires;
+}
+
 void CacheMasterCntlr::createSetLocks(UInt32 cache_block_size, UInt32 num_sets, UInt32 core_offset, UInt32 num_cores)
 {
    m_log_blocksize = floorLog2(cache_block_size);
@@ -118,6 +135,8 @@ CacheMasterCntlr::~CacheMasterCntlr()
    {
       delete *it;
    }
+   if (m_sweep)
+      delete m_sweep;
 }
 
 CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
@@ -141,6 +160,8 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
    m_coherent(cache_params.coherent),
    m_prefetch_on_prefetch_hit(false),
    m_l1_mshr(cache_params.outstanding_misses > 0),
+   m_fast_hit_path(false),
+   m_fast_hit_path_checked(false),
    m_core_id(core_id),
    m_cache_block_size(cache_block_size),
    m_cache_writethrough(cache_params.writethrough),
@@ -165,7 +186,10 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
    if (isMasterCache())
    {
       /* Master cache */
-      m_master = new CacheMasterCntlr(name, core_id, cache_params.outstanding_misses);
+      UInt32 num_shards = Sim()->getCfg()->getIntArray("perf_model/" + cache_params.configName + "/lock_shards", core_id);
+      LOG_ASSERT_ERROR(isPower2(num_shards) && num_shards <= cache_params.num_sets,
+                       "%s: lock_shards (%u) must be a power of two no larger than the number of sets", name.c_str(), num_shards);
+      m_master = new CacheMasterCntlr(name, core_id, cache_params.outstanding_misses, cache_block_size, num_shards);
       m_master->m_cache = new Cache(name,
             "perf_model/" + cache_params.configName,
             m_core_id,
@@ -179,6 +203,8 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
                ? Sim()->getFaultinjectionManager()->getFaultInjector(m_core_id_master, mem_component)
                : NULL);
       m_master->m_prefetcher = Prefetcher::createPrefetcher(cache_params.prefetcher, cache_params.configName, m_core_id, m_shared_cores);
+      if (m_master->m_prefetcher && Sim()->getCheckpointManager())
+         Sim()->getCheckpointManager()->registerObject(name + "-prefetcher", m_core_id, m_master->m_prefetcher);
 
       if (Sim()->getCfg()->getBoolDefault("perf_model/" + cache_params.configName + "/atd/enabled", false))
       {
@@ -193,7 +219,29 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
                CacheBase::parseAddressHash(cache_params.hash_function));
       }
 
+      if (Sim()->getCfg()->getBoolDefault("perf_model/" + cache_params.configName + "/sweep/enabled", false))
+      {
+         m_master->m_sweep = new CacheSweep(name,
+               "perf_model/" + cache_params.configName,
+               m_core_id,
+               m_cache_block_size,
+               cache_params.replacement_policy,
+               CacheBase::parseAddressHash(cache_params.hash_function));
+      }
+
       Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __walkUsageBits, (UInt64)this, HooksManager::ORDER_NOTIFY_PRE);
+
+      // Lock contention is only of interest when several cores share this cache
+      if (m_shared_cores > 1)
+      {
+         for(UInt32 i = 0; i < num_shards; ++i)
+         {
+            ShardLock &lock = m_master->m_shards[i].lock;
+            registerStatsMetric(name, core_id, "lock-acquires-shard" + itostr(i), &lock.acquires);
+            registerStatsMetric(name, core_id, "lock-contended-shard" + itostr(i), &lock.contended);
+            registerStatsMetric(name, core_id, "lock-wait-shard" + itostr(i), &lock.wait_time);
+         }
+      }
    }
    else
    {
@@ -201,6 +249,9 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
       m_master = getMemoryManager()->getCacheCntlrAt(m_core_id_master, mem_component)->m_master;
    }
 
+   if (mem_component == MemComponent::L1_ICACHE || mem_component == MemComponent::L1_DCACHE)
+      m_fast_hit_path = Sim()->getCfg()->getBoolArray("perf_model/" + cache_params.configName + "/fast_hit_path", core_id);
+
    if (m_master->m_prefetcher) {
       m_prefetch_on_prefetch_hit = Sim()->getCfg()->getBoolArray("perf_model/" + cache_params.configName + "/prefetcher/prefetch_on_prefetch_hit", core_id);
       if (Sim()->getCfg()->hasKey("perf_model/" + cache_params.configName + "/prefetcher/train_prefetcher_on_hit", core_id)) {
@@ -332,6 +383,13 @@ CacheCntlr::processMemOpFromCore(
       bool modeled,
       bool count)
 {
+   SelfProfile::Scope profile(SelfProfile::CACHE);
+
+   // Hits in a private L1 do not need any of the locks below, see processMemOpFromCoreFast()
+   if (lock_signal == Core::NONE && fastHitPathEnabled()
+       && processMemOpFromCoreFast(mem_op_type, ca_address, offset, data_buf, data_length, modeled, count))
+      return HitWhere::where_t(m_mem_component);
+
    HitWhere::where_t hit_where = HitWhere::MISS;
 
    // Protect against concurrent access from sibling SMT threads
@@ -384,13 +442,13 @@ LOG_ASSERT_ERROR(offset + data_length <= getCacheBlockSize(), "access until %u >
    else if (cache_hit && m_passthrough)
    {
       cache_hit = false;
-      cache_block_info->invalidate();
+      m_master->m_cache->invalidateSingleLine(ca_address);
       cache_block_info = NULL;
    }
 
    if (count)
    {
-      ScopedLock sl(getLock());
+      ScopedLock sl(getShardLock(ca_address));
       // Update the Cache Counters
       getCache()->updateCounters(cache_hit);
       updateCounters(mem_op_type, ca_address, cache_hit, getCacheState(cache_block_info), Prefetch::NONE);
@@ -434,13 +492,14 @@ MYLOG("L1 hit");
 
       if (modeled)
       {
-         ScopedLock sl(getLock());
+         CacheShard &shard = m_master->getShard(ca_address);
+         ScopedLock sl(shard.lock);
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(ca_address)
-            && (m_master->mshr[ca_address].t_issue < t_now && m_master->mshr[ca_address].t_complete > t_now))
+         if (shard.mshr.count(ca_address)
+            && (shard.mshr[ca_address].t_issue < t_now && shard.mshr[ca_address].t_complete > t_now))
          {
-            SubsecondTime latency = m_master->mshr[ca_address].t_complete - t_now;
+            SubsecondTime latency = shard.mshr[ca_address].t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
          }
@@ -610,16 +669,110 @@ MYLOG("access done");
    return hit_where;
 }
 
+bool
+CacheCntlr::fastHitPathEnabled()
+{
+   if (!m_fast_hit_path_checked)
+   {
+      // The fast path relies on no other thread touching this cache without holding its set lock exclusively.
+      // This rules out SMT siblings, and anything that updates the L1 MSHR or prefetch queues from another thread.
+      bool eligible = isFirstLevel() && m_shared_cores == 1 && m_next_cache_cntlr
+         && !m_perfect && !m_passthrough && !m_cache_writethrough;
+      // Without prefetchers, the prefetch queues that processMemOpFromCore() drains on every access stay empty
+      for(CacheCntlr *cntlr = this; cntlr; cntlr = cntlr->m_next_cache_cntlr)
+         if (cntlr->m_master->m_prefetcher)
+            eligible = false;
+
+      m_fast_hit_path = m_fast_hit_path && eligible;
+      m_fast_hit_path_checked = true;
+   }
+
+   return m_fast_hit_path
+      && !Sim()->getConfig()->hasCacheEfficiencyCallbacks()
+      && !Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_access_func;
+}
+
+// Lock-free version of the hit path of processMemOpFromCore(), with the same effect on timing and statistics.
+// Instead of taking the set lock, announce ourselves to it so coherence actions from other threads, which hold the
+// set lock exclusively, wait for us. Returns false, without side effects, when the slow path needs to be taken.
+bool
+CacheCntlr::processMemOpFromCoreFast(
+      Core::mem_op_t mem_op_type,
+      IntPtr ca_address, UInt32 offset,
+      Byte* data_buf, UInt32 data_length,
+      bool modeled,
+      bool count)
+{
+   SetLock *setlock = lastLevelCache()->m_master->getSetLock(ca_address);
+   if (!setlock->try_acquire_optimistic(m_core_id))
+      return false;
+
+   CacheBlockInfo *cache_block_info;
+   if (!operationPermissibleinCache(ca_address, mem_op_type, &cache_block_info)
+       || cache_block_info->hasOption(CacheBlockInfo::WARMUP) || cache_block_info->hasOption(CacheBlockInfo::PREFETCH))
+   {
+      setlock->release_optimistic(m_core_id);
+      return false;
+   }
+
+   HitWhere::where_t hit_where = HitWhere::where_t(m_mem_component);
+   #ifdef TRACK_LATENCY_BY_HITWHERE
+   SubsecondTime t_start = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+   #endif
+
+   if (count)
+   {
+      getCache()->updateCounters(true);
+      updateCounters(mem_op_type, ca_address, true, getCacheState(cache_block_info), Prefetch::NONE);
+   }
+
+   getMemoryManager()->incrElapsedTime(m_mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS, ShmemPerfModel::_USER_THREAD);
+
+   if (modeled && m_l1_mshr)
+   {
+      SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+      SubsecondTime t_completed = m_master->m_l1_mshr.getTagCompletionTime(ca_address);
+      if (t_completed != SubsecondTime::MaxTime() && t_completed > t_now)
+      {
+         if (mem_op_type == Core::WRITE)
+            ++stats.store_overlapping_misses;
+         else
+            ++stats.load_overlapping_misses;
+
+         getShmemPerfModel()->incrElapsedTime(t_completed - t_now, ShmemPerfModel::_USER_THREAD);
+      }
+   }
+   // The MSHR is only filled for an L1 with a prefetcher or without a next level, so there is no delay to apply
+
+   accessCache(mem_op_type, ca_address, offset, data_buf, data_length, count);
+
+   setlock->release_optimistic(m_core_id);
+
+   #ifdef TRACK_LATENCY_BY_HITWHERE
+   if (count)
+      lat_by_where[hit_where].update((getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD) - t_start).getNS());
+   #endif
+
+   if (mem_op_type == Core::WRITE)
+      stats.stores_where[hit_where]++;
+   else
+      stats.loads_where[hit_where]++;
+
+   return true;
+}
 
 void
 CacheCntlr::updateHits(Core::mem_op_t mem_op_type, UInt64 hits)
 {
-   ScopedLock sl(getLock());
+   // Hits are reported without their addresses and are accounted to address 0,
+   // the only per-address state updateCounters() touches is in the shard that holds it
+   const IntPtr address = 0;
+   ScopedLock sl(getShardLock(address));
 
    while(hits > 0)
    {
       getCache()->updateCounters(true);
-      updateCounters(mem_op_type, 0, true, mem_op_type == Core::READ ? CacheState::SHARED : CacheState::MODIFIED, Prefetch::NONE);
+      updateCounters(mem_op_type, address, true, mem_op_type == Core::READ ? CacheState::SHARED : CacheState::MODIFIED, Prefetch::NONE);
       hits--;
    }
 }
@@ -668,7 +821,7 @@ MYLOG("copyDataFromNextLevel l%d", m_mem_component);
 void
 CacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue)
 {
-   ScopedLock sl(getLock());
+   ScopedLock sl(m_master->m_prefetch_lock);
 
    std::vector<IntPtr> prefetchList;
 
@@ -698,6 +851,7 @@ CacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, b
             m_master->m_prefetch_list.push_back(*it);
          }
       }
+      __atomic_store_n(&m_master->m_prefetch_queued, m_master->m_prefetch_list.size(), __ATOMIC_RELAXED);
    }
 }
 
@@ -706,8 +860,11 @@ CacheCntlr::Prefetch(SubsecondTime t_now)
 {
    IntPtr address_to_prefetch = INVALID_ADDRESS;
    //IntPtr addresses_to_prefetch[32];
+   // Most calls find an empty queue, or no prefetcher at all: skip those without taking a lock,
+   // as every core sharing this cache comes through here on each of its misses
+   if (m_master->m_prefetcher && __atomic_load_n(&m_master->m_prefetch_queued, __ATOMIC_RELAXED))
    {
-      ScopedLock sl(getLock());
+      ScopedLock sl(m_master->m_prefetch_lock);
 
       if (m_master->m_prefetch_next <= t_now)
       {
@@ -725,6 +882,7 @@ CacheCntlr::Prefetch(SubsecondTime t_now)
                break;
             }
          }
+         __atomic_store_n(&m_master->m_prefetch_queued, m_master->m_prefetch_list.size(), __ATOMIC_RELAXED);
       }
    }
 
@@ -806,14 +964,14 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
    {
       // Passthrough == false: cache that always misses (except in the L1 fill path, detected by count==false, where it should return the data)
       cache_hit = first_hit = false;
-      cache_block_info->invalidate();
+      m_master->m_cache->invalidateSingleLine(address);
       cache_block_info = NULL;
       LOG_ASSERT_ERROR(m_next_cache_cntlr != NULL, "Cannot do passthrough on an LLC");
    }
 
    if (count)
    {
-      ScopedLock sl(getLock());
+      ScopedLock sl(getShardLock(address));
       if (isPrefetch == Prefetch::NONE)
          getCache()->updateCounters(cache_hit);
       updateCounters(mem_op_type, address, cache_hit, getCacheState(address), isPrefetch);
@@ -841,13 +999,14 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
          of the previous-level cache, not our (longer) access time */
       if (modeled)
       {
-         ScopedLock sl(getLock());
+         CacheShard &shard = m_master->getShard(address);
+         ScopedLock sl(shard.lock);
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(address)
-            && (m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now))
+         if (shard.mshr.count(address)
+            && (shard.mshr[address].t_issue < t_now && shard.mshr[address].t_complete > t_now))
          {
-            SubsecondTime latency = m_master->mshr[address].t_complete - t_now;
+            SubsecondTime latency = shard.mshr[address].t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
          }
@@ -1023,9 +1182,9 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
       /* Store completion time so we can detect overlapping accesses */
       if (modeled && !first_hit && !m_passthrough)
       {
-         ScopedLock sl(getLock());
-         m_master->mshr[address] = make_mshr(t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
-         cleanupMshr();
+         ScopedLock sl(getShardLock(address));
+         m_master->getShard(address).mshr[address] = make_mshr(t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
+         cleanupMshr(address);
       }
    }
 
@@ -1157,10 +1316,11 @@ CacheCntlr::initiateDirectoryAccess(Core::mem_op_t mem_op_type, IntPtr address,
 
    bool first = false;
    {
-      ScopedLock sl(getLock());
+      CacheShard &shard = m_master->getShard(address);
+      ScopedLock sl(shard.lock);
       CacheDirectoryWaiter* request = new CacheDirectoryWaiter(exclusive, isPrefetch, this, t_issue);
-      m_master->m_directory_waiters.enqueue(address, request);
-      if (m_master->m_directory_waiters.size(address) == 1)
+      shard.directory_waiters.enqueue(address, request);
+      if (shard.directory_waiters.size(address) == 1)
          first = true;
    }
 
@@ -1189,7 +1349,7 @@ CacheCntlr::initiateDirectoryAccess(Core::mem_op_t mem_op_type, IntPtr address,
    else
    {
       // Someone else is busy with this cache line, they'll do everything for us
-      MYLOG("%u previous waiters", m_master->m_directory_waiters.size(address));
+      MYLOG("%u previous waiters", m_master->getShard(address).directory_waiters.size(address));
    }
 }
 
@@ -1422,7 +1582,6 @@ MYLOG("evicting @%lx", evict_address);
       CacheState::cstate_t old_state = evict_block_info.getCState();
       MYLOG("evicting @%lx (state %c)", evict_address, CStateString(old_state));
       {
-         ScopedLock sl(getLock());
          transition(
             evict_address,
             Transition::EVICT,
@@ -1430,12 +1589,13 @@ MYLOG("evicting @%lx", evict_address);
             CacheState::INVALID
          );
 
-         ++stats.evict[old_state];
+         // Evictions can happen from several threads at once, each holding only its own set's lock
+         __sync_fetch_and_add(&stats.evict[old_state], 1);
          // Line was prefetched, but is evicted without ever being used
          if (evict_block_info.hasOption(CacheBlockInfo::PREFETCH))
-            ++stats.evict_prefetch;
+            __sync_fetch_and_add(&stats.evict_prefetch, 1);
          if (evict_block_info.hasOption(CacheBlockInfo::WARMUP))
-            ++stats.evict_warmup;
+            __sync_fetch_and_add(&stats.evict_warmup, 1);
       }
 
       /* TODO: this part looks a lot like updateCacheBlock's dirty case, but with the eviction buffer
@@ -1595,33 +1755,33 @@ CacheCntlr::updateCacheBlock(IntPtr address, CacheState::cstate_t new_cstate, Tr
    else
    {
       {
-         ScopedLock sl(getLock());
          transition(
             address,
             reason,
             getCacheState(address),
             new_cstate
          );
+         // As with evictions, coherency actions on different sets can run concurrently
          if (reason == Transition::COHERENCY)
          {
             if (new_cstate == CacheState::SHARED)
-               ++stats.coherency_downgrades;
+               __sync_fetch_and_add(&stats.coherency_downgrades, 1);
             else if (cache_block_info->getCState() == CacheState::MODIFIED)
-               ++stats.coherency_writebacks;
+               __sync_fetch_and_add(&stats.coherency_writebacks, 1);
             else
-               ++stats.coherency_invalidates;
+               __sync_fetch_and_add(&stats.coherency_invalidates, 1);
             if (cache_block_info->hasOption(CacheBlockInfo::PREFETCH) && new_cstate == CacheState::INVALID)
-               ++stats.invalidate_prefetch;
+               __sync_fetch_and_add(&stats.invalidate_prefetch, 1);
             if (cache_block_info->hasOption(CacheBlockInfo::WARMUP) && new_cstate == CacheState::INVALID)
-               ++stats.invalidate_warmup;
+               __sync_fetch_and_add(&stats.invalidate_warmup, 1);
          }
          if (reason == Transition::UPGRADE)
          {
-            ++stats.coherency_upgrades;
+            __sync_fetch_and_add(&stats.coherency_upgrades, 1);
          }
          else if (reason == Transition::BACK_INVAL)
          {
-            ++stats.backinval[cache_block_info->getCState()];
+            __sync_fetch_and_add(&stats.backinval[cache_block_info->getCState()], 1);
          }
       }
 
@@ -1778,8 +1938,9 @@ CacheCntlr::handleMsgFromDramDirectory(
    if ((shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::EX_REP) || (shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::SH_REP)
          || (shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::UPGRADE_REP) )
    {
-      ScopedLock sl(getLock()); // Keep lock when handling m_directory_waiters
-      CacheDirectoryWaiter* request = m_master->m_directory_waiters.front(address);
+      CacheShard &shard = m_master->getShard(address);
+      ScopedLock sl(shard.lock); // Keep lock when handling directory_waiters
+      CacheDirectoryWaiter* request = shard.directory_waiters.front(address);
       requester = request->cache_cntlr->m_core_id;
    }
 
@@ -1820,10 +1981,11 @@ MYLOG("WB REQ<%u @ %lx", sender, address);
    if ((shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::EX_REP) || (shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::SH_REP)
          || (shmem_msg_type == PrL1PrL2DramDirectoryMSI::ShmemMsg::UPGRADE_REP) )
    {
-      getLock().acquire(); // Keep lock when handling m_directory_waiters
-      while(! m_master->m_directory_waiters.empty(address)) {
-         CacheDirectoryWaiter* request = m_master->m_directory_waiters.front(address);
-         getLock().release();
+      CacheShard &shard = m_master->getShard(address);
+      shard.lock.acquire(); // Keep lock when handling directory_waiters
+      while(! shard.directory_waiters.empty(address)) {
+         CacheDirectoryWaiter* request = shard.directory_waiters.front(address);
+         shard.lock.release();
 
          request->cache_cntlr->m_shmem_perf->updateTime(getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD), ShmemPerf::PENDING_HIT);
 
@@ -1864,17 +2026,17 @@ MYLOG("wakeup user #%u", request->cache_cntlr->m_core_id);
          acquireStackLock(address);
 
          {
-            ScopedLock sl(request->cache_cntlr->getLock());
-            request->cache_cntlr->m_master->mshr[address] = make_mshr(request->t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD));
-            cleanupMshr();
+            ScopedLock sl(shard.lock);
+            shard.mshr[address] = make_mshr(request->t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD));
+            cleanupMshr(address);
          }
 
-         getLock().acquire();
-         MYLOG("about to dequeue request (%p) for address %lx", m_master->m_directory_waiters.front(address), address );
-         m_master->m_directory_waiters.dequeue(address);
+         shard.lock.acquire();
+         MYLOG("about to dequeue request (%p) for address %lx", shard.directory_waiters.front(address), address );
+         shard.directory_waiters.dequeue(address);
          delete request;
       }
-      getLock().release();
+      shard.lock.release();
 MYLOG("woke up all");
    }
 
@@ -2073,11 +2235,14 @@ CacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cach
       operationPermissibleinCache() will think it's a hit (so cache_hit == true) since the processing
       of the previous miss was done instantaneously. But mshr[address] contains its completion time */
    SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-   bool overlapping = m_master->mshr.count(address) && m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now;
+   Mshr &mshr = m_master->getShard(address).mshr;
+   bool overlapping = mshr.count(address) && mshr[address].t_issue < t_now && mshr[address].t_complete > t_now;
 
    // ATD doesn't track state, so when reporting hit/miss to it we shouldn't either (i.e. write hit to shared line becomes hit, not miss)
    bool cache_data_hit = (state != CacheState::INVALID);
    m_master->accessATDs(mem_op_type, cache_data_hit, address, m_core_id - m_core_id_master);
+   if (m_master->m_sweep)
+      m_master->m_sweep->access(address);
 
    if (mem_op_type == Core::WRITE)
    {
@@ -2110,7 +2275,7 @@ CacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cach
       }
    }
 
-   cleanupMshr();
+   cleanupMshr(address);
 
    #ifdef ENABLE_TRANSITIONS
    transition(
@@ -2123,19 +2288,20 @@ CacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cach
 }
 
 void
-CacheCntlr::cleanupMshr()
+CacheCntlr::cleanupMshr(IntPtr address)
 {
-   /* Keep only last 8 MSHR entries */
-   while(m_master->mshr.size() > 8) {
+   /* Keep only last 8 MSHR entries (per shard) */
+   Mshr &mshr = m_master->getShard(address).mshr;
+   while(mshr.size() > 8) {
       IntPtr address_min = 0;
       SubsecondTime time_min = SubsecondTime::MaxTime();
-      for(Mshr::iterator it = m_master->mshr.begin(); it != m_master->mshr.end(); ++it) {
+      for(Mshr::iterator it = mshr.begin(); it != mshr.end(); ++it) {
          if (it->second.t_complete < time_min) {
             address_min = it->first;
             time_min = it->second.t_complete;
          }
       }
-      m_master->mshr.erase(address_min);
+      mshr.erase(address_min);
    }
 }
 
@@ -2143,6 +2309,7 @@ void
 CacheCntlr::transition(IntPtr address, Transition::reason_t reason, CacheState::cstate_t old_state, CacheState::cstate_t new_state)
 {
 #ifdef ENABLE_TRANSITIONS
+   ScopedLock sl(m_transitions_lock);
    stats.transitions[old_state][new_state]++;
    if (old_state == CacheState::INVALID) {
       if (stats.seen.count(address) == 0)
@@ -2199,8 +2366,11 @@ CacheCntlr::updateUncoreStatistics(HitWhere::where_t hit_where, SubsecondTime no
    - (On Nehalem, the L2 is private so it is only the L3 (the first level with m_sharing_cores > 1) that takes the exclusive lock).
    #endif
 
-   Additionally, for per-cache objects that are not private to a cache set, each cache controller has its own (normal) lock,
-   use getLock() for this. This is required for statistics updates, the directory waiters queue, etc.
+   Additionally, per-cache objects that are not private to a cache set are protected by normal locks in the master controller:
+   - Per-address state (the MSHR map, the directory waiters queue) lives in shards, use getShardLock(address).
+   - The prefetcher and its queue of pending prefetches use m_prefetch_lock.
+   - Remaining cache-wide state (DRAM access, eviction buffer, L1 MSHR bandwidth) and the latency statistics use getLock().
+   Statistics counters that can be updated while holding different shard locks use atomic adds.
 */
 
 void
@@ -17,11 +17,13 @@
 #include "stats.h"
 #include "subsecond_time.h"
 #include "shmem_perf.h"
+#include "utils.h"
 
 #include "boost/tuple/tuple.hpp"
 
 class DramCntlrInterface;
 class ATD;
+class CacheSweep;
 
 /* Enable to get a detailed count of state transitions */
 //#define ENABLE_TRANSITIONS
@@ -146,51 +148,87 @@ namespace ParametricDramDirectoryMSI
    };
    typedef std::unordered_map<IntPtr, MshrEntry> Mshr;
 
+   // Mutex that keeps track of how often, and for how long (in host time), threads had to wait for it
+   class ShardLock : public BaseLock
+   {
+      public:
+         ShardLock() : acquires(0), contended(0), wait_time(SubsecondTime::Zero()) { pthread_mutex_init(&m_mutex, NULL); }
+         void acquire();
+         void release() { pthread_mutex_unlock(&m_mutex); }
+         void acquire_read() { acquire(); }
+         void release_read() { release(); }
+
+         UInt64 acquires, contended;
+         SubsecondTime wait_time;
+      private:
+         pthread_mutex_t m_mutex;
+   };
+
+   // Address-indexed state of a cache. Sets are spread round-robin over the shards, so requests
+   // from cores sharing the cache only serialize when they go to sets in the same shard.
+   struct CacheShard
+   {
+      ShardLock lock;
+      Mshr mshr;
+      CacheDirectoryWaiterMap directory_waiters;
+   } __attribute__ ((aligned (64)));
+
    class CacheMasterCntlr
    {
       private:
          Cache* m_cache;
-         Lock m_cache_lock;
+         Lock m_cache_lock;   //< Protects state that is not per address: prefetcher, DRAM, eviction and MSHR bandwidth
          Lock m_smt_lock; //< Only used in L1 cache, to protect against concurrent access from sibling SMT threads
          CacheCntlrList m_prev_cache_cntlrs;
          Prefetcher* m_prefetcher;
          DramCntlrInterface* m_dram_cntlr;
          ContentionModel* m_dram_outstanding_writebacks;
 
-         Mshr mshr;
+         std::vector<CacheShard> m_shards;
+         UInt32 m_shard_shift;
+         IntPtr m_shard_mask;
+
          ContentionModel m_l1_mshr;
          ContentionModel m_next_level_read_bandwidth;
-         CacheDirectoryWaiterMap m_directory_waiters;
          IntPtr m_evicting_address;
          Byte* m_evicting_buf;
 
          std::vector<ATD*> m_atds;
+         CacheSweep *m_sweep;
 
          std::vector<SetLock> m_setlocks;
          UInt32 m_log_blocksize;
          UInt32 m_num_sets;
 
+         Lock m_prefetch_lock;   //< Protects the prefetcher, m_prefetch_list and m_prefetch_next
          std::deque<IntPtr> m_prefetch_list;
+         UInt32 m_prefetch_queued;  //< Size of m_prefetch_list, read without m_prefetch_lock to skip an empty queue
          SubsecondTime m_prefetch_next;
 
          void createSetLocks(UInt32 cache_block_size, UInt32 num_sets, UInt32 core_offset, UInt32 num_cores);
          SetLock* getSetLock(IntPtr addr);
+         CacheShard& getShard(IntPtr addr) { return m_shards[(addr >> m_shard_shift) & m_shard_mask]; }
 
          void createATDs(String name, String configName, core_id_t core_id, UInt32 shared_cores, UInt32 size, UInt32 associativity, UInt32 block_size,
             String replacement_policy, CacheBase::hash_t hash_function);
          void accessATDs(Core::mem_op_t mem_op_type, bool hit, IntPtr address, UInt32 core_num);
 
-         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses)
+         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses, UInt32 cache_block_size, UInt32 num_shards)
             : m_cache(NULL)
             , m_prefetcher(NULL)
             , m_dram_cntlr(NULL)
             , m_dram_outstanding_writebacks(NULL)
+            , m_shards(num_shards)
+            , m_shard_shift(floorLog2(cache_block_size))
+            , m_shard_mask(num_shards - 1)
             , m_l1_mshr(name + ".mshr", core_id, outstanding_misses)
             , m_next_level_read_bandwidth(name + ".next_read", core_id)
             , m_evicting_address(0)
             , m_evicting_buf(NULL)
             , m_atds()
+            , m_sweep(NULL)
             , m_prefetch_list()
+            , m_prefetch_queued(0)
             , m_prefetch_next(SubsecondTime::Zero())
          {}
          ~CacheMasterCntlr();
@@ -216,6 +254,8 @@ namespace ParametricDramDirectoryMSI
          bool m_train_prefetcher_on_hit;
          bool m_prefetch_delay;
          bool m_l1_mshr;
+         bool m_fast_hit_path;
+         bool m_fast_hit_path_checked;
 
          struct {
            UInt64 loads, stores;
@@ -247,12 +287,15 @@ namespace ParametricDramDirectoryMSI
            std::unordered_map<IntPtr, Transition::reason_t> seen;
            #endif
          } stats;
+         #ifdef ENABLE_TRANSITIONS
+         Lock m_transitions_lock;   //< Transitions are recorded by threads holding different shard locks
+         #endif
          #ifdef TRACK_LATENCY_BY_HITWHERE
          std::unordered_map<HitWhere::where_t, StatHist> lat_by_where;
          #endif
 
          void updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cache_hit, CacheState::cstate_t state, Prefetch::prefetch_type_t isPrefetch);
-         void cleanupMshr();
+         void cleanupMshr(IntPtr address);
          void transition(IntPtr address, Transition::reason_t reason, CacheState::cstate_t old_state, CacheState::cstate_t new_state);
          void updateUncoreStatistics(HitWhere::where_t hit_where, SubsecondTime now);
 
@@ -284,6 +327,13 @@ namespace ParametricDramDirectoryMSI
                Byte* data_buf, UInt32 data_length, bool update_replacement);
          bool operationPermissibleinCache(
                IntPtr address, Core::mem_op_t mem_op_type, CacheBlockInfo **cache_block_info = NULL);
+         bool fastHitPathEnabled(void);
+         bool processMemOpFromCoreFast(
+               Core::mem_op_t mem_op_type,
+               IntPtr ca_address, UInt32 offset,
+               Byte* data_buf, UInt32 data_length,
+               bool modeled,
+               bool count);
 
          void copyDataFromNextLevel(Core::mem_op_t mem_op_type, IntPtr address, bool modeled, SubsecondTime t_start);
          void trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue);
@@ -368,6 +418,7 @@ namespace ParametricDramDirectoryMSI
 
          Cache* getCache() { return m_master->m_cache; }
          Lock& getLock() { return m_master->m_cache_lock; }
+         ShardLock& getShardLock(IntPtr address) { return m_master->getShard(address).lock; }
 
          void setPrevCacheCntlrs(CacheCntlrList& prev_cache_cntlrs);
          void setNextCacheCntlr(CacheCntlr* next_cache_cntlr) { m_next_cache_cntlr = next_cache_cntlr; }
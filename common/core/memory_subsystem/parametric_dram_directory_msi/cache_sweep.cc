@@ -0,0 +1,215 @@
+#include "cache_sweep.h"
+#include "cache_set.h"
+#include "pr_l1_cache_block_info.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "stats.h"
+#include "config.hpp"
+#include "itostr.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+CacheSweep::CacheSweep(String name, String configName, core_id_t core_id, UInt32 cache_block_size,
+                       String replacement_policy, CacheBase::hash_t hash_function)
+   : m_accesses(0)
+{
+   // A single, quoted string: an unquoted comma-separated value would be taken as a per-core array
+   parseCandidates(name, Sim()->getCfg()->getString(configName + "/sweep/candidates"),
+                   replacement_policy, cache_block_size);
+
+   for(UInt32 idx = 0; idx < m_candidates.size(); ++idx)
+   {
+      Candidate &candidate = m_candidates[idx];
+
+      if (candidate.policy == "lru")
+      {
+         // Share a recency stack with the other LRU candidates that index the same sets
+         StackGroup *group = NULL;
+         for(std::vector<StackGroup*>::iterator it = m_groups.begin(); it != m_groups.end(); ++it)
+         {
+            if ((*it)->cache_base->getNumSets() == candidate.num_sets)
+               group = *it;
+         }
+         if (!group)
+         {
+            group = new StackGroup();
+            group->cache_base = new CacheBase(name + ".sweep", candidate.num_sets, candidate.associativity, cache_block_size, hash_function);
+            group->depth = 0;
+            m_groups.push_back(group);
+         }
+         group->depth = std::max(group->depth, candidate.associativity);
+         group->candidates.push_back(idx);
+      }
+      else
+      {
+         ShadowArray *shadow = new ShadowArray();
+         String shadow_name = name + ".sweep-" + candidate.label;
+         shadow->cache_base = new CacheBase(shadow_name, candidate.num_sets, candidate.associativity, cache_block_size, hash_function);
+         shadow->set_info = CacheSet::createCacheSetInfo(shadow_name, configName, core_id, candidate.policy, candidate.associativity);
+         for(UInt32 set_index = 0; set_index < candidate.num_sets; ++set_index)
+            shadow->sets.push_back(CacheSet::createCacheSet(configName, core_id, candidate.policy, CacheBase::PR_L1_CACHE, candidate.associativity, 0, shadow->set_info));
+         shadow->candidate = idx;
+         m_shadows.push_back(shadow);
+      }
+
+      registerStatsMetric(name + ".sweep", core_id, "hits-" + candidate.label, &candidate.hits);
+      registerStatsMetric(name + ".sweep", core_id, "misses-" + candidate.label, &candidate.misses);
+   }
+
+   for(std::vector<StackGroup*>::iterator it = m_groups.begin(); it != m_groups.end(); ++it)
+   {
+      StackGroup *group = *it;
+      group->tags.resize(group->cache_base->getNumSets() * group->depth, 0);
+      group->fill.resize(group->cache_base->getNumSets(), 0);
+      group->hits_at_depth.resize(group->depth, 0);
+   }
+
+   registerStatsMetric(name + ".sweep", core_id, "accesses", &m_accesses);
+
+   if (m_groups.size())
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, hook_update, (UInt64)this, HooksManager::ORDER_NOTIFY_PRE);
+}
+
+CacheSweep::~CacheSweep()
+{
+   for(std::vector<StackGroup*>::iterator it = m_groups.begin(); it != m_groups.end(); ++it)
+   {
+      delete (*it)->cache_base;
+      delete *it;
+   }
+   for(std::vector<ShadowArray*>::iterator it = m_shadows.begin(); it != m_shadows.end(); ++it)
+   {
+      for(std::vector<CacheSet*>::iterator jt = (*it)->sets.begin(); jt != (*it)->sets.end(); ++jt)
+         delete *jt;
+      if ((*it)->set_info)
+         delete (*it)->set_info;
+      delete (*it)->cache_base;
+      delete *it;
+   }
+}
+
+void
+CacheSweep::parseCandidates(String name, String candidates, String default_policy, UInt32 cache_block_size)
+{
+   // Space-separated list of <size in KB>:<associativity>[:<replacement policy>]
+   size_t i = 0;
+   while(i < candidates.size())
+   {
+      if (candidates[i] == ' ' || candidates[i] == '\t')
+      {
+         ++i;
+         continue;
+      }
+      size_t position = candidates.find_first_of(" \t", i);
+      String item = candidates.substr(i, position == String::npos ? String::npos : position - i);
+      i = position == String::npos ? candidates.size() : position;
+
+      Candidate candidate;
+      size_t first = item.find(':');
+      LOG_ASSERT_ERROR(first != String::npos, "%s: sweep candidate '%s' should be <size>:<associativity>[:<policy>]", name.c_str(), item.c_str());
+      size_t second = item.find(':', first + 1);
+      candidate.size = atoi(item.substr(0, first).c_str());
+      candidate.associativity = atoi(item.substr(first + 1, second == String::npos ? String::npos : second - first - 1).c_str());
+      candidate.policy = second == String::npos ? default_policy : item.substr(second + 1);
+      candidate.hits = 0;
+      candidate.misses = 0;
+
+      LOG_ASSERT_ERROR(candidate.size > 0 && candidate.associativity > 0,
+                       "%s: invalid sweep candidate '%s'", name.c_str(), item.c_str());
+      UInt64 num_lines = UInt64(candidate.size) * k_KILO / cache_block_size;
+      LOG_ASSERT_ERROR(num_lines % candidate.associativity == 0 && num_lines >= candidate.associativity,
+                       "%s: sweep candidate '%s' does not have a whole number of sets", name.c_str(), item.c_str());
+      candidate.num_sets = num_lines / candidate.associativity;
+      // Rejects unknown policies with an error
+      CacheSet::parsePolicyType(candidate.policy);
+
+      candidate.label = itostr(candidate.size) + "kB-" + itostr(candidate.associativity) + "way-" + candidate.policy;
+      for(std::vector<Candidate>::iterator it = m_candidates.begin(); it != m_candidates.end(); ++it)
+         LOG_ASSERT_ERROR(it->label != candidate.label, "%s: sweep candidate %s is listed more than once", name.c_str(), candidate.label.c_str());
+      m_candidates.push_back(candidate);
+   }
+
+   LOG_ASSERT_ERROR(m_candidates.size() > 0, "%s: sweep is enabled but sweep/candidates is empty", name.c_str());
+}
+
+void
+CacheSweep::access(IntPtr address)
+{
+   ScopedLock sl(m_lock);
+
+   ++m_accesses;
+   for(std::vector<StackGroup*>::iterator it = m_groups.begin(); it != m_groups.end(); ++it)
+      accessStack(*it, address);
+   for(std::vector<ShadowArray*>::iterator it = m_shadows.begin(); it != m_shadows.end(); ++it)
+      accessShadow(*it, address);
+}
+
+void
+CacheSweep::accessStack(StackGroup *group, IntPtr address)
+{
+   IntPtr tag; UInt32 set_index;
+   group->cache_base->splitAddress(address, tag, set_index);
+
+   IntPtr *stack = &group->tags[set_index * group->depth];
+   UInt32 &fill = group->fill[set_index];
+
+   UInt32 depth = 0;
+   while(depth < fill && stack[depth] != tag)
+      ++depth;
+
+   if (depth < fill)
+      ++group->hits_at_depth[depth];
+   else if (fill < group->depth)
+      ++fill;           // Miss, the stack grows by one
+   else
+      depth = fill - 1; // Miss, the least recently used tag falls off
+
+   // Move to the top of the stack
+   memmove(stack + 1, stack, depth * sizeof(IntPtr));
+   stack[0] = tag;
+}
+
+void
+CacheSweep::accessShadow(ShadowArray *shadow, IntPtr address)
+{
+   IntPtr tag; UInt32 set_index;
+   shadow->cache_base->splitAddress(address, tag, set_index);
+
+   CacheSet *set = shadow->sets[set_index];
+   UInt32 line_index = -1;
+   if (set->find(tag, &line_index))
+   {
+      set->updateReplacementIndex(line_index);
+      ++m_candidates[shadow->candidate].hits;
+   }
+   else
+   {
+      PrL1CacheBlockInfo* cache_block_info = new PrL1CacheBlockInfo(tag, CacheState::MODIFIED);
+      bool eviction; PrL1CacheBlockInfo evict_block_info;
+      set->insert(cache_block_info, NULL, &eviction, &evict_block_info, NULL);
+      delete cache_block_info;
+      ++m_candidates[shadow->candidate].misses;
+   }
+}
+
+void
+CacheSweep::update()
+{
+   ScopedLock sl(m_lock);
+
+   for(std::vector<StackGroup*>::iterator it = m_groups.begin(); it != m_groups.end(); ++it)
+   {
+      StackGroup *group = *it;
+      for(std::vector<UInt32>::iterator jt = group->candidates.begin(); jt != group->candidates.end(); ++jt)
+      {
+         Candidate &candidate = m_candidates[*jt];
+         candidate.hits = 0;
+         for(UInt32 depth = 0; depth < candidate.associativity; ++depth)
+            candidate.hits += group->hits_at_depth[depth];
+         candidate.misses = m_accesses - candidate.hits;
+      }
+   }
+}
@@ -0,0 +1,72 @@
+#ifndef __CACHE_SWEEP_H
+#define __CACHE_SWEEP_H
+
+#include "fixed_types.h"
+#include "cache_base.h"
+#include "lock.h"
+
+#include <vector>
+
+class CacheSet;
+class CacheSetInfo;
+
+// Single-pass sweep over alternative geometries of one cache (perf_model/<cache>/sweep).
+// Every access seen by the cache is replayed into a list of candidate configurations (size, associativity,
+// replacement policy), and hits and misses are reported for each of them.
+// LRU candidates that have the same number of sets share one recency stack per set, as deep as the largest
+// associativity among them: an access found at depth d hits in every candidate with more than d ways.
+// Other policies do not have this inclusion property, and get a full shadow tag array each.
+class CacheSweep
+{
+   private:
+      struct Candidate
+      {
+         String label;              //< <size>kB-<associativity>way-<policy>
+         UInt32 size;               //< in KB
+         UInt32 associativity;
+         String policy;
+         UInt32 num_sets;
+         UInt64 hits, misses;
+      };
+
+      struct StackGroup
+      {
+         CacheBase *cache_base;
+         UInt32 depth;              //< Largest associativity of the candidates in this group
+         std::vector<IntPtr> tags;  //< depth entries per set, most recently used first
+         std::vector<UInt32> fill;  //< Valid entries per set
+         std::vector<UInt64> hits_at_depth;
+         std::vector<UInt32> candidates;
+      };
+
+      struct ShadowArray
+      {
+         CacheBase *cache_base;
+         CacheSetInfo *set_info;
+         std::vector<CacheSet*> sets;
+         UInt32 candidate;
+      };
+
+      Lock m_lock;                  //< A shared cache is accessed by several cores at once
+      UInt64 m_accesses;
+      std::vector<Candidate> m_candidates;
+      std::vector<StackGroup*> m_groups;
+      std::vector<ShadowArray*> m_shadows;
+
+      void parseCandidates(String name, String candidates, String default_policy, UInt32 cache_block_size);
+      void accessStack(StackGroup *group, IntPtr address);
+      void accessShadow(ShadowArray *shadow, IntPtr address);
+
+      static SInt64 hook_update(UInt64 user, UInt64 args)
+      { ((CacheSweep*)user)->update(); return 0; }
+      void update();
+
+   public:
+      CacheSweep(String name, String configName, core_id_t core_id, UInt32 cache_block_size,
+                 String replacement_policy, CacheBase::hash_t hash_function);
+      ~CacheSweep();
+
+      void access(IntPtr address);
+};
+
+#endif // __CACHE_SWEEP_H
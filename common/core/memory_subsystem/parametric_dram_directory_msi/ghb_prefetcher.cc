@@ -135,3 +135,25 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
 
    return prefetchList;
 }
+
+void
+GhbPrefetcher::saveCheckpoint(CheckpointWriter &writer)
+{
+   writer.write(m_lastAddress);
+   writer.write(m_ghbHead);
+   writer.write(m_generation);
+   writer.writeVector(m_ghb);
+   writer.write(m_tableHead);
+   writer.writeVector(m_ghbTable);
+}
+
+void
+GhbPrefetcher::loadCheckpoint(CheckpointReader &reader)
+{
+   m_lastAddress = reader.read<IntPtr>();
+   m_ghbHead = reader.read<UInt32>();
+   m_generation = reader.read<UInt32>();
+   reader.readVector(m_ghb);
+   m_tableHead = reader.read<UInt32>();
+   reader.readVector(m_ghbTable);
+}
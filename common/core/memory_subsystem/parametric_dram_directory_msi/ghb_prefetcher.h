@@ -9,6 +9,9 @@ class GhbPrefetcher : public Prefetcher
       GhbPrefetcher(String configName, core_id_t core_id);
       std::vector<IntPtr> getNextAddress(IntPtr currentAddress, core_id_t core_id);
 
+      void saveCheckpoint(CheckpointWriter &writer);
+      void loadCheckpoint(CheckpointReader &reader);
+
       ~GhbPrefetcher();
 
    private:
@@ -2,10 +2,11 @@
 #define PREFETCHER_H
 
 #include "fixed_types.h"
+#include "checkpoint.h"
 
 #include <vector>
 
-class Prefetcher
+class Prefetcher : public Checkpointable
 {
    public:
       static Prefetcher* createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores);
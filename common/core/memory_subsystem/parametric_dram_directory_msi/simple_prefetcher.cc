@@ -62,3 +62,19 @@ SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
 
    return addresses;
 }
+
+void
+SimplePrefetcher::saveCheckpoint(CheckpointWriter &writer)
+{
+   writer.write(n_flow_next);
+   for(UInt32 idx = 0; idx < m_prev_address.size(); ++idx)
+      writer.writeVector(m_prev_address[idx]);
+}
+
+void
+SimplePrefetcher::loadCheckpoint(CheckpointReader &reader)
+{
+   n_flow_next = reader.read<UInt32>();
+   for(UInt32 idx = 0; idx < m_prev_address.size(); ++idx)
+      reader.readVector(m_prev_address[idx]);
+}
@@ -9,6 +9,9 @@ class SimplePrefetcher : public Prefetcher
       SimplePrefetcher(String configName, core_id_t core_id, UInt32 shared_cores);
       virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id);
 
+      virtual void saveCheckpoint(CheckpointWriter &writer);
+      virtual void loadCheckpoint(CheckpointReader &reader);
+
    private:
       const core_id_t core_id;
       const UInt32 shared_cores;
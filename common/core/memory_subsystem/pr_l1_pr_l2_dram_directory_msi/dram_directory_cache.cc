@@ -1,6 +1,8 @@
 #include "dram_directory_cache.h"
 #include "log.h"
 #include "utils.h"
+#include "simulator.h"
+#include "checkpoint_manager.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -25,11 +27,14 @@ DramDirectoryCache::DramDirectoryCache(
 
    // Instantiate the directory
    m_directory = new Directory(core_id, directory_type_str, total_entries, max_hw_sharers, max_num_sharers);
-   m_replacement_ptrs = new UInt32[m_num_sets];
+   m_replacement_ptrs = new UInt32[m_num_sets]();
 
    // Logs
    m_log_num_sets = floorLog2(m_num_sets);
    m_log_cache_block_size = floorLog2(m_cache_block_size);
+
+   if (Sim()->getCheckpointManager())
+      Sim()->getCheckpointManager()->registerObject("dram-directory", core_id, this);
 }
 
 DramDirectoryCache::~DramDirectoryCache()
@@ -162,4 +167,69 @@ DramDirectoryCache::splitAddress(IntPtr address, IntPtr& tag, UInt32& set_index)
 
 }
 
+void
+DramDirectoryCache::saveCheckpoint(CheckpointWriter &writer)
+{
+   writer.write(m_total_entries);
+   writer.write(m_associativity);
+   writer.write(m_replacement_ptrs, m_num_sets * sizeof(UInt32));
+
+   // Only entries that hold an address are saved, so unused entries are not allocated when restoring
+   for (UInt32 i = 0; i < m_total_entries; i++)
+   {
+      DirectoryEntry* directory_entry = m_directory->peekDirectoryEntry(i);
+      if (directory_entry == NULL || directory_entry->getAddress() == INVALID_ADDRESS)
+         continue;
+
+      std::pair<bool, std::vector<core_id_t> > sharers = directory_entry->getSharersList();
+      writer.write(i);
+      writer.write(directory_entry->getAddress());
+      writer.write(directory_entry->getDirectoryBlockInfo()->getDState());
+      writer.write(directory_entry->getOwner());
+      writer.write(directory_entry->getForwarder());
+      writer.writeVector(sharers.second);
+   }
+   writer.write(m_total_entries);
+}
+
+void
+DramDirectoryCache::loadCheckpoint(CheckpointReader &reader)
+{
+   reader.readExpect(m_total_entries, "number of directory entries");
+   reader.readExpect(m_associativity, "associativity");
+   reader.read(m_replacement_ptrs, m_num_sets * sizeof(UInt32));
+
+   // Start from an empty directory
+   for (UInt32 i = 0; i < m_total_entries; i++)
+   {
+      DirectoryEntry* directory_entry = m_directory->peekDirectoryEntry(i);
+      if (directory_entry == NULL)
+         continue;
+
+      std::pair<bool, std::vector<core_id_t> > sharers = directory_entry->getSharersList();
+      for (std::vector<core_id_t>::iterator it = sharers.second.begin(); it != sharers.second.end(); ++it)
+         directory_entry->removeSharer(*it);
+      directory_entry->setAddress(INVALID_ADDRESS);
+      directory_entry->getDirectoryBlockInfo()->setDState(DirectoryState::UNCACHED);
+      directory_entry->setOwner(INVALID_CORE_ID);
+   }
+
+   for (UInt32 i = reader.read<UInt32>(); i != m_total_entries; i = reader.read<UInt32>())
+   {
+      LOG_ASSERT_ERROR(i < m_total_entries, "Invalid directory entry %u in checkpoint", i);
+      DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(i);
+
+      directory_entry->setAddress(reader.read<IntPtr>());
+      directory_entry->getDirectoryBlockInfo()->setDState(reader.read<DirectoryState::dstate_t>());
+      core_id_t owner = reader.read<core_id_t>();
+      core_id_t forwarder = reader.read<core_id_t>();
+      std::vector<core_id_t> sharers(reader.read<UInt64>());
+      reader.read(sharers.data(), sharers.size() * sizeof(core_id_t));
+      for (std::vector<core_id_t>::iterator it = sharers.begin(); it != sharers.end(); ++it)
+         directory_entry->addSharer(*it, getMaxHwSharers());
+      directory_entry->setOwner(owner);
+      directory_entry->setForwarder(forwarder);
+   }
+}
+
 }
@@ -5,10 +5,11 @@
 #include "directory.h"
 #include "shmem_perf_model.h"
 #include "subsecond_time.h"
+#include "checkpoint.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
-   class DramDirectoryCache
+   class DramDirectoryCache : public Checkpointable
    {
       private:
          Directory* m_directory;
@@ -53,5 +54,8 @@ namespace PrL1PrL2DramDirectoryMSI
          void getReplacementCandidates(IntPtr address, std::vector<DirectoryEntry*>& replacement_candidate_list);
 
          UInt32 getMaxHwSharers() const { return m_directory->getMaxHwSharers(); }
+
+         void saveCheckpoint(CheckpointWriter &writer);
+         void loadCheckpoint(CheckpointReader &reader);
    };
 }
@@ -0,0 +1,15 @@
+#include "allocator.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+bool Allocator::useThreadLocalPools()
+{
+   String type = Sim()->getCfg()->getString("general/allocator");
+   if (type == "locked")
+      return false;
+   else if (type == "thread_local")
+      return true;
+   else
+      LOG_PRINT_ERROR("Unknown allocator type %s", type.c_str());
+}
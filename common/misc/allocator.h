@@ -3,23 +3,45 @@
 
 #include "fixed_types.h"
 #include "FSBAllocator.hh"
+#include "lock.h"
 
+#include <vector>
+#include <cstddef>
 #include <typeinfo>
+#include <pthread.h>
 #include <cxxabi.h>
 
 // Pool allocator
 
 class Allocator
 {
-   private:
+   protected:
       struct DataElement
       {
           Allocator *allocator;
           char data[];
       };
+
+      static void reportLeaks(const std::type_info &type, UInt64 items)
+      {
+         if (items)
+         {
+            int status;
+            char *nameoftype = abi::__cxa_demangle(type.name(), 0, 0, &status);
+            printf("[ALLOC] %" PRIu64 " items of type %s not freed\n", items, nameoftype);
+            free(nameoftype);
+         }
+      }
+
+      // Unique identifier for each allocator, so thread-local caches can never mistake a new allocator for a deleted one
+      static UInt64 nextId() { static UInt64 s_next_id = 0; return __sync_add_and_fetch(&s_next_id, 1); }
+
    public:
       virtual ~Allocator() {}
 
+      // Which pool allocator to use for dynamic instructions and micro-ops (general/allocator)
+      static bool useThreadLocalPools();
+
       virtual void *alloc(size_t bytes) = 0;
       virtual void _dealloc(void *ptr) = 0;
 
@@ -46,13 +68,7 @@ template <typename T, unsigned MaxItems = 0> class TypedAllocator : public Alloc
 
       virtual ~TypedAllocator()
       {
-         if (m_items)
-         {
-            int status;
-            char *nameoftype = abi::__cxa_demangle(typeid(T).name(), 0, 0, &status);
-            printf("[ALLOC] %" PRIu64 " items of type %s not freed\n", m_items, nameoftype);
-            free(nameoftype);
-         }
+         reportLeaks(typeid(T), m_items);
       }
 
       virtual void* alloc(size_t bytes)
@@ -73,4 +89,149 @@ template <typename T, unsigned MaxItems = 0> class TypedAllocator : public Alloc
       }
 };
 
+// Pool allocator with a free list per thread. Allocations, and frees by the thread that made the allocation, do not take
+// a lock. Frees from other threads (in ROB-SMT, simulate() can be called by anyone) are pushed onto a lock-free stack
+// owned by the allocating thread, which takes it over as a whole once its own free list runs out.
+
+template <typename T, unsigned MaxItems = 0> class ThreadLocalAllocator : public Allocator
+{
+   private:
+      struct Heap;
+      struct Element
+      {
+         Element *next;          // Free list link
+         Heap *heap;             // Heap this element belongs to
+         Allocator *allocator;   // Same layout as the end of DataElement, as expected by Allocator::dealloc()
+      };
+      static const size_t ELEMENT_SIZE = (sizeof(Element) + sizeof(T) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+      static const size_t CHUNK_ITEMS = 512;
+      static_assert(offsetof(Element, allocator) + sizeof(Allocator*) == sizeof(Element), "Element must end with the allocator pointer");
+
+      struct Heap
+      {
+         pthread_t owner;
+         // Only used by the owning thread
+         Element *free;
+         UInt64 allocated, freed;
+         std::vector<char*> chunks;
+         char padding[64];
+         // Used by other threads
+         Element *remote_free;
+         UInt64 remote_freed;
+
+         Heap(pthread_t _owner) : owner(_owner), free(NULL), allocated(0), freed(0), remote_free(NULL), remote_freed(0) {}
+      };
+
+      const UInt64 m_id;
+      Lock m_lock;                  // Protects m_heaps
+      std::vector<Heap*> m_heaps;
+
+      // Heap of the allocator this thread used last
+      static __thread UInt64 t_cached_id;
+      static __thread Heap *t_cached_heap;
+
+      Heap *getHeap()
+      {
+         if (t_cached_id != m_id)
+         {
+            // This thread has not used this allocator before, or used another one since
+            ScopedLock sl(m_lock);
+            Heap *heap = NULL;
+            for(typename std::vector<Heap*>::iterator it = m_heaps.begin(); it != m_heaps.end(); ++it)
+               if (pthread_equal((*it)->owner, pthread_self()))
+               {
+                  heap = *it;
+                  break;
+               }
+            if (heap == NULL)
+            {
+               heap = new Heap(pthread_self());
+               m_heaps.push_back(heap);
+            }
+            t_cached_id = m_id;
+            t_cached_heap = heap;
+         }
+         return t_cached_heap;
+      }
+
+      void grow(Heap *heap)
+      {
+         char *chunk = new char[CHUNK_ITEMS * ELEMENT_SIZE];
+         heap->chunks.push_back(chunk);
+         if (MaxItems)
+            LOG_ASSERT_ERROR(heap->chunks.size() * CHUNK_ITEMS <= MaxItems, "Maximum number of items exceeded for allocator of %s", typeid(T).name());
+         for(size_t i = 0; i < CHUNK_ITEMS; ++i)
+         {
+            Element *elem = (Element*)(chunk + i * ELEMENT_SIZE);
+            elem->heap = heap;
+            elem->allocator = this;
+            elem->next = heap->free;
+            heap->free = elem;
+         }
+      }
+
+   public:
+      ThreadLocalAllocator()
+         : m_id(nextId())
+      {}
+
+      virtual ~ThreadLocalAllocator()
+      {
+         UInt64 items = 0;
+         for(typename std::vector<Heap*>::iterator it = m_heaps.begin(); it != m_heaps.end(); ++it)
+         {
+            items += (*it)->allocated - (*it)->freed - (*it)->remote_freed;
+            for(std::vector<char*>::iterator jt = (*it)->chunks.begin(); jt != (*it)->chunks.end(); ++jt)
+               delete [] *jt;
+            delete *it;
+         }
+         reportLeaks(typeid(T), items);
+      }
+
+      virtual void* alloc(size_t bytes)
+      {
+         Heap *heap = getHeap();
+         if (heap->free == NULL)
+            heap->free = __atomic_exchange_n(&heap->remote_free, (Element*)NULL, __ATOMIC_ACQUIRE);
+         if (heap->free == NULL)
+            grow(heap);
+         Element *elem = heap->free;
+         heap->free = elem->next;
+         ++heap->allocated;
+         return ((char*)elem) + sizeof(Element);
+      }
+
+      virtual void _dealloc(void* ptr)
+      {
+         // ptr points to the allocator field, at the end of our Element
+         Element *elem = (Element*)(((char*)ptr) - (sizeof(Element) - sizeof(Allocator*)));
+         Heap *heap = elem->heap;
+         if (t_cached_id == m_id && t_cached_heap == heap)
+         {
+            elem->next = heap->free;
+            heap->free = elem;
+            ++heap->freed;
+         }
+         else
+         {
+            Element *head = __atomic_load_n(&heap->remote_free, __ATOMIC_RELAXED);
+            do
+               elem->next = head;
+            while (!__atomic_compare_exchange_n(&heap->remote_free, &head, elem, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            __atomic_fetch_add(&heap->remote_freed, 1, __ATOMIC_RELAXED);
+         }
+      }
+};
+
+template <typename T, unsigned MaxItems> __thread UInt64 ThreadLocalAllocator<T, MaxItems>::t_cached_id = 0;
+template <typename T, unsigned MaxItems> __thread typename ThreadLocalAllocator<T, MaxItems>::Heap *ThreadLocalAllocator<T, MaxItems>::t_cached_heap = NULL;
+
+template <typename T, unsigned MaxItems = 0> Allocator* createTypedAllocator()
+{
+   if (Allocator::useThreadLocalPools())
+      return new ThreadLocalAllocator<T, MaxItems>();
+   else
+      return new TypedAllocator<T, MaxItems>();
+}
+
 #endif // __ALLOCATOR_H
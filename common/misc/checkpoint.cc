@@ -0,0 +1,156 @@
+#include "checkpoint.h"
+#include "log.h"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char CHECKPOINT_MAGIC[8] = { 'S', 'N', 'C', 'K', 'P', 'T', '\0', '\0' };
+static const UInt64 CHECKPOINT_VERSION = 1;
+
+CheckpointWriter::CheckpointWriter(String filename)
+   : m_filename(filename)
+   , m_fp(fopen(filename.c_str(), "wb"))
+   , m_section_start(-1)
+{
+   LOG_ASSERT_ERROR(m_fp, "Cannot create checkpoint file %s", m_filename.c_str());
+   write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+   write<UInt64>(CHECKPOINT_VERSION);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+   LOG_ASSERT_ERROR(m_section_start == -1, "Checkpoint section was not closed");
+   LOG_ASSERT_ERROR(fclose(m_fp) == 0, "Error writing checkpoint file %s", m_filename.c_str());
+}
+
+void
+CheckpointWriter::beginSection(String name)
+{
+   LOG_ASSERT_ERROR(m_section_start == -1, "Checkpoint section was not closed before starting %s", name.c_str());
+   write<UInt32>(name.size());
+   write(name.data(), name.size());
+   // Placeholder for the payload size, filled in by endSection()
+   write<UInt64>(0);
+   m_section_start = ftell(m_fp);
+}
+
+void
+CheckpointWriter::endSection()
+{
+   LOG_ASSERT_ERROR(m_section_start != -1, "No checkpoint section to close");
+   long end = ftell(m_fp);
+   UInt64 size = end - m_section_start;
+   fseek(m_fp, m_section_start - sizeof(UInt64), SEEK_SET);
+   write<UInt64>(size);
+   fseek(m_fp, end, SEEK_SET);
+   m_section_start = -1;
+}
+
+void
+CheckpointWriter::write(const void *data, size_t size)
+{
+   if (size)
+      LOG_ASSERT_ERROR(fwrite(data, size, 1, m_fp) == 1, "Error writing checkpoint file %s", m_filename.c_str());
+}
+
+void
+CheckpointWriter::writeVector(const std::vector<bool> &values)
+{
+   write<UInt64>(values.size());
+   for(std::vector<bool>::const_iterator it = values.begin(); it != values.end(); ++it)
+      write<UInt8>(*it);
+}
+
+
+CheckpointReader::CheckpointReader(String filename)
+   : m_filename(filename)
+   , m_data(NULL)
+   , m_size(0)
+   , m_pos(0)
+   , m_end(0)
+{
+   int fd = open(filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Cannot open checkpoint file %s", m_filename.c_str());
+   struct stat st;
+   LOG_ASSERT_ERROR(fstat(fd, &st) == 0, "Cannot stat checkpoint file %s", m_filename.c_str());
+   m_size = st.st_size;
+   LOG_ASSERT_ERROR(m_size >= sizeof(CHECKPOINT_MAGIC) + sizeof(UInt64), "Checkpoint file %s is truncated", m_filename.c_str());
+
+   // Map the file rather than reading it: sections are only paged in when an object asks for them
+   void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   LOG_ASSERT_ERROR(data != MAP_FAILED, "Cannot map checkpoint file %s", m_filename.c_str());
+   m_data = (const char*)data;
+
+   LOG_ASSERT_ERROR(memcmp(m_data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0, "%s is not a checkpoint file", m_filename.c_str());
+   UInt64 version;
+   memcpy(&version, m_data + sizeof(CHECKPOINT_MAGIC), sizeof(version));
+   LOG_ASSERT_ERROR(version == CHECKPOINT_VERSION, "Checkpoint file %s has version %ld, expected %ld", m_filename.c_str(), version, CHECKPOINT_VERSION);
+
+   // Build the section index
+   m_pos = sizeof(CHECKPOINT_MAGIC) + sizeof(UInt64);
+   m_end = m_size;
+   while (m_pos < m_size)
+   {
+      UInt32 length = read<UInt32>();
+      LOG_ASSERT_ERROR(m_pos + length <= m_end, "Checkpoint file %s is truncated", m_filename.c_str());
+      String name(m_data + m_pos, length);
+      m_pos += length;
+      UInt64 size = read<UInt64>();
+      LOG_ASSERT_ERROR(m_pos + size <= m_end, "Checkpoint file %s is truncated", m_filename.c_str());
+      m_sections[name] = std::make_pair(m_pos, size);
+      m_pos += size;
+   }
+   m_pos = m_end = 0;
+}
+
+CheckpointReader::~CheckpointReader()
+{
+   munmap((void*)m_data, m_size);
+}
+
+void
+CheckpointReader::beginSection(String name)
+{
+   LOG_ASSERT_ERROR(m_section.empty(), "Checkpoint section %s was not closed before starting %s", m_section.c_str(), name.c_str());
+   LOG_ASSERT_ERROR(m_sections.count(name), "Checkpoint file %s does not contain %s", m_filename.c_str(), name.c_str());
+   m_section = name;
+   m_pos = m_sections[name].first;
+   m_end = m_pos + m_sections[name].second;
+}
+
+void
+CheckpointReader::endSection()
+{
+   LOG_ASSERT_ERROR(m_pos == m_end, "Checkpoint section %s has %ld unread bytes, was it saved with a different configuration?",
+      m_section.c_str(), m_end - m_pos);
+   m_section = "";
+   m_pos = m_end = 0;
+}
+
+void
+CheckpointReader::read(void *data, size_t size)
+{
+   LOG_ASSERT_ERROR(m_pos + size <= m_end, "Reading past the end of checkpoint section %s, was it saved with a different configuration?",
+      m_section.c_str());
+   memcpy(data, m_data + m_pos, size);
+   m_pos += size;
+}
+
+void
+CheckpointReader::readVector(std::vector<bool> &values)
+{
+   readExpect<UInt64>(values.size(), "vector size");
+   for(std::vector<bool>::iterator it = values.begin(); it != values.end(); ++it)
+      *it = read<UInt8>();
+}
+
+void
+CheckpointReader::mismatch(const char *what, UInt64 value, UInt64 expected)
+{
+   LOG_PRINT_ERROR("Checkpoint section %s has %s %ld, but the current configuration has %ld",
+      m_section.c_str(), what, value, expected);
+}
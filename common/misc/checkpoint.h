@@ -0,0 +1,102 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "fixed_types.h"
+
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <type_traits>
+
+// Checkpoint file format:
+//   header:  "SNCKPT\0\0", UInt64 version
+//   section: UInt32 name length, name, UInt64 payload size, payload
+// Each object is stored in its own named section, so a reader can find any object without parsing the others,
+// and an object that reads back fewer or more bytes than were written for it is detected as a layout mismatch.
+// Objects store their own geometry (sizes, associativities, ...) and check it on load, as checkpoints can only
+// be restored into a simulation with the same configuration.
+
+class CheckpointWriter
+{
+   public:
+      CheckpointWriter(String filename);
+      ~CheckpointWriter();
+
+      void beginSection(String name);
+      void endSection();
+
+      void write(const void *data, size_t size);
+      template <typename T> void write(const T &value)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written directly");
+         write(&value, sizeof(T));
+      }
+      template <typename T> void writeVector(const std::vector<T> &values)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only vectors of trivially copyable types can be written directly");
+         write<UInt64>(values.size());
+         write(values.data(), values.size() * sizeof(T));
+      }
+      void writeVector(const std::vector<bool> &values);
+
+   private:
+      String m_filename;
+      FILE *m_fp;
+      long m_section_start;
+};
+
+class CheckpointReader
+{
+   public:
+      CheckpointReader(String filename);
+      ~CheckpointReader();
+
+      bool hasSection(String name) const { return m_sections.count(name); }
+      void beginSection(String name);
+      void endSection();
+
+      void read(void *data, size_t size);
+      template <typename T> T read()
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read directly");
+         T value;
+         read(&value, sizeof(T));
+         return value;
+      }
+      // Read a value that was stored as part of the object's geometry, and check that it matches the current configuration
+      template <typename T> void readExpect(const T &expected, const char *what)
+      {
+         T value = read<T>();
+         if (value != expected)
+            mismatch(what, (UInt64)value, (UInt64)expected);
+      }
+      template <typename T> void readVector(std::vector<T> &values)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only vectors of trivially copyable types can be read directly");
+         readExpect<UInt64>(values.size(), "vector size");
+         read(values.data(), values.size() * sizeof(T));
+      }
+      void readVector(std::vector<bool> &values);
+
+   private:
+      String m_filename;
+      const char *m_data;
+      size_t m_size;
+      std::map<String, std::pair<size_t, size_t> > m_sections;   //< name -> offset, size of the payload
+
+      String m_section;
+      size_t m_pos, m_end;
+
+      void mismatch(const char *what, UInt64 value, UInt64 expected);
+};
+
+// Interface for simulator objects whose warmed-up state can be saved into, and restored from, a checkpoint
+class Checkpointable
+{
+   public:
+      virtual ~Checkpointable() {}
+      virtual void saveCheckpoint(CheckpointWriter &writer) = 0;
+      virtual void loadCheckpoint(CheckpointReader &reader) = 0;
+};
+
+#endif // CHECKPOINT_H
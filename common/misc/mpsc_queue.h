@@ -0,0 +1,70 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "fixed_types.h"
+
+// Lock-free multi-producer, single-consumer intrusive queue (Dmitry Vyukov's algorithm).
+// T must be default-constructible and have a `T *next` member, which the queue owns while the item is queued.
+// Any thread may push(); exactly one thread may call pop(). push() is a single atomic exchange and never waits.
+// pop() can return NULL while empty() is false, for the short time between a producer's exchange and its link
+// store; the consumer should simply retry.
+template <class T> class MPSCQueue
+{
+   private:
+      T *m_head;              //< Last item pushed (producer side)
+      UInt8 padding0[64 - sizeof(T*)];
+      T *m_tail;              //< Next item to be popped (consumer-owned)
+      T m_stub;               //< Dummy item, keeps the list non-empty
+
+   public:
+      MPSCQueue()
+         : m_head(&m_stub)
+         , m_tail(&m_stub)
+      {
+         m_stub.next = NULL;
+      }
+
+      void push(T *item)
+      {
+         __atomic_store_n(&item->next, (T*)NULL, __ATOMIC_RELAXED);
+         T *prev = __atomic_exchange_n(&m_head, item, __ATOMIC_SEQ_CST);
+         __atomic_store_n(&prev->next, item, __ATOMIC_RELEASE);
+      }
+
+      T* pop()
+      {
+         T *tail = m_tail;
+         T *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+         if (tail == &m_stub)
+         {
+            if (next == NULL)
+               return NULL;
+            m_tail = next;
+            tail = next;
+            next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+         }
+         if (next)
+         {
+            m_tail = next;
+            return tail;
+         }
+         if (tail != __atomic_load_n(&m_head, __ATOMIC_ACQUIRE))
+            return NULL; // A producer is linking in a new item
+         // tail is the last item: put the stub behind it so that it can be unlinked
+         push(&m_stub);
+         next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+         if (next)
+         {
+            m_tail = next;
+            return tail;
+         }
+         return NULL;
+      }
+
+      // Consumer side: m_tail only rests on the stub once everything before it was popped, and m_head moves off the
+      // stub with every push. The load of m_head is sequentially consistent, so that it can be paired with a sleep
+      // flag (see SmTransport::SmNode::recvMessage).
+      bool empty() const { return m_tail == &m_stub && __atomic_load_n(&m_head, __ATOMIC_SEQ_CST) == &m_stub; }
+};
+
+#endif // MPSC_QUEUE_H
@@ -4,6 +4,7 @@
 _SetLock::_SetLock(UInt32 core_offset, UInt32 num_sharers)
    : m_locks(num_sharers)
    , m_core_offset(core_offset)
+   , m_exclusive(0)
 {
    #ifdef TIME_LOCKS
    _timer = TotalTimer::getTimerByStacktrace("setlock@" + itostr(this));
@@ -20,12 +21,15 @@ _SetLock::acquire_exclusive(void)
 
    for(std::vector<PersetLock>::iterator it = m_locks.begin(); it != m_locks.end(); ++it)
       (*it).acquire();
+
+   wait_optimistic();
 }
 
 // Release exclusive access
 void
 _SetLock::release_exclusive(void)
 {
+   __atomic_store_n(&m_exclusive, 0, __ATOMIC_RELEASE);
    for(std::vector<PersetLock>::iterator it = m_locks.begin(); it != m_locks.end(); ++it)
       (*it).release();
 }
@@ -60,7 +64,37 @@ _SetLock::upgrade(UInt32 core_id)
 void
 _SetLock::downgrade(UInt32 core_id)
 {
+   __atomic_store_n(&m_exclusive, 0, __ATOMIC_RELEASE);
    for(unsigned int i = 0; i < m_locks.size(); ++i)
       if (i != (core_id - m_core_offset))
          m_locks.at(i).release();
 }
+
+bool
+_SetLock::try_acquire_optimistic(UInt32 core_id)
+{
+   UInt32 *flag = &m_locks.at(core_id - m_core_offset)._optimistic;
+   // Pairs with wait_optimistic(): either we see the exclusive owner, or it sees our flag and waits for us
+   __atomic_store_n(flag, 1, __ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m_exclusive, __ATOMIC_SEQ_CST))
+   {
+      __atomic_store_n(flag, 0, __ATOMIC_RELEASE);
+      return false;
+   }
+   return true;
+}
+
+void
+_SetLock::release_optimistic(UInt32 core_id)
+{
+   __atomic_store_n(&m_locks.at(core_id - m_core_offset)._optimistic, 0, __ATOMIC_RELEASE);
+}
+
+void
+_SetLock::wait_optimistic(void)
+{
+   __atomic_store_n(&m_exclusive, 1, __ATOMIC_SEQ_CST);
+   for(std::vector<PersetLock>::iterator it = m_locks.begin(); it != m_locks.end(); ++it)
+      while(__atomic_load_n(&(*it)._optimistic, __ATOMIC_SEQ_CST))
+         __builtin_ia32_pause();
+}
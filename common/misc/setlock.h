@@ -20,19 +20,28 @@ class _SetLock
       void upgrade(UInt32 core_id);
       void downgrade(UInt32 core_id);
 
+      // Optimistic shared access for a single thread per core: no mutex is taken, instead exclusive
+      // acquirers wait until the reader is done. Fails (returns false) while someone holds the lock exclusively.
+      bool try_acquire_optimistic(UInt32 core_id);
+      void release_optimistic(UInt32 core_id);
+
    private:
       class PersetLock
       {
          public:
-            PersetLock() { pthread_mutex_init(&_mutx, NULL); }
+            PersetLock() : _optimistic(0) { pthread_mutex_init(&_mutx, NULL); }
             void acquire() { pthread_mutex_lock(&_mutx); }
             void release() { pthread_mutex_unlock(&_mutx); }
+            UInt32 _optimistic;
          private:
             pthread_mutex_t _mutx;
       } __attribute__ ((aligned (64)));
 
       std::vector<PersetLock> m_locks;
       UInt32 m_core_offset;
+      UInt32 m_exclusive;
+
+      void wait_optimistic(void);
       #ifdef TIME_LOCKS
       TotalTimer* _timer;
       #endif
@@ -0,0 +1,77 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "fixed_types.h"
+
+#include <assert.h>
+
+// Lock-free single-producer, single-consumer ring buffer.
+// Exactly one thread may call the producer side (full/back/push), and exactly one (other) thread
+// may call the consumer side (empty/front/pop). Size is rounded up to a power of two.
+// Producer and consumer indices live on separate cache lines, and each side keeps a cached copy
+// of the other side's index so the shared line is only touched when the ring looks full/empty.
+template <class T> class SPSCQueue
+{
+   private:
+      const UInt32 m_size;
+      const UInt32 m_mask;
+      T* const m_queue;
+      UInt8 padding0[64 - sizeof(UInt32) * 2 - sizeof(T*)];
+      UInt32 m_head;          //< Next slot to be written (producer-owned)
+      UInt32 m_tail_cached;   //< Producer's view of m_tail
+      UInt8 padding1[64 - sizeof(UInt32) * 2];
+      UInt32 m_tail;          //< Next slot to be read (consumer-owned)
+      UInt32 m_head_cached;   //< Consumer's view of m_head
+      UInt8 padding2[64 - sizeof(UInt32) * 2];
+
+      static UInt32 roundPow2(UInt32 size)
+      {
+         UInt32 s = 1;
+         while (s < size)
+            s <<= 1;
+         return s;
+      }
+
+   public:
+      SPSCQueue(UInt32 size = 64)
+         : m_size(roundPow2(size))
+         , m_mask(m_size - 1)
+         , m_queue(new T[m_size])
+         , m_head(0)
+         , m_tail_cached(0)
+         , m_tail(0)
+         , m_head_cached(0)
+      {}
+      ~SPSCQueue() { delete [] m_queue; }
+
+      UInt32 capacity() const { return m_size; }
+
+      // Producer side
+      bool full()
+      {
+         if (m_head - m_tail_cached < m_size)
+            return false;
+         m_tail_cached = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+         return m_head - m_tail_cached >= m_size;
+      }
+      // Slot to be filled in place before calling push()
+      T& back() { assert(m_head - m_tail_cached < m_size); return m_queue[m_head & m_mask]; }
+      void push() { __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELEASE); }
+      void push(const T& t) { back() = t; push(); }
+
+      // Consumer side
+      bool empty()
+      {
+         if (m_tail != m_head_cached)
+            return false;
+         m_head_cached = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+         return m_tail == m_head_cached;
+      }
+      T& front() { assert(m_tail != m_head_cached); return m_queue[m_tail & m_mask]; }
+      void pop() { __atomic_store_n(&m_tail, m_tail + 1, __ATOMIC_RELEASE); }
+
+      // Approximate when called from neither side
+      UInt32 size() const { return __atomic_load_n(&m_head, __ATOMIC_RELAXED) - __atomic_load_n(&m_tail, __ATOMIC_RELAXED); }
+};
+
+#endif // SPSC_QUEUE_H
@@ -3,6 +3,8 @@
 #include "hooks_manager.h"
 #include "utils.h"
 #include "itostr.h"
+#include "timer.h"
+#include "config.hpp"
 
 #include <math.h>
 #include <stdio.h>
@@ -32,6 +34,10 @@ const char db_insert_stmt_name[] = "INSERT INTO `names` (nameid, objectname, met
 const char db_insert_stmt_prefix[] = "INSERT INTO `prefixes` (prefixid, prefixname) VALUES (?, ?);";
 const char db_insert_stmt_value[] = "INSERT INTO `values` (prefixid, nameid, core, value) VALUES (?, ?, ?, ?);";
 
+// sim.stats.bin: this header, followed by records of a (UInt32 type, UInt32 size) header and a payload padded to 8 bytes
+const char stats_bin_magic[8] = "SNSTATS";
+const UInt64 stats_bin_version = 1;
+
 UInt64 getWallclockTimeCallback(String objectName, UInt32 index, String metricName, UInt64 arg)
 {
    struct timeval tv = {0,0};
@@ -43,11 +49,24 @@ UInt64 getWallclockTimeCallback(String objectName, UInt32 index, String metricNa
 StatsManager::StatsManager()
    : m_keyid(0)
    , m_prefixnum(0)
+   , m_binary(false)
+   , m_columns_written(0)
+   , m_binfile(NULL)
+   , m_num_snapshots(0)
+   , m_snapshot_time(SubsecondTime::Zero())
    , m_db(NULL)
 {
+   String backend = Sim()->getCfg()->getString("stats/backend");
+   if (backend == "binary")
+      m_binary = true;
+   else if (backend != "sqlite")
+      LOG_PRINT_ERROR("Unknown statistics backend %s, should be sqlite or binary", backend.c_str());
+
    init();
 
    registerMetric(new StatsMetricCallback("time", 0, "walltime", getWallclockTimeCallback, 0));
+   registerMetric(new StatsMetric<UInt64>("stats", 0, "snapshots", &m_num_snapshots));
+   registerMetric(new StatsMetric<SubsecondTime>("stats", 0, "snapshot_time", &m_snapshot_time));
 }
 
 StatsManager::~StatsManager()
@@ -64,6 +83,8 @@ StatsManager::~StatsManager()
       sqlite3_finalize(m_stmt_insert_value);
       sqlite3_close(m_db);
    }
+   if (m_binfile)
+      fclose(m_binfile);
 }
 
 void
@@ -72,6 +93,17 @@ StatsManager::init()
    String filename = Sim()->getConfig()->formatOutputFileName("sim.stats.sqlite3");
    int ret;
 
+   if (m_binary)
+   {
+      // Statistics go into sim.stats.bin, sim.stats.sqlite3 only holds topology and events
+      String binname = Sim()->getConfig()->formatOutputFileName("sim.stats.bin");
+      m_binfile = fopen(binname.c_str(), "wb");
+      LOG_ASSERT_ERROR(m_binfile, "Cannot create %s", binname.c_str());
+      fwrite(stats_bin_magic, sizeof(stats_bin_magic), 1, m_binfile);
+      fwrite(&stats_bin_version, sizeof(stats_bin_version), 1, m_binfile);
+      m_columns_written = 0;
+   }
+
    unlink(filename.c_str());
    ret = sqlite3_open(filename.c_str(), &m_db);
    LOG_ASSERT_ERROR(ret == SQLITE_OK, "Cannot create DB");
@@ -116,6 +148,17 @@ StatsManager::busy_handler(int count)
 void
 StatsManager::recordMetricName(UInt64 keyId, std::string objectName, std::string metricName)
 {
+   if (m_binary)
+   {
+      std::string record((const char*)&keyId, sizeof(keyId));
+      record += objectName;
+      record.push_back('\0');
+      record += metricName;
+      record.push_back('\0');
+      writeRecord(RECORD_NAME, record.data(), record.size());
+      return;
+   }
+
    int res;
    sqlite3_reset(m_stmt_insert_name);
    sqlite3_bind_int(m_stmt_insert_name, 1, keyId);
@@ -133,6 +176,20 @@ StatsManager::recordStats(String prefix)
    // Allow lazily-maintained statistics to be updated
    Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)prefix.c_str());
 
+   UInt64 t_start = Timer::now();
+
+   if (m_binary)
+      recordStatsBinary(prefix);
+   else
+      recordStatsSqlite(prefix);
+
+   ++m_num_snapshots;
+   m_snapshot_time += SubsecondTime::NS(Timer::now() - t_start);
+}
+
+void
+StatsManager::recordStatsSqlite(String prefix)
+{
    int res;
    int prefixid = ++m_prefixnum;
 
@@ -145,29 +202,72 @@ StatsManager::recordStats(String prefix)
    res = sqlite3_step(m_stmt_insert_prefix);
    LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 
-   for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
+   for(UInt64 column = 0; column < m_metrics.size(); ++column)
    {
-      for (StatsMetricList::iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
+      if (!m_metrics[column]->isDefault())
       {
-         for(StatsIndexList::iterator it3 = it2->second.second.begin(); it3 != it2->second.second.end(); ++it3)
-         {
-            if (!it3->second->isDefault())
-            {
-               sqlite3_reset(m_stmt_insert_value);
-               sqlite3_bind_int(m_stmt_insert_value, 1, prefixid);
-               sqlite3_bind_int(m_stmt_insert_value, 2, it2->second.first);   // Metric ID
-               sqlite3_bind_int(m_stmt_insert_value, 3, it3->second->index);  // Core ID
-               sqlite3_bind_int64(m_stmt_insert_value, 4, it3->second->recordMetric());
-               res = sqlite3_step(m_stmt_insert_value);
-               LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
-            }
-         }
+         sqlite3_reset(m_stmt_insert_value);
+         sqlite3_bind_int(m_stmt_insert_value, 1, prefixid);
+         sqlite3_bind_int(m_stmt_insert_value, 2, m_metric_keyids[column]);   // Metric ID
+         sqlite3_bind_int(m_stmt_insert_value, 3, m_metrics[column]->index);  // Core ID
+         sqlite3_bind_int64(m_stmt_insert_value, 4, m_metrics[column]->recordMetric());
+         res = sqlite3_step(m_stmt_insert_value);
+         LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
       }
    }
    res = sqlite3_exec(m_db, "END TRANSACTION", NULL, NULL, NULL);
    LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 }
 
+void
+StatsManager::recordStatsBinary(String prefix)
+{
+   UInt64 num_columns = m_metrics.size();
+
+   // Metrics registered since the previous snapshot: tell the reader which (metric, index) each new column holds
+   if (m_columns_written < num_columns)
+   {
+      std::vector<UInt64> columns;
+      columns.push_back(m_columns_written);
+      for(UInt64 column = m_columns_written; column < num_columns; ++column)
+      {
+         columns.push_back(m_metric_keyids[column]);
+         columns.push_back(m_metrics[column]->index);
+      }
+      writeRecord(RECORD_COLUMNS, columns.data(), columns.size() * sizeof(UInt64));
+      m_columns_written = num_columns;
+   }
+
+   // One snapshot is a single contiguous array: header words, then the value of every column in ID order
+   UInt64 prefix_words = (prefix.size() + sizeof(UInt64) - 1) / sizeof(UInt64);
+   UInt64 header_words = 3 + prefix_words;
+   m_values.resize(header_words + num_columns);
+   m_values[0] = ++m_prefixnum;
+   m_values[1] = prefix.size();
+   m_values[header_words - 1] = num_columns;
+   memset(&m_values[2], 0, prefix_words * sizeof(UInt64));
+   memcpy(&m_values[2], prefix.c_str(), prefix.size());
+
+   UInt64 *values = &m_values[header_words];
+   for(UInt64 column = 0; column < num_columns; ++column)
+      values[column] = m_metrics[column]->recordMetric();
+
+   writeRecord(RECORD_SNAPSHOT, m_values.data(), m_values.size() * sizeof(UInt64));
+   // Make complete snapshots visible to readers while the simulation is still running
+   fflush(m_binfile);
+}
+
+void
+StatsManager::writeRecord(record_type_t type, const void *data, UInt32 size)
+{
+   static const char padding[sizeof(UInt64)] = { 0 };
+   UInt32 header[2] = { type, (size + UInt32(sizeof(UInt64)) - 1) & ~(UInt32(sizeof(UInt64)) - 1) };
+
+   fwrite(header, sizeof(header), 1, m_binfile);
+   fwrite(data, 1, size, m_binfile);
+   fwrite(padding, 1, header[1] - size, m_binfile);
+}
+
 void
 StatsManager::registerMetric(StatsMetricBase *metric)
 {
@@ -186,6 +286,9 @@ StatsManager::registerMetric(StatsMetricBase *metric)
          recordMetricName(m_keyid, _objectName, _metricName);
       }
    }
+
+   m_metrics.push_back(metric);
+   m_metric_keyids.push_back(m_objects[_objectName][_metricName].first);
 }
 
 StatsMetricBase *
@@ -4,6 +4,8 @@
 #include "itostr.h"
 
 #include <cstring>
+#include <cstdio>
+#include <vector>
 #include <sqlite3.h>
 
 class StatsMetricBase
@@ -80,8 +82,26 @@ class StatsManager
       void logEvent(event_type_t event, SubsecondTime time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char * description);
 
    private:
+      // Records in sim.stats.bin, see recordStatsBinary()
+      typedef enum {
+         RECORD_NAME = 1,        // nameid, objectname\0, metricname\0
+         RECORD_COLUMNS,         // first column id, then (nameid, index) for each new column
+         RECORD_SNAPSHOT,        // prefixid, prefix length, prefix (padded to 8 bytes), number of columns, one value per column
+      } record_type_t;
+
       UInt64 m_keyid;
       UInt64 m_prefixnum;
+      bool m_binary;
+
+      // Every metric gets a dense ID (its column) at registration time
+      std::vector<StatsMetricBase*> m_metrics;
+      std::vector<UInt64> m_metric_keyids;
+      std::vector<UInt64> m_values;
+      UInt64 m_columns_written;
+      FILE *m_binfile;
+
+      UInt64 m_num_snapshots;
+      SubsecondTime m_snapshot_time;         //< Host time spent writing snapshots
 
       sqlite3 *m_db;
       sqlite3_stmt *m_stmt_insert_name;
@@ -99,6 +119,9 @@ class StatsManager
       int busy_handler(int count);
 
       void recordMetricName(UInt64 keyId, std::string objectName, std::string metricName);
+      void recordStatsSqlite(String prefix);
+      void recordStatsBinary(String prefix);
+      void writeRecord(record_type_t type, const void *data, UInt32 size);
 };
 
 template <class T> void registerStatsMetric(String objectName, UInt32 index, String metricName, T *metric)
@@ -10,6 +10,11 @@
 #include "subsecond_time.h"
 #include "performance_model.h"
 #include "instruction.h"
+#include "allocator.h"
+#include "config.hpp"
+#include "self_profile.h"
+
+#include <new>
 
 // FIXME: Rework netCreateBuf and netExPacket. We don't need to
 // duplicate the sender/receiver info the packet. This should be known
@@ -27,6 +32,7 @@ Network::Network(Core *core)
    _tid = _core->getId();
 
    _transport = Transport::getSingleton()->createNode(_core->getId());
+   _pooled = usePooledTransport();
 
    _callbacks = new NetworkCallback [NUM_PACKET_TYPES];
    _callbackObjs = new void* [NUM_PACKET_TYPES];
@@ -55,6 +61,17 @@ Network::~Network()
    LOG_PRINT("Destroyed.");
 }
 
+bool Network::usePooledTransport()
+{
+   String type = Sim()->getCfg()->getString("network/transport");
+   if (type == "copy")
+      return false;
+   else if (type == "pooled")
+      return true;
+   else
+      LOG_PRINT_ERROR("Unknown network transport type %s", type.c_str());
+}
+
 void Network::registerCallback(PacketType type, NetworkCallback callback, void *obj)
 {
    assert((UInt32)type < NUM_PACKET_TYPES);
@@ -78,61 +95,85 @@ void Network::netPullFromTransport()
    {
       LOG_PRINT("Entering netPullFromTransport");
 
-      NetPacket packet(_transport->recv());
+      if (_pooled)
+      {
+         // Use the packet in place, its payload goes back to the pool together with the message
+         NetPacketMessage *message = (NetPacketMessage*)_transport->recvMessage();
+         receivePacket(message->packet);
+         NetPacketMessage::release(message);
+      }
+      else
+      {
+         NetPacket packet(_transport->recv());
+         receivePacket(packet);
+      }
+   }
+   while (_transport->query());
+}
 
-      LOG_PRINT("Pull packet : type %i, from %i, time %s", (SInt32)packet.type, packet.sender, itostr(packet.time).c_str());
-      assert(0 <= packet.sender && packet.sender < _numMod);
-      LOG_ASSERT_ERROR(0 <= packet.type && packet.type < NUM_PACKET_TYPES, "Packet type: %d not between 0 and %d", packet.type, NUM_PACKET_TYPES);
+void Network::receivePacket(NetPacket& packet)
+{
+   LOG_PRINT("Pull packet : type %i, from %i, time %s", (SInt32)packet.type, packet.sender, itostr(packet.time).c_str());
+   assert(0 <= packet.sender && packet.sender < _numMod);
+   LOG_ASSERT_ERROR(0 <= packet.type && packet.type < NUM_PACKET_TYPES, "Packet type: %d not between 0 and %d", packet.type, NUM_PACKET_TYPES);
 
-      // was this packet sent to us, or should it just be forwarded?
-      if (packet.receiver != _core->getId())
-      {
-         // Disable this feature now. None of the network models use it
-         LOG_PRINT("Forwarding packet : type %i, from %i, to %i, core_id %i, time %s.",
-               (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
-         forwardPacket(packet);
+   // was this packet sent to us, or should it just be forwarded?
+   if (packet.receiver != _core->getId())
+   {
+      // Disable this feature now. None of the network models use it
+      LOG_PRINT("Forwarding packet : type %i, from %i, to %i, core_id %i, time %s.",
+            (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
+      forwardPacket(packet);
 
-         // if this isn't a broadcast message, then we shouldn't process it further
-         if (packet.receiver != NetPacket::BROADCAST)
-         {
-            if (packet.length > 0)
-               delete [] (Byte*) packet.data;
-            continue;
-         }
+      // if this isn't a broadcast message, then we shouldn't process it further
+      if (packet.receiver != NetPacket::BROADCAST)
+      {
+         if (packet.length > 0 && !_pooled)
+            delete [] (Byte*) packet.data;
+         return;
       }
+   }
 
-      // I have received the packet
-      NetworkModel *model = _models[g_type_to_static_network_map[packet.type]];
-      model->processReceivedPacket(packet);
+   // I have received the packet
+   NetworkModel *model = _models[g_type_to_static_network_map[packet.type]];
+   model->processReceivedPacket(packet);
 
-      // asynchronous I/O support
-      NetworkCallback callback = _callbacks[packet.type];
+   // asynchronous I/O support
+   NetworkCallback callback = _callbacks[packet.type];
 
-      if (callback != NULL)
-      {
-         LOG_PRINT("Executing callback on packet : type %i, from %i, to %i, core_id %i, time %s",
-               (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
-         assert(0 <= packet.sender && packet.sender < _numMod);
-         assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
+   if (callback != NULL)
+   {
+      LOG_PRINT("Executing callback on packet : type %i, from %i, to %i, core_id %i, time %s",
+            (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
+      assert(0 <= packet.sender && packet.sender < _numMod);
+      assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
 
-         callback(_callbackObjs[packet.type], packet);
+      callback(_callbackObjs[packet.type], packet);
 
-         if (packet.length > 0)
-            delete [] (Byte*) packet.data;
-      }
+      if (packet.length > 0 && !_pooled)
+         delete [] (Byte*) packet.data;
+   }
 
-      // synchronous I/O support
-      else
+   // synchronous I/O support
+   else
+   {
+      LOG_PRINT("Enqueuing packet : type %i, from %i, to %i, core_id %i, time %s.",
+            (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
+
+      // netRecv() callers own, and delete, the payload
+      NetPacket queued = packet;
+      if (packet.length > 0 && _pooled)
       {
-         LOG_PRINT("Enqueuing packet : type %i, from %i, to %i, core_id %i, time %s.",
-               (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
-         _netQueueLock.acquire();
-         _netQueue.push_back(packet);
-         _netQueueLock.release();
-         _netQueueCond.broadcast();
+         Byte *data = new Byte[packet.length];
+         memcpy(data, packet.data, packet.length);
+         queued.data = data;
       }
+
+      _netQueueLock.acquire();
+      _netQueue.push_back(queued);
+      _netQueueLock.release();
+      _netQueueCond.broadcast();
    }
-   while (_transport->query());
 }
 
 // FIXME: Can forwardPacket be subsumed by netSend?
@@ -149,6 +190,8 @@ NetworkModel* Network::getNetworkModelFromPacketType(PacketType packet_type)
 
 SInt32 Network::netSend(NetPacket& packet)
 {
+   SelfProfile::Scope profile(SelfProfile::NETWORK);
+
    assert(packet.type >= 0 && packet.type < NUM_PACKET_TYPES);
 
    NetworkModel *model = _models[g_type_to_static_network_map[packet.type]];
@@ -158,7 +201,10 @@ SInt32 Network::netSend(NetPacket& packet)
    std::vector<NetworkModel::Hop> hopVec;
    model->routePacket(packet, hopVec);
 
-   Byte *buffer = packet.makeBuffer();
+   // Copy mode: serialize once, the transport copies the buffer for every hop.
+   // Pooled mode: keep the header as it is now, the shortcut below updates packet along the way.
+   Byte *buffer = _pooled ? NULL : packet.makeBuffer();
+   NetPacket header = packet;
    SubsecondTime start_time = packet.time;
 
    for (UInt32 i = 0; i < hopVec.size(); i++)
@@ -188,7 +234,9 @@ SInt32 Network::netSend(NetPacket& packet)
          }
       }
 
-      NetPacket* buff_pkt = (NetPacket*) buffer;
+      // Pooled mode: every hop gets its own message, which is handed over as is
+      NetPacketMessage *message = _pooled ? NetPacketMessage::create(header) : NULL;
+      NetPacket* buff_pkt = _pooled ? &message->packet : (NetPacket*) buffer;
 
       if (_core->getId() == buff_pkt->sender)
          buff_pkt->start_time = start_time;
@@ -196,7 +244,10 @@ SInt32 Network::netSend(NetPacket& packet)
       buff_pkt->time = hopVec[i].time;
       buff_pkt->receiver = hopVec[i].final_dest;
 
-      _transport->send(hopVec[i].next_dest, buffer, packet.bufferSize());
+      if (_pooled)
+         _transport->send(hopVec[i].next_dest, message);
+      else
+         _transport->send(hopVec[i].next_dest, buffer, packet.bufferSize());
 
       LOG_PRINT("Sent packet");
    }
@@ -540,3 +591,62 @@ Byte* NetPacket::makeBuffer() const
 
    return buffer;
 }
+
+// -- NetPacketMessage
+
+namespace
+{
+   template <UInt32 Size> struct NetPacketStorage
+   {
+      char bytes[Size];
+   };
+
+   struct NetPacketPool
+   {
+      UInt32 size;   //< Bytes per element, for the message and its payload
+      Allocator *allocator;
+   };
+
+   // Coherence messages, with or without a 64-byte cache line of data, fit in the first class
+   const UInt32 NUM_NET_PACKET_POOLS = 3;
+
+   const NetPacketPool* getNetPacketPools()
+   {
+      static const NetPacketPool s_pools[NUM_NET_PACKET_POOLS] = {
+         { 256, new ThreadLocalAllocator<NetPacketStorage<256> >() },
+         { 1024, new ThreadLocalAllocator<NetPacketStorage<1024> >() },
+         { 4096, new ThreadLocalAllocator<NetPacketStorage<4096> >() },
+      };
+      return s_pools;
+   }
+}
+
+NetPacketMessage* NetPacketMessage::create(const NetPacket &packet)
+{
+   UInt32 size = sizeof(NetPacketMessage) + packet.length;
+   const NetPacketPool *pools = getNetPacketPools();
+
+   UInt32 size_class = 0;
+   while (size_class < NUM_NET_PACKET_POOLS && pools[size_class].size < size)
+      ++size_class;
+
+   void *ptr = size_class < NUM_NET_PACKET_POOLS ? pools[size_class].allocator->alloc(size) : new Byte[size];
+   NetPacketMessage *message = new (ptr) NetPacketMessage();
+   message->m_size_class = size_class;
+
+   Byte *payload = (Byte*)(message + 1);
+   message->packet = packet;
+   message->packet.data = payload;
+   if (packet.length > 0)
+      memcpy(payload, packet.data, packet.length);
+
+   return message;
+}
+
+void NetPacketMessage::release(NetPacketMessage *message)
+{
+   if (message->m_size_class < NUM_NET_PACKET_POOLS)
+      Allocator::dealloc(message);
+   else
+      delete [] (Byte*)message;
+}
@@ -45,6 +45,26 @@ public:
 
 typedef std::list<NetPacket> NetQueue;
 
+// -- Pooled packets -- //
+
+// A NetPacket as handed between nodes by the pooled transport (network/transport = pooled): the header and a copy of
+// the payload share one pool element, and the receiver uses the packet in place. Elements come from per-thread pools
+// in a few size classes. They are mostly released by the receiving thread, which returns them to the sender's pool
+// without taking a lock.
+class NetPacketMessage : public Transport::Message
+{
+public:
+   NetPacket packet;   //< packet.data points at the payload, right behind this object
+
+   static NetPacketMessage* create(const NetPacket &packet);
+   static void release(NetPacketMessage *message);
+
+private:
+   UInt32 m_size_class;
+
+   NetPacketMessage() { }
+};
+
 // -- Network Matches -- //
 
 class NetMatch
@@ -72,6 +92,9 @@ class Network
 
       typedef void (*NetworkCallback)(void*, NetPacket);
 
+      // Transport mode (network/transport): false to pass serialized copies, true to pass pooled NetPacketMessages
+      static bool usePooledTransport();
+
       void registerCallback(PacketType type,
                             NetworkCallback callback,
                             void *obj);
@@ -110,6 +133,7 @@ class Network
 
       Core *_core;
       Transport::Node *_transport;
+      bool _pooled;
 
       SInt32 _tid;
       SInt32 _numMod;
@@ -119,6 +143,7 @@ class Network
       ConditionVariable _netQueueCond;
 
       void forwardPacket(NetPacket& packet);
+      void receivePacket(NetPacket& packet);
 };
 
 #endif // NETWORK_H
@@ -25,8 +25,13 @@ const char* OutputDirectionString(NetworkModelEMeshHopByHop::OutputDirection dir
    return output_direction_names[direction];
 }
 
+NetworkModelEMeshHopByHop::RouteTable *NetworkModelEMeshHopByHop::s_route_tables[NUM_STATIC_NETWORKS] = { NULL };
+Lock NetworkModelEMeshHopByHop::s_route_tables_lock;
+
 NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, EStaticNetwork net_type):
    NetworkModel(net, net_type),
+   m_net_type(net_type),
+   m_route_table(NULL),
    m_enabled(false),
    m_total_bytes_sent(0),
    m_total_packets_sent(0),
@@ -40,6 +45,8 @@ NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, EStaticNetwor
    m_link_bandwidth(Sim()->getDvfsManager()->getCoreDomain(m_core_id), 0),
    m_hop_latency(Sim()->getDvfsManager()->getCoreDomain(m_core_id), 0)
 {
+   bool precomputed_routes = false;
+
    // Get the Link Bandwidth, Hop Latency and if it has broadcast tree mechanism
    try
    {
@@ -58,6 +65,8 @@ NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, EStaticNetwor
       m_queue_model_type = Sim()->getCfg()->getString("network/emesh_hop_by_hop/queue_model/type");
 
       m_broadcast_tree_enabled = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/broadcast_tree/enabled");
+
+      precomputed_routes = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/precomputed_routes");
    }
    catch(...)
    {
@@ -81,6 +90,9 @@ NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, EStaticNetwor
    }
 
    createQueueModels(name);
+
+   if (precomputed_routes)
+      attachRouteTable();
 }
 
 NetworkModelEMeshHopByHop::~NetworkModelEMeshHopByHop()
@@ -88,6 +100,9 @@ NetworkModelEMeshHopByHop::~NetworkModelEMeshHopByHop()
    if (m_fake_node)
       return;
 
+   if (m_route_table)
+      detachRouteTable();
+
    for (UInt32 i = 0; i < NUM_OUTPUT_DIRECTIONS; i++)
    {
       if (m_queue_models[i])
@@ -116,8 +131,6 @@ NetworkModelEMeshHopByHop::createQueueModels(String name)
 void
 NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops)
 {
-   ScopedLock sl(m_lock);
-
    core_id_t requester = INVALID_CORE_ID;
 
    if (pkt.type == SHARED_MEM_1)
@@ -134,6 +147,7 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &n
 
    if (pkt.sender == m_core_id)
    {
+      ScopedLock sl(m_lock);
       m_total_packets_sent ++;
       m_total_bytes_sent += pkt_length;
    }
@@ -194,7 +208,7 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &n
             OutputDirection direction;
             core_id_t next_dest = getNextDest(i, direction);
 
-            addHop(direction, i, next_dest, curr_time, pkt_length, nextHops, requester);
+            addRoute(direction, i, next_dest, curr_time, pkt_length, nextHops, requester);
          }
       }
    }
@@ -217,15 +231,13 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &n
       OutputDirection direction;
       core_id_t next_dest = getNextDest(pkt.receiver, direction);
 
-      addHop(direction, pkt.receiver, next_dest, curr_time, pkt_length, nextHops, requester, (subsecond_time_t*)&pkt.queue_delay);
+      addRoute(direction, pkt.receiver, next_dest, curr_time, pkt_length, nextHops, requester, (subsecond_time_t*)&pkt.queue_delay);
    }
 }
 
 void
 NetworkModelEMeshHopByHop::processReceivedPacket(NetPacket& pkt)
 {
-   ScopedLock sl(m_lock);
-
    UInt32 pkt_length = getNetwork()->getModeledLength(pkt);
 
    core_id_t requester = INVALID_CORE_ID;
@@ -256,6 +268,7 @@ NetworkModelEMeshHopByHop::processReceivedPacket(NetPacket& pkt)
       pkt.queue_delay += ejection_port_queue_delay;
    }
 
+   ScopedLock sl(m_lock);
    m_total_packets_received ++;
    m_total_bytes_received += pkt_length;
    m_total_packet_latency += packet_latency;
@@ -281,6 +294,28 @@ NetworkModelEMeshHopByHop::addHop(OutputDirection direction,
    nextHops.push_back(h);
 }
 
+void
+NetworkModelEMeshHopByHop::addRoute(OutputDirection direction,
+      core_id_t final_dest, core_id_t next_dest,
+      SubsecondTime pkt_time, UInt32 pkt_length,
+      std::vector<Hop>& nextHops, core_id_t requester,
+      subsecond_time_t *queue_delay_stats)
+{
+   if (m_route_table && direction < NUM_OUTPUT_DIRECTIONS)
+   {
+      // Model all links up to the destination now, and send the packet there directly
+      Hop h;
+      h.final_dest = final_dest;
+      h.next_dest = final_dest;
+      h.time = pkt_time + computePathLatency(final_dest, pkt_time, pkt_length, requester, queue_delay_stats);
+      nextHops.push_back(h);
+   }
+   else
+   {
+      addHop(direction, final_dest, next_dest, pkt_time, pkt_length, nextHops, requester, queue_delay_stats);
+   }
+}
+
 SInt32
 NetworkModelEMeshHopByHop::computeDistance(core_id_t sender, core_id_t receiver)
 {
@@ -327,6 +362,7 @@ NetworkModelEMeshHopByHop::computeLatency(OutputDirection direction, SubsecondTi
    SubsecondTime queue_delay = SubsecondTime::Zero();
    if (m_queue_model_enabled)
    {
+      ScopedLock sl(m_link_locks[direction]);
       queue_delay = m_queue_models[direction]->computeQueueDelay(pkt_time, processing_time);
       if (queue_delay_stats)
          *queue_delay_stats += queue_delay;
@@ -350,6 +386,7 @@ NetworkModelEMeshHopByHop::computeInjectionPortQueueDelay(core_id_t pkt_receiver
       return SubsecondTime::Zero();
 
    SubsecondTime processing_time = computeProcessingTime(pkt_length);
+   ScopedLock sl(m_injection_port_lock);
    return m_injection_port_queue_model->computeQueueDelay(pkt_time, processing_time);
 }
 
@@ -362,6 +399,7 @@ NetworkModelEMeshHopByHop::computeEjectionPortQueueDelay(SubsecondTime pkt_time,
       return SubsecondTime::Zero();
 
    SubsecondTime processing_time = computeProcessingTime(pkt_length);
+   ScopedLock sl(m_ejection_port_lock);
    return m_ejection_port_queue_model->computeQueueDelay(pkt_time, processing_time);
 }
 
@@ -402,9 +440,15 @@ NetworkModelEMeshHopByHop::getNextDest(SInt32 final_dest, OutputDirection& direc
       return m_core_id - m_core_id % m_concentration;
    }
 
+   return computeNextHop(m_core_id, final_dest, direction);
+}
+
+core_id_t
+NetworkModelEMeshHopByHop::computeNextHop(core_id_t from, core_id_t final_dest, OutputDirection& direction)
+{
    SInt32 sx, sy, dx, dy;
 
-   computePosition(m_core_id, sx, sy);
+   computePosition(from, sx, sy);
    computePosition(final_dest, dx, dy);
 
    if ((sx > dx) ^ (m_wrap_around && abs(sx - dx) > (m_mesh_width+1) / 2))
@@ -431,10 +475,90 @@ NetworkModelEMeshHopByHop::getNextDest(SInt32 final_dest, OutputDirection& direc
    {
       // A send to itself
       direction = SELF;
-      return m_core_id;
+      return from;
    }
 }
 
+SubsecondTime
+NetworkModelEMeshHopByHop::computePathLatency(core_id_t final_dest, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats)
+{
+   const RouteTable *table = m_route_table;
+   UInt32 route = (m_core_id / m_concentration) * table->num_nodes + final_dest / m_concentration;
+   UInt32 first = table->offsets[route], last = table->offsets[route + 1];
+
+   SubsecondTime time = pkt_time;
+   for (UInt32 i = first; i < last; i++)
+   {
+      const Link &link = table->links[i];
+      NetworkModelEMeshHopByHop *model = table->models[link.node];
+      LOG_ASSERT_ERROR(model != NULL, "No network model for mesh node %d", link.node);
+      // When routing hop by hop, links after the first are modeled after the sender has serialized the packet,
+      // so only the first link's queue delay ends up in the packet
+      time += model->computeLatency((OutputDirection)link.direction, time, pkt_length, requester, i == first ? queue_delay_stats : NULL);
+   }
+   return time - pkt_time;
+}
+
+void
+NetworkModelEMeshHopByHop::attachRouteTable()
+{
+   ScopedLock sl(s_route_tables_lock);
+
+   if (s_route_tables[m_net_type] == NULL)
+      s_route_tables[m_net_type] = buildRouteTable();
+
+   m_route_table = s_route_tables[m_net_type];
+   m_route_table->models[m_core_id / m_concentration] = this;
+   m_route_table->users++;
+}
+
+void
+NetworkModelEMeshHopByHop::detachRouteTable()
+{
+   ScopedLock sl(s_route_tables_lock);
+
+   m_route_table->models[m_core_id / m_concentration] = NULL;
+   if (--m_route_table->users == 0)
+   {
+      delete m_route_table;
+      s_route_tables[m_net_type] = NULL;
+   }
+   m_route_table = NULL;
+}
+
+NetworkModelEMeshHopByHop::RouteTable*
+NetworkModelEMeshHopByHop::buildRouteTable()
+{
+   RouteTable *table = new RouteTable();
+   table->num_nodes = m_mesh_width * m_mesh_height;
+   table->models.resize(table->num_nodes, NULL);
+   table->users = 0;
+   LOG_ASSERT_ERROR(table->num_nodes <= 65536, "Too many mesh nodes (%d) for precomputed routes", table->num_nodes);
+
+   // Walk every route with the same dimension-order routing as getNextDest
+   table->offsets.reserve(table->num_nodes * table->num_nodes + 1);
+   for (SInt32 s = 0; s < table->num_nodes; s++)
+   {
+      for (SInt32 d = 0; d < table->num_nodes; d++)
+      {
+         table->offsets.push_back(table->links.size());
+
+         core_id_t from = s * m_concentration, to = d * m_concentration;
+         while (from != to)
+         {
+            OutputDirection direction;
+            core_id_t next = computeNextHop(from, to, direction);
+            Link link = { (UInt16)(from / m_concentration), (UInt8)direction };
+            table->links.push_back(link);
+            from = next;
+         }
+      }
+   }
+   table->offsets.push_back(table->links.size());
+
+   return table;
+}
+
 void
 NetworkModelEMeshHopByHop::enable()
 {
@@ -26,9 +26,33 @@ class NetworkModelEMeshHopByHop : public NetworkModel
       } OutputDirection;
 
    private:
+      // Output link of a mesh node, one step of a route
+      struct Link
+      {
+         UInt16 node;         //< Mesh node (core id / concentration) that owns the link
+         UInt8 direction;     //< OutputDirection
+      };
+
+      // Dimension-order routes between all pairs of mesh nodes, and the model of each node, so that the sender can
+      // compute the latency of the whole path in one pass (network/emesh_hop_by_hop/precomputed_routes).
+      // Shared by all nodes of a static network.
+      struct RouteTable
+      {
+         SInt32 num_nodes;
+         std::vector<UInt32> offsets;  //< The route from s to d is links[offsets[s * num_nodes + d]] up to the next offset
+         std::vector<Link> links;
+         std::vector<NetworkModelEMeshHopByHop*> models;
+         UInt32 users;
+      };
+
+      static RouteTable *s_route_tables[NUM_STATIC_NETWORKS];
+      static Lock s_route_tables_lock;
+
       // Fields
       SInt32 m_mesh_width;
       SInt32 m_mesh_height;
+      EStaticNetwork m_net_type;
+      RouteTable *m_route_table;    //< NULL when routing hop by hop
 
       QueueModel* m_queue_models[NUM_OUTPUT_DIRECTIONS];
       QueueModel* m_injection_port_queue_model;
@@ -36,7 +60,11 @@ class NetworkModelEMeshHopByHop : public NetworkModel
 
       bool m_enabled;
 
-      // Lock
+      // Locks: one per queue model, so packets on different links of a node, and different nodes of a path, can be
+      // modeled concurrently. m_lock protects the counters.
+      Lock m_link_locks[NUM_OUTPUT_DIRECTIONS];
+      Lock m_injection_port_lock;
+      Lock m_ejection_port_lock;
       Lock m_lock;
 
       // Counters
@@ -53,9 +81,17 @@ class NetworkModelEMeshHopByHop : public NetworkModel
       SInt32 computeDistance(core_id_t sender, core_id_t receiver);
 
       void addHop(OutputDirection direction, core_id_t final_dest, core_id_t next_dest, SubsecondTime pkt_time, UInt32 pkt_length, std::vector<Hop>& nextHops, core_id_t requester, subsecond_time_t *queue_delay_stats = NULL);
+      void addRoute(OutputDirection direction, core_id_t final_dest, core_id_t next_dest, SubsecondTime pkt_time, UInt32 pkt_length, std::vector<Hop>& nextHops, core_id_t requester, subsecond_time_t *queue_delay_stats = NULL);
       SubsecondTime computeLatency(OutputDirection direction, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats);
       SubsecondTime computeProcessingTime(UInt32 pkt_length);
       core_id_t getNextDest(core_id_t final_dest, OutputDirection& direction);
+      core_id_t computeNextHop(core_id_t from, core_id_t final_dest, OutputDirection& direction);
+
+      // Precomputed routes
+      void attachRouteTable();
+      void detachRouteTable();
+      RouteTable* buildRouteTable();
+      SubsecondTime computePathLatency(core_id_t final_dest, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats);
 
       // Injection & Ejection Port Queue Models
       SubsecondTime computeInjectionPortQueueDelay(core_id_t pkt_receiver, SubsecondTime pkt_time, UInt32 pkt_length);
@@ -3,9 +3,11 @@
 #include "one_bit_branch_predictor.h"
 #include "pentium_m_branch_predictor.h"
 #include "tage/tage_predictor.h"
+#include "tage/tage_v2_predictor.h"
 #include "a53branchpredictor.h"
 #include "config.hpp"
 #include "stats.h"
+#include "checkpoint_manager.h"
 
 BranchPredictor::BranchPredictor()
    : m_correct_predictions(0)
@@ -26,6 +28,14 @@ BranchPredictor::~BranchPredictor() = default;
 UInt64 BranchPredictor::m_mispredict_penalty;
 
 BranchPredictor* BranchPredictor::create(core_id_t core_id)
+{
+   BranchPredictor *bp = createPredictor(core_id);
+   if (bp && Sim()->getCheckpointManager())
+      Sim()->getCheckpointManager()->registerObject("branch_predictor", core_id, bp);
+   return bp;
+}
+
+BranchPredictor* BranchPredictor::createPredictor(core_id_t core_id)
 {
    try
    {
@@ -56,6 +66,10 @@ BranchPredictor* BranchPredictor::create(core_id_t core_id)
       {
           return new TagePredictor("branch_predictor", core_id);
       }
+      else if (type == "tage_v2")
+      {
+          return new TageV2Predictor("branch_predictor", core_id);
+      }
       else
       {
          LOG_PRINT_ERROR("Invalid branch predictor type.")
@@ -72,6 +86,16 @@ UInt64 BranchPredictor::getMispredictPenalty()
    return m_mispredict_penalty;
 }
 
+void BranchPredictor::saveCheckpoint(CheckpointWriter &writer)
+{
+   LOG_PRINT_ERROR("This branch predictor type does not support checkpoints");
+}
+
+void BranchPredictor::loadCheckpoint(CheckpointReader &reader)
+{
+   LOG_PRINT_ERROR("This branch predictor type does not support checkpoints");
+}
+
 void BranchPredictor::resetCounters()
 {
   m_correct_predictions = 0;
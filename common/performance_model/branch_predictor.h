@@ -4,8 +4,9 @@
 #include <iostream>
 
 #include "fixed_types.h"
+#include "checkpoint.h"
 
-class BranchPredictor
+class BranchPredictor : public Checkpointable
 {
 public:
    BranchPredictor();
@@ -15,6 +16,9 @@ public:
    virtual bool predict(bool indirect, IntPtr ip, IntPtr target) = 0;
    virtual void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) = 0;
 
+   void saveCheckpoint(CheckpointWriter &writer) override;
+   void loadCheckpoint(CheckpointReader &reader) override;
+
    static UInt64 getMispredictPenalty();
    static BranchPredictor* create(core_id_t core_id);
 
@@ -27,6 +31,8 @@ protected:
    void updateCounters(bool predicted, bool actual);
 
 private:
+   static BranchPredictor* createPredictor(core_id_t core_id);
+
    UInt64 m_correct_predictions;
    UInt64 m_incorrect_predictions;
 
@@ -63,3 +63,15 @@ bool A53BranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target) {
 
    return statePrediction(m_pattern_history_table[historyIndex]);
 }
+
+void A53BranchPredictor::saveCheckpoint(CheckpointWriter &writer) {
+   ibtb.saveCheckpoint(writer);
+   writer.writeVector(m_pattern_history_table);
+   writer.writeVector(m_branch_history_register);
+}
+
+void A53BranchPredictor::loadCheckpoint(CheckpointReader &reader) {
+   ibtb.loadCheckpoint(reader);
+   reader.readVector(m_pattern_history_table);
+   reader.readVector(m_branch_history_register);
+}
@@ -19,6 +19,9 @@ public:
 
     bool predict(bool indirect, IntPtr ip, IntPtr target);
     void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
+
+    void saveCheckpoint(CheckpointWriter &writer);
+    void loadCheckpoint(CheckpointReader &reader);
 private:
     const int m_num_registers;
     const int size;
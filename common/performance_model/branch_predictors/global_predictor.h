@@ -117,6 +117,30 @@ public:
       return;
    }
 
+   void saveCheckpoint(CheckpointWriter &writer) override
+   {
+      writer.write(m_lru_use_count);
+      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      {
+         writer.writeVector(m_ways[w].m_valid);
+         writer.writeVector(m_ways[w].m_tags);
+         writer.writeVector(m_ways[w].m_predictors);
+         writer.writeVector(m_ways[w].m_lru);
+      }
+   }
+
+   void loadCheckpoint(CheckpointReader &reader) override
+   {
+      m_lru_use_count = reader.read<UInt64>();
+      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      {
+         reader.readVector(m_ways[w].m_valid);
+         reader.readVector(m_ways[w].m_tags);
+         reader.readVector(m_ways[w].m_predictors);
+         reader.readVector(m_ways[w].m_lru);
+      }
+   }
+
 private:
 
    class Way
@@ -71,6 +71,28 @@ class IndirectBranchTargetBuffer : BranchPredictor
     }
   }
 
+  void saveCheckpoint(CheckpointWriter &writer)
+  {
+    writer.write(history);
+    writer.write(lru);
+    writer.write<UInt64>(m_table.size());
+    for (UInt32 i = 0; i < m_num_entries; i++) {
+      writer.write(std::get<0>(m_table[i]));
+      writer.write(std::get<1>(m_table[i]));
+    }
+  }
+
+  void loadCheckpoint(CheckpointReader &reader)
+  {
+    history = reader.read<UInt32>();
+    lru = reader.read<int>();
+    reader.readExpect<UInt64>(m_table.size(), "number of entries");
+    for (UInt32 i = 0; i < m_num_entries; i++) {
+      std::get<0>(m_table[i]) = reader.read<UInt32>();
+      std::get<1>(m_table[i]) = reader.read<IntPtr>();
+    }
+  }
+
   private:
   UInt32 m_num_entries;
   UInt32 history;
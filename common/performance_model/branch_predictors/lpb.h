@@ -259,6 +259,36 @@ public:
 
    }
 
+   void saveCheckpoint(CheckpointWriter &writer)
+   {
+      writer.write(m_lru_use_count);
+      for (UInt32 w = 0 ; w < m_num_ways ; ++w )
+      {
+         writer.writeVector(m_ways[w].m_tags);
+         writer.writeVector(m_ways[w].m_previous_actual);
+         writer.writeVector(m_ways[w].m_enabled);
+         writer.writeVector(m_ways[w].m_predictors);
+         writer.writeVector(m_ways[w].m_lru);
+         writer.writeVector(m_ways[w].m_count);
+         writer.writeVector(m_ways[w].m_limit);
+      }
+   }
+
+   void loadCheckpoint(CheckpointReader &reader)
+   {
+      m_lru_use_count = reader.read<UInt64>();
+      for (UInt32 w = 0 ; w < m_num_ways ; ++w )
+      {
+         reader.readVector(m_ways[w].m_tags);
+         reader.readVector(m_ways[w].m_previous_actual);
+         reader.readVector(m_ways[w].m_enabled);
+         reader.readVector(m_ways[w].m_predictors);
+         reader.readVector(m_ways[w].m_lru);
+         reader.readVector(m_ways[w].m_count);
+         reader.readVector(m_ways[w].m_limit);
+      }
+   }
+
 private:
 
    class Way
@@ -23,3 +23,13 @@ void OneBitBranchPredictor::update(bool predicted, bool actual, bool indirect, I
    UInt32 index = ip % m_bits.size();
    m_bits[index] = actual;
 }
+
+void OneBitBranchPredictor::saveCheckpoint(CheckpointWriter &writer)
+{
+   writer.writeVector(m_bits);
+}
+
+void OneBitBranchPredictor::loadCheckpoint(CheckpointReader &reader)
+{
+   reader.readVector(m_bits);
+}
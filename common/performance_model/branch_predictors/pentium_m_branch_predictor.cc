@@ -91,3 +91,23 @@ void PentiumMBranchPredictor::update_pir(bool actual, IntPtr ip, IntPtr target,
 
    m_pir = ((m_pir << 2) ^ rhs) & 0x7fff;
 }
+
+void PentiumMBranchPredictor::saveCheckpoint(CheckpointWriter &writer)
+{
+   m_global_predictor.saveCheckpoint(writer);
+   m_btb.saveCheckpoint(writer);
+   m_bimodal_table.saveCheckpoint(writer);
+   m_lpb.saveCheckpoint(writer);
+   ibtb.saveCheckpoint(writer);
+   writer.write(m_pir);
+}
+
+void PentiumMBranchPredictor::loadCheckpoint(CheckpointReader &reader)
+{
+   m_global_predictor.loadCheckpoint(reader);
+   m_btb.loadCheckpoint(reader);
+   m_bimodal_table.loadCheckpoint(reader);
+   m_lpb.loadCheckpoint(reader);
+   ibtb.loadCheckpoint(reader);
+   m_pir = reader.read<IntPtr>();
+}
@@ -21,6 +21,9 @@ public:
 
    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
 
+   void saveCheckpoint(CheckpointWriter &writer);
+   void loadCheckpoint(CheckpointReader &reader);
+
 private:
 
    void update_pir(bool actual, IntPtr ip, IntPtr target, BranchPredictorReturnValue::BranchType branch_type);
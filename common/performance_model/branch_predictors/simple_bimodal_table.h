@@ -42,6 +42,16 @@ public:
       }
    }
 
+   void saveCheckpoint(CheckpointWriter &writer) override
+   {
+      writer.writeVector(m_table);
+   }
+
+   void loadCheckpoint(CheckpointReader &reader) override
+   {
+      reader.readVector(m_table);
+   }
+
    void reset()
    {
       for (unsigned int i = 0 ; i < m_num_entries ; i++) {
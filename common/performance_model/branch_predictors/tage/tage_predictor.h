@@ -4,62 +4,66 @@
 
 #pragma once
 
-#include <cmath>
-#include "tagged_table.h"
 #include "fixed_types.h"
 #include "branch_predictor.h"
 #include "simple_bimodal_table.h"
-#include <boost/dynamic_bitset.hpp>
 
+/**
+ * The predictor configured as branch_predictor/type=tage.
+ *
+ * This reproduces, prediction for prediction, the behaviour of the original TAGE implementation (a 4K-entry bimodal
+ * base and 7 tagged tables of 1K entries with 9-bit tags and history lengths 5..320), so that results obtained with
+ * type=tage do not change. That implementation does not behave like TAGE:
+ *  - the history groups are never shifted, so every tag hash only sees the outcome of the last branch (h);
+ *  - allocation writes into a copy of the entry, so all tags stay 0 and either all tables hit or none does;
+ *  - the per-table predictions are all read from the first table, whose counters are never updated from their
+ *    weakly taken initial value; only the counters and useful bits of the last table are, and nothing reads them.
+ * What is left is a bimodal table, overridden with a taken prediction for branches whose 9-bit tag
+ * (ip ^ h ^ (h << 1)) is 0.
+ */
 class TagePredictor : public BranchPredictor
 {
-    using dyn_bitset = boost::dynamic_bitset<>;
-public:
-    /**
-     * @param name
-     * @param core_id
-     * @param entries The number of entries in the partially-tagged tables; the number of entries in the base predictor is 4x this value
-     * @param components The number of <strong>total</strong> components, including the untagged base predictor
-     * @param alpha The ratio in the geometric series
-     * @param L_1 The initial value in the geometric series
-     */
-    explicit TagePredictor(const String &name, core_id_t core_id,
-                           UInt32 entries = 1024u, UInt8 components = 8u, UInt8 alpha = 2, UInt8 L_1 = 5,
-                           UInt8 tag_width = 9u);
+    static constexpr IntPtr TAG_MASK = (1u << 9) - 1;
 
-    bool predict(bool indirect, IntPtr ip, IntPtr target) override;
+public:
+    TagePredictor(const String &name, core_id_t core_id)
+        : BranchPredictor(name, core_id)
+        , m_base_predictor{1024u << 2}
+        , m_last_outcome{0}
+    {}
 
-    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) override;
+    bool predict(bool indirect, IntPtr ip, IntPtr target) override
+    {
+        bool base_prediction = m_base_predictor.predict(indirect, ip, target);
 
-private:
-    UInt32 tagged_tables_entries{1024u};
-    UInt8 entry_bits{10u};
-    UInt8 tag_width{9u};
+        if (((ip ^ m_last_outcome ^ (m_last_outcome << 1)) & TAG_MASK) == 0)
+            return true;
 
-    SimpleBimodalTable base_predictor{tagged_tables_entries << 2};
-    std::vector<TaggedTable> tagged_components{7, TaggedTable{tagged_tables_entries, 9u}};
-    std::vector<UInt32> geometric_series{};
+        return base_prediction;
+    }
 
-    dyn_bitset global_history_register{};
-    bool final_prediction{};
-    bool alt_prediction{};
-    std::size_t main_provider_i{};
-    std::size_t alt_provider_i{};
-    std::size_t main_provider_entry_index{};
-    UInt64 branch_count{};
+    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) override
+    {
+        updateCounters(predicted, actual);
 
-    std::vector<dyn_bitset> index_groups{};
-    std::vector<dyn_bitset> tag_csr1_groups{};
-    std::vector<dyn_bitset> tag_csr2_groups{};
+        m_last_outcome = actual;
 
-    std::vector<std::pair<bool, bool>> predictions{};
+        m_base_predictor.update(predicted, actual, indirect, ip, target);
+    }
 
-    void shiftAllLeft(bool inserted);
-    void shiftGroupsLeftAndSet(std::vector<dyn_bitset> &bit_groups, bool inserted) const;
+    void saveCheckpoint(CheckpointWriter &writer) override
+    {
+        m_base_predictor.saveCheckpoint(writer);
+        writer.write(m_last_outcome);
+    }
 
-    template<typename T>
-    dyn_bitset xorFoldNGroups(std::vector<dyn_bitset> &bit_groups, T n);
-    std::vector<boost::dynamic_bitset<>> xorFoldedResult(std::vector<dyn_bitset> &bit_groups, IntPtr ip);
+    void loadCheckpoint(CheckpointReader &reader) override
+    {
+        m_base_predictor.loadCheckpoint(reader);
+        m_last_outcome = reader.read<IntPtr>();
+    }
 
-    // std::function<bool(bool, const std::pair<bool, bool>&)> multiplexer;
+private:
+    SimpleBimodalTable m_base_predictor;
+    IntPtr m_last_outcome;      //< Outcome of the previous branch, the only history the original hashes see
 };
@@ -0,0 +1,289 @@
+//
+// Created by sharadh on 15/2/22.
+//
+
+#pragma once
+
+#include "fixed_types.h"
+#include "branch_predictor.h"
+#include "simple_bimodal_table.h"
+
+/**
+ * TAGE predictor (branch_predictor/type=tage_v2): an untagged bimodal base predictor plus NUM_TAGGED
+ * partially-tagged tables, indexed with geometrically increasing global history lengths MIN_HISTORY * ALPHA^i.
+ * Unlike type=tage, which is kept bit-compatible with the original implementation (see tage_predictor.h), this
+ * implements the provider/alternate prediction, allocation on mispredictions and periodic useful-bit aging.
+ *
+ * The table geometry is fixed at compile time so all state lives in fixed-size arrays inside the object.
+ * Global history is kept in a circular buffer, and the index and tag hashes of each table are maintained
+ * as folded (circular shift register) histories that are updated in O(1) per branch, so neither
+ * predict() nor update() allocates or walks the full history.
+ *
+ * @tparam LOG_ENTRIES log2 of the number of entries per tagged table; the base predictor has 4x as many
+ * @tparam NUM_TAGGED  number of tagged tables (the total number of components is NUM_TAGGED + 1)
+ * @tparam TAG_WIDTH   width of the partial tags, in bits
+ * @tparam MIN_HISTORY history length of the first tagged table
+ * @tparam ALPHA       ratio of the geometric series of history lengths
+ */
+template <UInt32 LOG_ENTRIES = 10, UInt32 NUM_TAGGED = 7, UInt32 TAG_WIDTH = 9, UInt32 MIN_HISTORY = 5, UInt32 ALPHA = 2>
+class TagePredictorBase : public BranchPredictor
+{
+    static_assert(NUM_TAGGED > 0, "TAGE needs at least one tagged table");
+    static_assert(TAG_WIDTH > 1 && TAG_WIDTH <= 16, "Tags are stored in 16 bits");
+    static_assert(LOG_ENTRIES < 32, "Table index must fit in 32 bits");
+
+    static constexpr UInt32 historyLength(UInt32 table)
+    {
+        return table == 0 ? MIN_HISTORY : ALPHA * historyLength(table - 1);
+    }
+
+    static constexpr UInt32 historyBufferSize(UInt32 size = 1)
+    {
+        return size > historyLength(NUM_TAGGED - 1) ? size : historyBufferSize(size << 1);
+    }
+
+    static constexpr UInt32 ENTRIES = 1u << LOG_ENTRIES;
+    static constexpr UInt32 INDEX_MASK = ENTRIES - 1;
+    static constexpr UInt32 TAG_MASK = (1u << TAG_WIDTH) - 1;
+    static constexpr UInt32 MAX_HISTORY = historyLength(NUM_TAGGED - 1);
+    static constexpr UInt32 HISTORY_SIZE = historyBufferSize();
+    static constexpr UInt32 HISTORY_MASK = HISTORY_SIZE - 1;
+    static constexpr UInt32 NONE = NUM_TAGGED;
+
+    // Useful bits are aged by alternately clearing their MSB and LSB
+    static constexpr UInt64 USEFUL_RESET_PERIOD = 512 * 1024;
+
+    static constexpr SInt8 CTR_MAX = 3;     // 3-bit signed prediction counters
+    static constexpr SInt8 CTR_MIN = -4;
+    static constexpr UInt8 USEFUL_MAX = 3;  // 2-bit useful counters
+
+    struct TaggedEntry
+    {
+        UInt16 tag;
+        SInt8 counter;
+        UInt8 useful;
+    };
+
+    // The history of length `length' folded onto `width' bits by xor-ing consecutive width-bit chunks.
+    // Shifting in a new outcome only needs the bit that drops out of the window.
+    struct FoldedHistory
+    {
+        UInt32 value;
+        UInt32 width;
+        UInt32 outpoint;
+
+        void init(UInt32 length, UInt32 _width)
+        {
+            value = 0;
+            width = _width;
+            outpoint = length % _width;
+        }
+
+        void update(bool inserted, bool evicted)
+        {
+            value = (value << 1) | inserted;
+            value ^= UInt32(evicted) << outpoint;
+            value ^= value >> width;
+            value &= (1u << width) - 1;
+        }
+    };
+
+public:
+    TagePredictorBase(const String &name, core_id_t core_id)
+        : BranchPredictor(name, core_id)
+        , m_base_predictor{ENTRIES << 2}
+        , m_history_ptr{0}
+        , m_branch_count{0}
+        , m_provider{NONE}
+        , m_provider_prediction{false}
+        , m_alt_prediction{false}
+    {
+        for (UInt32 i = 0; i < NUM_TAGGED; ++i)
+        {
+            for (UInt32 j = 0; j < ENTRIES; ++j)
+                m_tables[i][j] = TaggedEntry{0, 0, 0};
+
+            m_history_length[i] = historyLength(i);
+            m_index_history[i].init(historyLength(i), LOG_ENTRIES);
+            m_tag_history[0][i].init(historyLength(i), TAG_WIDTH);
+            m_tag_history[1][i].init(historyLength(i), TAG_WIDTH - 1);
+        }
+        for (UInt32 i = 0; i < HISTORY_SIZE; ++i)
+            m_history[i] = false;
+    }
+
+    bool predict(bool indirect, IntPtr ip, IntPtr target) override
+    {
+        ++m_branch_count;
+
+        bool base_prediction = m_base_predictor.predict(indirect, ip, target);
+
+        for (UInt32 i = 0; i < NUM_TAGGED; ++i)
+        {
+            m_index[i] = (ip ^ (ip >> LOG_ENTRIES) ^ m_index_history[i].value) & INDEX_MASK;
+            m_tag[i] = (ip ^ m_tag_history[0][i].value ^ (m_tag_history[1][i].value << 1)) & TAG_MASK;
+        }
+
+        // The provider is the hitting table with the longest history, the alternate the next one down
+        m_provider = NONE;
+        UInt32 alt = NONE;
+        for (UInt32 i = NUM_TAGGED; i-- > 0;)
+        {
+            if (m_tables[i][m_index[i]].tag == m_tag[i])
+            {
+                if (m_provider == NONE)
+                {
+                    m_provider = i;
+                }
+                else
+                {
+                    alt = i;
+                    break;
+                }
+            }
+        }
+
+        m_alt_prediction = alt == NONE ? base_prediction : m_tables[alt][m_index[alt]].counter >= 0;
+        if (m_provider == NONE)
+            return base_prediction;
+
+        m_provider_prediction = m_tables[m_provider][m_index[m_provider]].counter >= 0;
+        return m_provider_prediction;
+    }
+
+    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) override
+    {
+        updateCounters(predicted, actual);
+
+        m_base_predictor.update(predicted, actual, indirect, ip, target);
+
+        if (m_provider != NONE)
+        {
+            TaggedEntry &entry = m_tables[m_provider][m_index[m_provider]];
+
+            // The useful counter tracks whether the provider did better than the alternate prediction
+            if (m_provider_prediction != m_alt_prediction)
+            {
+                if (m_provider_prediction == actual)
+                    entry.useful += entry.useful < USEFUL_MAX;
+                else
+                    entry.useful -= entry.useful > 0;
+            }
+            updateCounter(entry.counter, actual);
+        }
+
+        // On a misprediction, allocate an entry in a table with a longer history than the provider
+        UInt32 first = m_provider == NONE ? 0 : m_provider + 1;
+        if (predicted != actual && first < NUM_TAGGED)
+        {
+            bool allocated = false;
+            for (UInt32 i = first; i < NUM_TAGGED; ++i)
+            {
+                TaggedEntry &entry = m_tables[i][m_index[i]];
+                if (entry.useful == 0)
+                {
+                    entry.tag = m_tag[i];
+                    entry.counter = actual ? 0 : -1;
+                    allocated = true;
+                    break;
+                }
+            }
+
+            // No victim: age all candidates so one can be allocated next time
+            if (!allocated)
+            {
+                for (UInt32 i = first; i < NUM_TAGGED; ++i)
+                {
+                    TaggedEntry &entry = m_tables[i][m_index[i]];
+                    entry.useful -= entry.useful > 0;
+                }
+            }
+        }
+
+        if (m_branch_count % USEFUL_RESET_PERIOD == 0)
+            resetUseful(0x1);
+        else if (m_branch_count % USEFUL_RESET_PERIOD == USEFUL_RESET_PERIOD / 2)
+            resetUseful(0x2);
+
+        updateHistory(actual);
+    }
+
+    void saveCheckpoint(CheckpointWriter &writer) override
+    {
+        m_base_predictor.saveCheckpoint(writer);
+        writer.write(m_tables, sizeof(m_tables));
+        writer.write(m_history, sizeof(m_history));
+        writer.write(m_history_ptr);
+        writer.write(m_index_history, sizeof(m_index_history));
+        writer.write(m_tag_history, sizeof(m_tag_history));
+        writer.write(m_branch_count);
+    }
+
+    void loadCheckpoint(CheckpointReader &reader) override
+    {
+        m_base_predictor.loadCheckpoint(reader);
+        reader.read(m_tables, sizeof(m_tables));
+        reader.read(m_history, sizeof(m_history));
+        m_history_ptr = reader.read<UInt32>();
+        reader.read(m_index_history, sizeof(m_index_history));
+        reader.read(m_tag_history, sizeof(m_tag_history));
+        m_branch_count = reader.read<UInt64>();
+    }
+
+private:
+    SimpleBimodalTable m_base_predictor;
+    TaggedEntry m_tables[NUM_TAGGED][ENTRIES];
+
+    bool m_history[HISTORY_SIZE];        //< Circular global history, m_history[m_history_ptr] is the most recent outcome
+    UInt32 m_history_ptr;
+    UInt32 m_history_length[NUM_TAGGED];
+    FoldedHistory m_index_history[NUM_TAGGED];
+    FoldedHistory m_tag_history[2][NUM_TAGGED];
+
+    UInt64 m_branch_count;
+
+    // State carried from predict() to the update() of the same branch
+    UInt32 m_index[NUM_TAGGED];
+    UInt32 m_tag[NUM_TAGGED];
+    UInt32 m_provider;
+    bool m_provider_prediction;
+    bool m_alt_prediction;
+
+    static void updateCounter(SInt8 &counter, bool taken)
+    {
+        if (taken)
+            counter += counter < CTR_MAX;
+        else
+            counter -= counter > CTR_MIN;
+    }
+
+    void resetUseful(UInt8 keep_mask)
+    {
+        for (UInt32 i = 0; i < NUM_TAGGED; ++i)
+            for (UInt32 j = 0; j < ENTRIES; ++j)
+                m_tables[i][j].useful &= keep_mask;
+    }
+
+    void updateHistory(bool taken)
+    {
+        m_history_ptr = (m_history_ptr - 1) & HISTORY_MASK;
+        m_history[m_history_ptr] = taken;
+
+        for (UInt32 i = 0; i < NUM_TAGGED; ++i)
+        {
+            bool evicted = m_history[(m_history_ptr + m_history_length[i]) & HISTORY_MASK];
+            m_index_history[i].update(taken, evicted);
+            m_tag_history[0][i].update(taken, evicted);
+            m_tag_history[1][i].update(taken, evicted);
+        }
+    }
+};
+
+// 8 components: a 4K-entry bimodal base and 7 tagged tables of 1K entries with 9-bit tags and history lengths 5..320
+class TageV2Predictor : public TagePredictorBase<>
+{
+public:
+    TageV2Predictor(const String &name, core_id_t core_id)
+        : TagePredictorBase<>(name, core_id)
+    {}
+};
@@ -15,7 +15,18 @@ FastforwardPerformanceModel::FastforwardPerformanceModel(Core *core, Performance
    , m_branch_misprediction_penalty(core->getDvfsDomain(), Sim()->getCfg()->getIntArray("perf_model/branch_predictor/mispredict_penalty", core->getId()))
    , m_cpi(SubsecondTime::Zero())
    , m_fastforwarded_time(SubsecondTime::Zero())
+   , m_memo_enabled(Sim()->getCfg()->getBool("perf_model/fast_forward/memo/enabled"))
+   , m_memo_max_entries(Sim()->getCfg()->getInt("perf_model/fast_forward/memo/max_entries"))
+   , m_memo_accesses(0)
+   , m_memo_record_valid(false)
+   , m_pending_latency_mask(0)
+   , m_memo_hits(0)
+   , m_memo_hits_block(0)
+   , m_memo_misses(0)
+   , m_memo_checks(0)
 {
+   static_assert(HitWhere::NUM_HITWHERES <= 64, "Pending latency mask cannot hold all HitWhere values");
+
    registerStatsMetric("fastforward_performance_model", core->getId(), "fastforwarded_time", &m_fastforwarded_time);
    registerStatsMetric("performance_model", core->getId(), "cpiFastforwardTime", &m_fastforwarded_time);
 
@@ -31,6 +42,19 @@ FastforwardPerformanceModel::FastforwardPerformanceModel(Core *core, Performance
          registerStatsMetric("fastforward_timer", core->getId(), name, &(m_cpiDataCache[h]));
       }
    }
+
+   if (m_memo_enabled)
+   {
+      registerStatsMetric("fastforward_memo", core->getId(), "hits", &m_memo_hits);
+      registerStatsMetric("fastforward_memo", core->getId(), "hits-block", &m_memo_hits_block);
+      registerStatsMetric("fastforward_memo", core->getId(), "misses", &m_memo_misses);
+      registerStatsMetric("fastforward_memo", core->getId(), "time", &m_memo_time);
+      // Prediction error of the memo table, measured against the detailed model on every basic block it times
+      registerStatsMetric("fastforward_memo", core->getId(), "checks", &m_memo_checks);
+      registerStatsMetric("fastforward_memo", core->getId(), "predicted-time", &m_memo_predicted_time);
+      registerStatsMetric("fastforward_memo", core->getId(), "measured-time", &m_memo_measured_time);
+      registerStatsMetric("fastforward_memo", core->getId(), "abs-error", &m_memo_abs_error);
+   }
 }
 
 void
@@ -59,16 +83,181 @@ FastforwardPerformanceModel::notifyElapsedTimeUpdate()
 void
 FastforwardPerformanceModel::countInstructions(IntPtr address, UInt32 count)
 {
+   if (m_memo_enabled)
+   {
+      bool exact = false;
+      const MemoEntry *entry = count ? lookupMemo(address, count, m_memo_accesses, exact) : NULL;
+      invalidateMemoRecording();
+
+      if (entry)
+      {
+         if (exact)
+            ++m_memo_hits;
+         else
+            ++m_memo_hits_block;
+         // The memoized cost already includes the memory latency seen by the detailed model
+         flushPendingLatency(false);
+         m_memo_time += entry->getCost();
+         incrementElapsedTime(entry->getCost(), m_cpiBase);
+         return;
+      }
+
+      if (count)
+         ++m_memo_misses;
+      flushPendingLatency(true);
+   }
+
    incrementElapsedTime(count * m_cpi, m_cpiBase);
 }
 
 void
 FastforwardPerformanceModel::handleMemoryLatency(SubsecondTime latency, HitWhere::where_t hit_where)
 {
-   if (m_include_memory_latency)
+   if (m_memo_enabled)
+   {
+      // Hold on to the latency until the end of the basic block, it is only charged when the block is not memoized
+      recordMemoryAccess(hit_where);
+      if (m_include_memory_latency)
+      {
+         m_pending_latency[hit_where] += latency;
+         m_pending_latency_mask |= 1ULL << hit_where;
+      }
+   }
+   else if (m_include_memory_latency)
       incrementElapsedTime(latency, m_cpiDataCache[hit_where]);
 }
 
+void
+FastforwardPerformanceModel::flushPendingLatency(bool charge)
+{
+   while (m_pending_latency_mask)
+   {
+      int h = __builtin_ctzll(m_pending_latency_mask);
+      m_pending_latency_mask &= m_pending_latency_mask - 1;
+      if (charge)
+         incrementElapsedTime(m_pending_latency[h], m_cpiDataCache[h]);
+      m_pending_latency[h] = SubsecondTime::Zero();
+   }
+}
+
+void
+FastforwardPerformanceModel::recordMemoryAccess(HitWhere::where_t hit_where)
+{
+   // Coarse cache hit signature: L1, L2, last-level and off-chip, two bits each
+   UInt32 level;
+   switch (hit_where)
+   {
+      case HitWhere::L1_OWN:
+      case HitWhere::L1_SIBLING:
+         level = 0;
+         break;
+      case HitWhere::L2_OWN:
+      case HitWhere::L2_SIBLING:
+         level = 1;
+         break;
+      case HitWhere::L3_OWN:
+      case HitWhere::L3_SIBLING:
+      case HitWhere::L4_OWN:
+      case HitWhere::L4_SIBLING:
+      case HitWhere::NUCA_CACHE:
+      case HitWhere::DRAM_CACHE:
+         level = 2;
+         break;
+      case HitWhere::MISS:
+      case HitWhere::DRAM:
+      case HitWhere::DRAM_LOCAL:
+      case HitWhere::DRAM_REMOTE:
+      case HitWhere::CACHE_REMOTE:
+         level = 3;
+         break;
+      default:
+         return;
+   }
+   if (((m_memo_accesses >> (2 * level)) & 3) != 3)
+      m_memo_accesses += 1 << (2 * level);
+}
+
+void
+FastforwardPerformanceModel::recordBasicBlock(IntPtr address, UInt32 count)
+{
+   // Idle time (synchronization, unscheduled periods) is not part of the cost of a basic block
+   SubsecondTime now = m_perf->getNonIdleElapsedTime();
+
+   if (m_memo_record_valid && count && now >= m_memo_record_start)
+   {
+      SubsecondTime measured = now - m_memo_record_start;
+
+      // Before learning from it, see what fast-forward would have charged for this block
+      bool exact;
+      const MemoEntry *entry = lookupMemo(address, count, m_memo_accesses, exact);
+      if (entry)
+      {
+         SubsecondTime predicted = entry->getCost();
+         ++m_memo_checks;
+         m_memo_predicted_time += predicted;
+         m_memo_measured_time += measured;
+         m_memo_abs_error += predicted > measured ? predicted - measured : measured - predicted;
+      }
+
+      updateMemo(m_memo_signature, (UInt64(address) << 8) | m_memo_accesses, count, measured);
+      updateMemo(m_memo_block, address, count, measured);
+   }
+
+   m_memo_record_valid = true;
+   m_memo_record_start = now;
+   m_memo_accesses = 0;
+}
+
+const FastforwardPerformanceModel::MemoEntry*
+FastforwardPerformanceModel::lookupMemo(IntPtr address, UInt32 count, UInt32 signature, bool &exact) const
+{
+   // Blocks are reconstructed by the frontend, so the same start address may be seen with a different length
+   MemoTable::const_iterator it = m_memo_signature.find((UInt64(address) << 8) | signature);
+   if (it != m_memo_signature.end() && it->second.count == count)
+   {
+      exact = true;
+      return &it->second;
+   }
+
+   it = m_memo_block.find(address);
+   if (it != m_memo_block.end() && it->second.count == count)
+   {
+      exact = false;
+      return &it->second;
+   }
+
+   return NULL;
+}
+
+void
+FastforwardPerformanceModel::updateMemo(MemoTable &table, UInt64 key, UInt32 count, SubsecondTime cost)
+{
+   MemoTable::iterator it = table.find(key);
+   if (it == table.end())
+   {
+      if (table.size() >= m_memo_max_entries)
+         return;
+      it = table.insert(std::make_pair(key, MemoEntry())).first;
+      it->second.count = 0;
+   }
+
+   MemoEntry &entry = it->second;
+   if (entry.count != count)
+   {
+      entry.count = count;
+      entry.samples = 0;
+      entry.total = SubsecondTime::Zero();
+   }
+   // Age old samples so the average follows phase changes
+   else if (entry.samples == 1024)
+   {
+      entry.samples /= 2;
+      entry.total = entry.total / 2;
+   }
+   entry.samples++;
+   entry.total += cost;
+}
+
 void
 FastforwardPerformanceModel::handleBranchMispredict()
 {
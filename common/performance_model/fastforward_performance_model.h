@@ -3,9 +3,24 @@
 
 #include "performance_model.h"
 
+#include <unordered_map>
+
 class FastforwardPerformanceModel
 {
    private:
+      // Time measured by the detailed model for the instructions between two consecutive countInstructions() calls,
+      // averaged over all times this window was seen. The window is identified by the basic block reported at its end:
+      // for the SIFT frontend that is the block which just completed, for Pin it is the block about to start.
+      struct MemoEntry
+      {
+         UInt32 count;
+         UInt32 samples;
+         SubsecondTime total;
+
+         SubsecondTime getCost() const { return total / (UInt64)samples; }
+      };
+      typedef std::unordered_map<UInt64, MemoEntry> MemoTable;
+
       Core *m_core;
       PerformanceModel *m_perf;
       const bool m_include_memory_latency;
@@ -19,6 +34,26 @@ class FastforwardPerformanceModel
       SubsecondTime m_cpiBranchPredictor;
       std::vector<SubsecondTime> m_cpiDataCache;
 
+      // Basic-block timing memoization
+      const bool m_memo_enabled;
+      const UInt64 m_memo_max_entries;
+      MemoTable m_memo_signature;      //< (block address, cache hit signature) -> cost
+      MemoTable m_memo_block;          //< block address -> cost, over all signatures
+      UInt32 m_memo_accesses;          //< Cache hit signature of the current window: accesses per hit level, 2-bit saturating
+      bool m_memo_record_valid;
+      SubsecondTime m_memo_record_start;
+      SubsecondTime m_pending_latency[HitWhere::NUM_HITWHERES];
+      UInt64 m_pending_latency_mask;
+
+      UInt64 m_memo_hits, m_memo_hits_block, m_memo_misses;
+      SubsecondTime m_memo_time;
+      UInt64 m_memo_checks;
+      SubsecondTime m_memo_predicted_time, m_memo_measured_time, m_memo_abs_error;
+
+      const MemoEntry* lookupMemo(IntPtr address, UInt32 count, UInt32 signature, bool &exact) const;
+      void updateMemo(MemoTable &table, UInt64 key, UInt32 count, SubsecondTime cost);
+      void flushPendingLatency(bool charge);
+
    public:
       FastforwardPerformanceModel(Core *core, PerformanceModel *perf);
       ~FastforwardPerformanceModel() {}
@@ -34,6 +69,12 @@ class FastforwardPerformanceModel
       void handleBranchMispredict();
       void queuePseudoInstruction(PseudoInstruction *i);
 
+      // Called by the performance model while in detailed mode, to learn the timing of each basic block
+      bool isMemoEnabled() const { return m_memo_enabled; }
+      void recordMemoryAccess(HitWhere::where_t hit_where);
+      void recordBasicBlock(IntPtr address, UInt32 count);
+      void invalidateMemoRecording() { m_memo_record_valid = false; m_memo_accesses = 0; }
+
       SubsecondTime getFastforwardedTime(void) const { return m_fastforwarded_time; }
 };
 
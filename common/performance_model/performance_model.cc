@@ -13,6 +13,12 @@
 #include "dvfs_manager.h"
 #include "instruction_tracer.h"
 #include "dynamic_instruction.h"
+#include "core_manager.h"
+#include "timer.h"
+#include "self_profile.h"
+
+#include <sched.h>
+#include <unistd.h>
 
 PerformanceModel* PerformanceModel::create(Core* core)
 {
@@ -55,15 +61,19 @@ PerformanceModel::PerformanceModel(Core *core)
    , m_fastforward(false)
    , m_fastforward_model(new FastforwardPerformanceModel(core, this))
    , m_detailed_sync(true)
-   , m_hold(false)
    , m_instruction_count(0)
    , m_elapsed_time(Sim()->getDvfsManager()->getCoreDomain(core->getId()))
    , m_idle_elapsed_time(Sim()->getDvfsManager()->getCoreDomain(core->getId()))
-   #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-   , m_instruction_queue(256) // Reduce from default size to keep memory issue time more or less synchronized
-   #else
    , m_instruction_queue(1024) // Need a bit more space for when the dyninsninfo items aren't coming in yet, or for a boatload of TLBMissInstructions
-   #endif
+   // SMT cores are fed by several functional threads at once, which the single-producer queue does not support
+   , m_own_thread(Sim()->getCfg()->getBool("perf_model/core/own_thread")
+      && Sim()->getCfg()->getIntArray("perf_model/core/logical_cpus", core->getId()) == 1)
+   , m_thread_queue(NULL)
+   , m_thread_queue_pushed(0)
+   , m_thread_queue_done(0)
+   , m_pseudo_pending(0)
+   , m_thread_queue_occupancy(0)
+   , m_thread_queue_full(0)
    , m_current_ins_index(0)
 {
    m_bp = BranchPredictor::create(core->getId());
@@ -89,6 +99,30 @@ PerformanceModel::PerformanceModel(Core *core)
    registerStatsMetric("performance_model", core->getId(), "cpiSyncDvfsTransition", &m_cpiSyncDvfsTransition);
 
    registerStatsMetric("performance_model", core->getId(), "cpiRecv", &m_cpiRecv);
+
+   // Only the trace frontend drains the timing thread before it reads time or handles system calls
+   LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("perf_model/core/own_thread") || Sim()->getCfg()->getBool("traceinput/enabled"),
+                    "perf_model/core/own_thread is only supported with the trace frontend");
+
+   if (m_own_thread)
+   {
+      // The memo table learns basic-block timing on the functional thread, from time kept by the timing thread
+      LOG_ASSERT_ERROR(!m_fastforward_model->isMemoEnabled(),
+                       "perf_model/fast_forward/memo cannot be combined with perf_model/core/own_thread");
+
+      // Kept small so the memory accesses issued by the timing thread stay close to the functional thread
+      m_thread_queue = new SPSCQueue<DynamicInstruction*>(Sim()->getCfg()->getInt("perf_model/core/own_thread_queue_size"));
+
+      registerStatsMetric("performance_model", core->getId(), "thread_queue_instructions", &m_thread_queue_pushed);
+      registerStatsMetric("performance_model", core->getId(), "thread_queue_occupancy", &m_thread_queue_occupancy);
+      registerStatsMetric("performance_model", core->getId(), "thread_queue_full", &m_thread_queue_full);
+      registerStatsMetric("performance_model", core->getId(), "thread_queue_stall_host_time", &m_thread_queue_stall_time);
+      registerStatsMetric("performance_model", core->getId(), "thread_idle_host_time", &m_thread_queue_idle_time);
+   }
+   else if (Sim()->getCfg()->getBool("perf_model/core/own_thread"))
+   {
+      LOG_PRINT_WARNING_ONCE("perf_model/core/own_thread is not supported on SMT cores, their performance models run on the functional thread");
+   }
 }
 
 PerformanceModel::~PerformanceModel()
@@ -97,6 +131,17 @@ PerformanceModel::~PerformanceModel()
    delete m_fastforward_model;
    if (m_instruction_tracer)
       delete m_instruction_tracer;
+   if (m_thread_queue)
+   {
+      while (!m_thread_queue->empty())
+      {
+         delete m_thread_queue->front();
+         m_thread_queue->pop();
+      }
+      delete m_thread_queue;
+   }
+   for(std::deque<PendingPseudoInstruction>::iterator it = m_pseudo_queue.begin(); it != m_pseudo_queue.end(); ++it)
+      delete it->instruction;
 }
 
 void PerformanceModel::enable()
@@ -119,6 +164,14 @@ void PerformanceModel::countInstructions(IntPtr address, UInt32 count)
    {
       m_fastforward_model->countInstructions(address, count);
    }
+   else if (m_fastforward_model->isMemoEnabled())
+   {
+      // Let the fast-forward model learn the detailed timing of each basic block
+      if (m_enabled)
+         m_fastforward_model->recordBasicBlock(address, count);
+      else
+         m_fastforward_model->invalidateMemoRecording();
+   }
 }
 
 void PerformanceModel::handleMemoryLatency(SubsecondTime latency, HitWhere::where_t hit_where)
@@ -161,7 +214,12 @@ void PerformanceModel::queuePseudoInstruction(PseudoInstruction *i)
       return;
    }
 
-   if (i->isIdle())
+   if (m_own_thread && !m_fastforward)
+   {
+      // Elapsed time belongs to the timing thread, idle time is accounted there as well
+      pushOwnThread(i);
+   }
+   else if (i->isIdle())
    {
       handleIdleInstruction(i);
       delete i;
@@ -174,11 +232,7 @@ void PerformanceModel::queuePseudoInstruction(PseudoInstruction *i)
       }
       else
       {
-         #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-            m_instruction_queue.push_wait(createDynamicInstruction(i, 0));
-         #else
-            m_instruction_queue.push(createDynamicInstruction(i, 0));
-         #endif
+         m_instruction_queue.push(createDynamicInstruction(i, 0));
       }
    }
 }
@@ -193,11 +247,140 @@ void PerformanceModel::queueInstruction(DynamicInstruction *ins)
       return;
    }
 
-   #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-      m_instruction_queue.push_wait(ins);
-   #else
+   if (m_own_thread)
+      pushOwnThread(ins);
+   else
       m_instruction_queue.push(ins);
-   #endif
+}
+
+void PerformanceModel::pushOwnThread(DynamicInstruction *ins)
+{
+   m_thread_queue_occupancy += m_thread_queue->size();
+
+   if (m_thread_queue->full())
+   {
+      // Back-pressure: the timing thread is behind, or is waiting at a synchronization barrier
+      ++m_thread_queue_full;
+      UInt64 t_start = Timer::now();
+      while (m_thread_queue->full())
+         sched_yield();
+      m_thread_queue_stall_time += SubsecondTime::NS(Timer::now() - t_start);
+   }
+
+   m_thread_queue->push(ins);
+   __atomic_store_n(&m_thread_queue_pushed, m_thread_queue_pushed + 1, __ATOMIC_RELEASE);
+}
+
+void PerformanceModel::pushOwnThread(PseudoInstruction *i)
+{
+   PendingPseudoInstruction pending;
+   pending.instruction = i;
+   if (Sim()->getCoreManager()->amiCoreThread())
+      // Queued while handling an instruction (e.g. a TLB miss): handle it right after that instruction
+      pending.position = __atomic_load_n(&m_thread_queue_done, __ATOMIC_RELAXED);
+   else
+      // After everything the functional thread has queued so far
+      pending.position = __atomic_load_n(&m_thread_queue_pushed, __ATOMIC_ACQUIRE);
+
+   ScopedLock sl(m_pseudo_lock);
+   m_pseudo_queue.push_back(pending);
+   __atomic_add_fetch(&m_pseudo_pending, 1, __ATOMIC_RELEASE);
+}
+
+void PerformanceModel::drain()
+{
+   if (!m_own_thread)
+      return;
+   if (__atomic_load_n(&m_thread_queue_done, __ATOMIC_ACQUIRE) == m_thread_queue_pushed && __atomic_load_n(&m_pseudo_pending, __ATOMIC_ACQUIRE) == 0)
+      return;
+
+   UInt64 t_start = Timer::now();
+   while (__atomic_load_n(&m_thread_queue_done, __ATOMIC_ACQUIRE) != m_thread_queue_pushed || __atomic_load_n(&m_pseudo_pending, __ATOMIC_ACQUIRE) != 0)
+      sched_yield();
+   m_thread_queue_stall_time += SubsecondTime::NS(Timer::now() - t_start);
+}
+
+bool PerformanceModel::handleOwnThreadPseudoInstructions()
+{
+   UInt64 done = __atomic_load_n(&m_thread_queue_done, __ATOMIC_RELAXED);
+   bool handled = false;
+
+   while (true)
+   {
+      PseudoInstruction *i;
+      {
+         ScopedLock sl(m_pseudo_lock);
+         if (m_pseudo_queue.empty() || m_pseudo_queue.front().position > done)
+            return handled;
+         i = m_pseudo_queue.front().instruction;
+         m_pseudo_queue.pop_front();
+      }
+
+      if (i->isIdle())
+      {
+         handleIdleInstruction(i);
+         delete i;
+      }
+      else
+      {
+         handleQueuedInstruction(createDynamicInstruction(i, 0));
+      }
+
+      // Only count it as handled now, drain() waits for this
+      __atomic_sub_fetch(&m_pseudo_pending, 1, __ATOMIC_RELEASE);
+      handled = true;
+   }
+}
+
+void PerformanceModel::runOwnThread(const volatile bool *cont)
+{
+   UInt32 idle_spins = 0;
+   UInt64 idle_start = 0;
+
+   while (*cont)
+   {
+      if (__atomic_load_n(&m_pseudo_pending, __ATOMIC_ACQUIRE) && handleOwnThreadPseudoInstructions())
+         synchronize();
+
+      if (m_thread_queue->empty())
+      {
+         // Cores can be idle for a long time (outside the ROI, or while their thread is stalled): yield for a while, then sleep
+         if (idle_spins++ == 0)
+            idle_start = Timer::now();
+         if (idle_spins < 1000)
+            sched_yield();
+         else
+            usleep(100);
+         continue;
+      }
+      if (idle_spins)
+      {
+         m_thread_queue_idle_time += SubsecondTime::NS(Timer::now() - idle_start);
+         idle_spins = 0;
+      }
+
+      DynamicInstruction *ins = m_thread_queue->front();
+      m_thread_queue->pop();
+
+      handleQueuedInstruction(ins);
+      __atomic_store_n(&m_thread_queue_done, m_thread_queue_done + 1, __ATOMIC_RELEASE);
+
+      // Time only advances here, so this is where we wait at the barrier (and the queue fills up behind us)
+      synchronize();
+   }
+}
+
+void PerformanceModel::handleQueuedInstruction(DynamicInstruction *ins)
+{
+   if (!m_fastforward && m_enabled)
+   {
+      handleInstruction(ins);
+      if (m_fastforward_model->isMemoEnabled())
+         for(UInt32 i = 0; i < ins->num_memory; ++i)
+            m_fastforward_model->recordMemoryAccess(ins->memory_info[i].hit_where);
+   }
+
+   delete ins;
 }
 
 void PerformanceModel::handleIdleInstruction(PseudoInstruction *instruction)
@@ -293,22 +476,24 @@ void PerformanceModel::handleIdleInstruction(PseudoInstruction *instruction)
 
 void PerformanceModel::iterate()
 {
-   while (m_instruction_queue.size() > 0)
+   SelfProfile::Scope profile(SelfProfile::CORE);
+
+   if (m_own_thread)
    {
-      // While the functional thread is waiting because of clock skew minimization, wait here as well
-      #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-      while(m_hold)
-         sched_yield();
-      #endif
+      // The timing thread handles the queue, and synchronizes as it advances time.
+      // Outside of detailed mode, it has nothing to do and the functional thread synchronizes itself.
+      if (m_fastforward || !m_enabled)
+         synchronize();
+      return;
+   }
 
+   while (m_instruction_queue.size() > 0)
+   {
       DynamicInstruction *ins = m_instruction_queue.front();
 
       LOG_ASSERT_ERROR(!ins->instruction->isIdle(), "Idle instructions should not make it here!");
 
-      if (!m_fastforward && m_enabled)
-         handleInstruction(ins);
-
-      delete ins;
+      handleQueuedInstruction(ins);
 
       m_instruction_queue.pop();
    }
@@ -3,13 +3,15 @@
 // This class represents the actual performance model for a given core
 
 #include "fixed_types.h"
-#include "mt_circular_queue.h"
+#include "circular_queue.h"
+#include "spsc_queue.h"
 #include "lock.h"
 #include "subsecond_time.h"
 #include "instruction_tracer.h"
 #include "hit_where.h"
 
 #include <queue>
+#include <deque>
 #include <iostream>
 
 // Forward Decls
@@ -33,6 +35,16 @@ public:
    void iterate();
    virtual void synchronize();
 
+   // With perf_model/core/own_thread, instructions are handed to the core's timing thread (CoreThread) through a
+   // lock-free queue, and only that thread calls handleInstruction. The functional thread blocks when the queue is full,
+   // so a timing thread waiting at a synchronization barrier also holds back its functional thread.
+   bool hasOwnThread() const { return m_own_thread; }
+   // Called by the timing thread: handle queued instructions until *cont becomes false
+   void runOwnThread(const volatile bool *cont);
+   // Called by the functional thread: wait until the timing thread has handled everything queued so far,
+   // so that getElapsedTime() is up to date (no-op without own_thread)
+   void drain();
+
    UInt64 getInstructionCount() const { return m_instruction_count; }
 
    SubsecondTime getElapsedTime() const { return m_elapsed_time.getElapsedTime(); }
@@ -64,7 +76,6 @@ public:
    void disable();
    void enable();
    bool isEnabled() { return m_enabled; }
-   void setHold(bool hold) { m_hold = hold; }
 
    bool isFastForward() { return m_fastforward; }
    void setFastForward(bool fastforward, bool detailed_sync = true)
@@ -91,11 +102,7 @@ protected:
    void incrementElapsedTime(SubsecondTime time) { m_elapsed_time.addLatency(time); }
    void incrementIdleElapsedTime(SubsecondTime time);
 
-   #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-      typedef MTCircularQueue<DynamicInstruction*> InstructionQueue;
-   #else
-      typedef CircularQueue<DynamicInstruction*> InstructionQueue;
-   #endif
+   typedef CircularQueue<DynamicInstruction*> InstructionQueue;
 
    Core* getCore() { return m_core; }
 
@@ -104,6 +111,11 @@ private:
    // Simulate a single instruction
    virtual void handleInstruction(DynamicInstruction *instruction) = 0;
 
+   void handleQueuedInstruction(DynamicInstruction *instruction);
+   void pushOwnThread(DynamicInstruction *instruction);
+   void pushOwnThread(PseudoInstruction *instruction);
+   bool handleOwnThreadPseudoInstructions();
+
    // When time is jumped ahead outside of control of the performance model (synchronization instructions, etc.)
    // notify it here. This may be used to synchronize internal time or to flush various instruction queues
    virtual void notifyElapsedTimeUpdate() {}
@@ -120,8 +132,6 @@ private:
    FastforwardPerformanceModel* m_fastforward_model;
    bool m_detailed_sync;
 
-   bool m_hold;
-
 protected:
    UInt64 m_instruction_count;
 
@@ -145,6 +155,27 @@ private:
 
    InstructionQueue m_instruction_queue;
 
+   // Pseudo instructions can be queued from any thread (including the timing thread itself), so they do not go through
+   // the single-producer queue but through a locked list. Each is tagged with the number of queued instructions it should
+   // follow, which keeps them in order with the instructions of the functional thread.
+   struct PendingPseudoInstruction
+   {
+      UInt64 position;
+      PseudoInstruction *instruction;
+   };
+
+   const bool m_own_thread;
+   SPSCQueue<DynamicInstruction*> *m_thread_queue;   //< Functional thread -> timing thread (NULL without own_thread)
+   UInt64 m_thread_queue_pushed;                    //< Written by the functional thread only
+   UInt64 m_thread_queue_done;                      //< Instructions fully handled, written by the timing thread only
+   Lock m_pseudo_lock;
+   std::deque<PendingPseudoInstruction> m_pseudo_queue;
+   UInt32 m_pseudo_pending;                         //< Queued and not yet fully handled, read without the lock
+   UInt64 m_thread_queue_occupancy;                 //< Sum of the queue occupancy seen by each push (average = occupancy / instructions)
+   UInt64 m_thread_queue_full;                      //< Pushes that had to wait for space
+   SubsecondTime m_thread_queue_stall_time;         //< Host time the functional thread waited for space or for drain()
+   SubsecondTime m_thread_queue_idle_time;          //< Host time the timing thread found nothing to do
+
    UInt32 m_current_ins_index;
 
    BranchPredictor *m_bp;
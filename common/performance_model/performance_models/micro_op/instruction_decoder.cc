@@ -10,31 +10,48 @@ extern "C" {
 }
 
 
-void InstructionDecoder::addSrcs(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (*it != XED_REG_INVALID) {
-         xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
-         if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addSourceRegister(reg, String(xed_reg_enum_t2str(reg)));
+std::vector<InstructionDecoder::RegisterInfo> InstructionDecoder::buildRegisterInfo()
+{
+   std::vector<RegisterInfo> registers(XED_REG_LAST);
+   for(unsigned int r = 0; r < XED_REG_LAST; ++r) {
+      RegisterInfo &info = registers[r];
+      info.valid = false;
+      info.reg = XED_REG_INVALID;
+      if (r != XED_REG_INVALID) {
+         info.reg = xed_get_largest_enclosing_register((xed_reg_enum_t)r);
+         info.valid = info.reg != XED_REG_EIP && info.reg != XED_REG_RIP; // eip/rip is known at decode time, shouldn't be a dependency
+         info.name = String(xed_reg_enum_t2str(info.reg));
       }
+   }
+   return registers;
 }
 
-void InstructionDecoder::addAddrs(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (*it != XED_REG_INVALID) {
-         xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
-         if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addAddressRegister(reg, String(xed_reg_enum_t2str(reg)));
-      }
+const std::vector<InstructionDecoder::RegisterInfo>& InstructionDecoder::getRegisterInfo()
+{
+   // Built once for all registers, rather than looking up every operand of every uop
+   static const std::vector<RegisterInfo> s_registers = buildRegisterInfo();
+   return s_registers;
 }
 
-void InstructionDecoder::addDsts(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (*it != XED_REG_INVALID) {
-         xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
-         if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addDestinationRegister(reg, String(xed_reg_enum_t2str(reg)));
-      }
+void InstructionDecoder::addSrcs(const RegisterSet &regs, MicroOp * currentMicroOp) {
+   const std::vector<RegisterInfo> &registers = getRegisterInfo();
+   for(unsigned int r = regs.first(); r != RegisterSet::END; r = regs.next(r))
+      if (registers[r].valid)
+         currentMicroOp->addSourceRegister(registers[r].reg, registers[r].name);
+}
+
+void InstructionDecoder::addAddrs(const RegisterSet &regs, MicroOp * currentMicroOp) {
+   const std::vector<RegisterInfo> &registers = getRegisterInfo();
+   for(unsigned int r = regs.first(); r != RegisterSet::END; r = regs.next(r))
+      if (registers[r].valid)
+         currentMicroOp->addAddressRegister(registers[r].reg, registers[r].name);
+}
+
+void InstructionDecoder::addDsts(const RegisterSet &regs, MicroOp * currentMicroOp) {
+   const std::vector<RegisterInfo> &registers = getRegisterInfo();
+   for(unsigned int r = regs.first(); r != RegisterSet::END; r = regs.next(r))
+      if (registers[r].valid)
+         currentMicroOp->addDestinationRegister(registers[r].reg, registers[r].name);
 }
 
 unsigned int InstructionDecoder::getNumExecs(const xed_decoded_inst_t *ins, int numLoads, int numStores)
@@ -92,9 +109,9 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address, co
 {
    // Determine register dependencies and number of microops per type
 
-   std::vector<std::set<xed_reg_enum_t> > regs_loads, regs_stores;
-   std::set<xed_reg_enum_t> regs_mem, regs_src, regs_dst;
-   std::vector<uint16_t> memop_load_size, memop_store_size;
+   RegisterSet regs_loads[MAX_MEMORY_OPERANDS], regs_stores[MAX_MEMORY_OPERANDS];
+   RegisterSet regs_mem, regs_src, regs_dst;
+   uint16_t memop_load_size[MAX_MEMORY_OPERANDS], memop_store_size[MAX_MEMORY_OPERANDS];
 
    int numLoads = 0;
    int numExecs = 0;
@@ -103,25 +120,26 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address, co
    // Ignore memory-referencing operands in NOP instructions
    if (!xed_decoded_inst_get_attribute(ins, XED_ATTRIBUTE_NOP))
    {
+      LOG_ASSERT_ERROR(xed_decoded_inst_number_of_memory_operands(ins) <= MAX_MEMORY_OPERANDS, "Too many memory operands, increase MAX_MEMORY_OPERANDS(%d)", MAX_MEMORY_OPERANDS);
       for(uint32_t mem_idx = 0; mem_idx < xed_decoded_inst_number_of_memory_operands(ins); ++mem_idx)
       {
-         std::set<xed_reg_enum_t> regs;
+         RegisterSet regs;
          regs.insert(xed_decoded_inst_get_base_reg(ins, mem_idx));
          regs.insert(xed_decoded_inst_get_index_reg(ins, mem_idx));
 
          if (xed_decoded_inst_mem_read(ins, mem_idx)) {
-            regs_loads.push_back(regs);
-            memop_load_size.push_back(xed_decoded_inst_get_memory_operand_length(ins, mem_idx));
+            regs_loads[numLoads] = regs;
+            memop_load_size[numLoads] = xed_decoded_inst_get_memory_operand_length(ins, mem_idx);
             numLoads++;
          }
 
          if (xed_decoded_inst_mem_written(ins, mem_idx)) {
-            regs_stores.push_back(regs);
-            memop_store_size.push_back(xed_decoded_inst_get_memory_operand_length(ins, mem_idx));
+            regs_stores[numStores] = regs;
+            memop_store_size[numStores] = xed_decoded_inst_get_memory_operand_length(ins, mem_idx);
             numStores++;
          }
 
-         regs_mem.insert(regs.begin(), regs.end());
+         regs_mem.insert(regs);
       }
    }
 
@@ -139,7 +157,7 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address, co
       if (name == XED_OPERAND_AGEN)
       {
          /* LEA instruction */
-         regs_src.insert(regs_mem.begin(), regs_mem.end());
+         regs_src.insert(regs_mem);
       }
       else if (xed_operand_is_register(name))
       {
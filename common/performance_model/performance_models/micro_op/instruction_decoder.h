@@ -2,22 +2,35 @@
 #define INSTRUCTION_INFO_HPP_
 
 #include "fixed_types.h"
+#include "register_set.h"
 
 extern "C" {
 #include <xed-decoded-inst.h>
 }
 
 #include <vector>
-#include <set>
 
 class Instruction;
 class MicroOp;
 
 class InstructionDecoder {
 private:
-   static void addSrcs(std::set<xed_reg_enum_t> regs, MicroOp *uop);
-   static void addAddrs(std::set<xed_reg_enum_t> regs, MicroOp *uop);
-   static void addDsts(std::set<xed_reg_enum_t> regs, MicroOp *uop);
+   static const unsigned int MAX_MEMORY_OPERANDS = 4;
+
+   // What a XED register turns into as a uop operand: its largest enclosing register and that register's name.
+   // Invalid registers and the instruction pointer (known at decode time) are not operands.
+   struct RegisterInfo
+   {
+      bool valid;
+      xed_reg_enum_t reg;
+      String name;
+   };
+   static const std::vector<RegisterInfo>& getRegisterInfo();
+   static std::vector<RegisterInfo> buildRegisterInfo();
+
+   static void addSrcs(const RegisterSet &regs, MicroOp *uop);
+   static void addAddrs(const RegisterSet &regs, MicroOp *uop);
+   static void addDsts(const RegisterSet &regs, MicroOp *uop);
    static unsigned int getNumExecs(const xed_decoded_inst_t *ins, int numLoads, int numStores);
 public:
    static const std::vector<const MicroOp*>* decode(IntPtr address, const xed_decoded_inst_t *ins, Instruction *ins_ptr);
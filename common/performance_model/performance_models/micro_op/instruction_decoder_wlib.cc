@@ -2,8 +2,12 @@
 #include "instruction.h"
 #include "micro_op.h"
 #include "simulator.h"
+#include "lock.h"
 #include <x86_decoder.h>  // TODO delete
 
+#include <cstring>
+#include <map>
+
 //extern "C" {
 //#include <xed-reg-class.h>
 //#if PIN_REV >= 62732
@@ -11,37 +15,106 @@
 //#endif
 //}
 
-void InstructionDecoder::addSrcs(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+InstructionDecoder::RegisterInfo InstructionDecoder::makeRegisterInfo(dl::Decoder::decoder_reg reg)
+{
    dl::Decoder *dec = Sim()->getDecoder();
-
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (!(Sim()->getDecoder()->invalid_register(*it))) {
-         dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
-         if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addSourceRegister(reg, String(dec->reg_name(reg)));
-      }
+   RegisterInfo info;
+   info.valid = false;
+   info.reg = dl::Decoder::DL_REG_INVALID;
+   if (!dec->invalid_register(reg)) {
+      info.reg = dec->largest_enclosing_register(reg);
+      info.valid = !dec->reg_is_program_counter(info.reg); // eip/rip is known at decode time, shouldn't be a dependency
+   }
+   return info;
 }
 
-void InstructionDecoder::addAddrs(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+std::vector<InstructionDecoder::RegisterInfo> InstructionDecoder::buildRegisterInfo()
+{
    dl::Decoder *dec = Sim()->getDecoder();
+   std::vector<RegisterInfo> registers;
+   for(dl::Decoder::decoder_reg reg = 0; reg <= dec->last_reg(); ++reg)
+      registers.push_back(makeRegisterInfo(reg));
+   return registers;
+}
 
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (!(dec->invalid_register(*it))) {
-         dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
-         if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addAddressRegister(reg, String(dec->reg_name(reg)));
-      }
+const std::vector<InstructionDecoder::RegisterInfo>& InstructionDecoder::getRegisterInfo()
+{
+   // Built once for all registers of the decoder, rather than querying it for every operand of every uop
+   static const std::vector<RegisterInfo> s_registers = buildRegisterInfo();
+   return s_registers;
 }
 
-void InstructionDecoder::addDsts(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+std::vector<String> InstructionDecoder::buildRegisterNames()
+{
    dl::Decoder *dec = Sim()->getDecoder();
+   const std::vector<RegisterInfo> &registers = getRegisterInfo();
+   std::vector<String> names(registers.size());
+   for(std::vector<RegisterInfo>::const_iterator it = registers.begin(); it != registers.end(); ++it)
+      if (it->valid && it->reg < names.size())
+         names[it->reg] = String(dec->reg_name(it->reg));
+   return names;
+}
 
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
-      if (!(dec->invalid_register(*it))) {
-         dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
-         if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addDestinationRegister(reg, String(dec->reg_name(reg)));
+const std::vector<String>& InstructionDecoder::getRegisterNames()
+{
+   static const std::vector<String> s_names = buildRegisterNames();
+   return s_names;
+}
+
+const String& InstructionDecoder::getRegisterName(dl::Decoder::decoder_reg reg)
+{
+   const std::vector<String> &names = getRegisterNames();
+   if (reg < names.size())
+      return names[reg];
+
+   // Beyond the decoder's last register: keep the name around, so a reference to it can be returned
+   static Lock s_lock;
+   static std::map<dl::Decoder::decoder_reg, String> s_names;
+   ScopedLock sl(s_lock);
+   std::map<dl::Decoder::decoder_reg, String>::iterator it = s_names.find(reg);
+   if (it == s_names.end())
+      it = s_names.insert(std::make_pair(reg, String(Sim()->getDecoder()->reg_name(reg)))).first;
+   return it->second;
+}
+
+void InstructionDecoder::addList(const RegisterSet &regs, unsigned int list, Analysis &analysis)
+{
+   const std::vector<RegisterInfo> &registers = getRegisterInfo();
+   // Lists are added in order, each one starts where the previous one ended
+   unsigned int count = analysis.listStart[list];
+
+   for(unsigned int r = regs.first(); r != RegisterSet::END; r = regs.next(r)) {
+      // Point into the table, only registers beyond it are looked up in the decoder
+      const RegisterInfo *info;
+      RegisterInfo fallback;
+      if (r < registers.size()) {
+         info = &registers[r];
+      } else {
+         fallback = makeRegisterInfo(r);
+         info = &fallback;
+      }
+      if (info->valid) {
+         LOG_ASSERT_ERROR(count < Analysis::MAX_REGISTERS, "Too many register operands, increase Analysis::MAX_REGISTERS(%d)", Analysis::MAX_REGISTERS);
+         LOG_ASSERT_ERROR(info->reg <= 0xffff, "Register %u does not fit in an Analysis", info->reg);
+         analysis.regs[count++] = info->reg;
       }
+   }
+   analysis.listStart[list + 1] = count;
+}
+
+void InstructionDecoder::addSrcs(const Analysis &analysis, unsigned int list, MicroOp * currentMicroOp) {
+   for(unsigned int idx = analysis.listStart[list]; idx < analysis.listStart[list + 1]; ++idx)
+      currentMicroOp->addSourceRegister(analysis.regs[idx], getRegisterName(analysis.regs[idx]));
+}
+
+void InstructionDecoder::addAddrs(const Analysis &analysis, unsigned int list, MicroOp * currentMicroOp) {
+   for(unsigned int idx = analysis.listStart[list]; idx < analysis.listStart[list + 1]; ++idx)
+      currentMicroOp->addAddressRegister(analysis.regs[idx], getRegisterName(analysis.regs[idx]));
+}
+
+void InstructionDecoder::addDsts(const Analysis &analysis, unsigned int list, MicroOp * currentMicroOp) {
+   for(unsigned int idx = analysis.listStart[list]; idx < analysis.listStart[list + 1]; ++idx)
+      currentMicroOp->addDestinationRegister(analysis.regs[idx], getRegisterName(analysis.regs[idx]));
 }
 
 unsigned int InstructionDecoder::getNumExecs(const dl::DecodedInst *ins, int numLoads, int numStores)
@@ -54,14 +127,16 @@ unsigned int InstructionDecoder::getNumExecs(const dl::DecodedInst *ins, int num
  ///// IMPLEMENTATION OF INSTRUCTIONS /////
 //////////////////////////////////////////
 
-const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  const dl::DecodedInst *ins, Instruction *ins_ptr)
+void InstructionDecoder::analyze(const dl::DecodedInst *ins, Analysis &analysis)
 {
    dl::Decoder *dec = Sim()->getDecoder();
    // Determine register dependencies and number of microops per type
 
-   std::vector<std::set<dl::Decoder::decoder_reg> > regs_loads, regs_stores;
-   std::set<dl::Decoder::decoder_reg> regs_mem, regs_src, regs_dst;
-   std::vector<uint16_t> memop_load_size, memop_store_size;
+   RegisterSet regs_loads[MAX_MEMORY_OPERANDS], regs_stores[MAX_MEMORY_OPERANDS];
+   RegisterSet regs_mem, regs_src, regs_dst;
+
+   // Zero everything, including padding, so identical instructions give identical bytes in the decode cache
+   memset(&analysis, 0, sizeof(analysis));
 
    int numLoads = 0;
    int numExecs = 0;
@@ -70,38 +145,35 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
    // Ignore memory-referencing operands in NOP instructions
    if (!(ins->is_nop()))
    {
+      LOG_ASSERT_ERROR(dec->num_memory_operands(ins) <= MAX_MEMORY_OPERANDS, "Too many memory operands, increase MAX_MEMORY_OPERANDS(%d)", MAX_MEMORY_OPERANDS);
       for(uint32_t mem_idx = 0; mem_idx < dec->num_memory_operands(ins); ++mem_idx)
       {
-         std::set<dl::Decoder::decoder_reg> regs;
+         RegisterSet regs;
          regs.insert(dec->mem_base_reg(ins, mem_idx));
          regs.insert(dec->mem_index_reg(ins, mem_idx));
 
          if (dec->op_read_mem(ins, mem_idx)) {
-            regs_loads.push_back(regs);
-            memop_load_size.push_back(dec->size_mem_op(ins, mem_idx));
+            regs_loads[numLoads] = regs;
+            analysis.loadSize[numLoads] = dec->size_mem_op(ins, mem_idx);
             numLoads++;
          }
 
          if (dec->op_write_mem(ins, mem_idx)) {
-            regs_stores.push_back(regs);
-            memop_store_size.push_back(dec->size_mem_op(ins, mem_idx));
+            regs_stores[numStores] = regs;
+            analysis.storeSize[numStores] = dec->size_mem_op(ins, mem_idx);
             numStores++;
          }
 
-         regs_mem.insert(regs.begin(), regs.end());
+         regs_mem.insert(regs);
       }
    }
 
-   bool is_atomic = false;
-   if (ins->is_atomic())
-      is_atomic = true;
-
    for(uint32_t idx = 0; idx < dec->num_operands(ins); ++idx)
    {
       if (dec->is_addr_gen(ins, idx))
       {
          /* LEA-like instruction */
-         regs_src.insert(regs_mem.begin(), regs_mem.end());
+         regs_src.insert(regs_mem);
       }
       else if (dec->op_is_reg(ins, idx))  
       {
@@ -127,25 +199,60 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
 
    numExecs = getNumExecs(ins, numLoads, numStores);
 
+   // FIXME: 
+   // Capstone bug: random incorrect disassembly --> ldr x1, [x0] to ldr w1, #0x7faa399350
+   // Only happening once. Treat that load as an exec instruction.
+   if (numLoads + numExecs + numStores == 0)
+     numExecs = 1;
+
+   LOG_ASSERT_ERROR(numExecs <= 2, "More than 2 exec uops"); 
+
+   analysis.numLoads = numLoads;
+   analysis.numExecs = numExecs;
+   analysis.numStores = numStores;
+
+   for(unsigned int idx = 0; idx < MAX_MEMORY_OPERANDS; ++idx)
+      addList(regs_loads[idx], Analysis::LIST_LOAD + idx, analysis);
+   for(unsigned int idx = 0; idx < MAX_MEMORY_OPERANDS; ++idx)
+      addList(regs_stores[idx], Analysis::LIST_STORE + idx, analysis);
+   addList(regs_src, Analysis::LIST_SRC, analysis);
+   addList(regs_dst, Analysis::LIST_DST, analysis);
+
    // Determine some extra instruction characteristics that will affect timing
 
+   analysis.opcode = ins->inst_num_id();
    // Determine instruction operand width
-   uint16_t operand_size = dec->get_operand_size(ins);
+   analysis.operandSize = dec->get_operand_size(ins);
+
+   if (ins->is_atomic())
+      analysis.flags |= Analysis::IS_ATOMIC;
+   if (ins->is_barrier())
+      analysis.flags |= Analysis::IS_BARRIER;
+   if (ins->is_serializing())
+      analysis.flags |= Analysis::IS_SERIALIZING;
+   if (ins->is_X87())
+      analysis.flags |= Analysis::IS_X87;
+   if (ins->is_conditional_branch())
+      analysis.flags |= Analysis::IS_CONDITIONAL_BRANCH;
+   if (ins->src_dst_merge())
+      analysis.flags |= Analysis::SRC_DST_MERGE;
+}
 
+const std::vector<const MicroOp*>* InstructionDecoder::build(IntPtr address, const dl::DecodedInst *ins, Instruction *ins_ptr, const Analysis &analysis)
+{
+   dl::Decoder *dec = Sim()->getDecoder();
 
-   bool is_serializing = ins->is_serializing();
+   const int numLoads = analysis.numLoads;
+   const int numExecs = analysis.numExecs;
+   const int numStores = analysis.numStores;
+   const bool is_atomic = analysis.flags & Analysis::IS_ATOMIC;
+   const String opcode_name = dec->inst_name(analysis.opcode);
 
    // Generate list of microops
 
    std::vector<const MicroOp*> *uops = new std::vector<const MicroOp*>(); //< Return value
    int totalMicroOps = numLoads + numExecs + numStores;
-   // FIXME: 
-   // Capstone bug: random incorrect disassembly --> ldr x1, [x0] to ldr w1, #0x7faa399350
-   // Only happening once. Treat that load as an exec instruction.
-   if (totalMicroOps == 0) {
-     numExecs = totalMicroOps = 1;
-   }
-   
+
    for(int index = 0; index < totalMicroOps; ++index)
    {
       MicroOp *currentMicroOp = new MicroOp();
@@ -153,7 +260,7 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
       currentMicroOp->setInstructionPointer(Memory::make_access(address));
       
       // Extra information on all micro ops 
-      currentMicroOp->setOperandSize(operand_size);
+      currentMicroOp->setOperandSize(analysis.operandSize);
       currentMicroOp->setInstruction(ins_ptr);
       currentMicroOp->setDecodedInstruction(ins);
       // We don't necessarily know the address at this point as it could
@@ -164,21 +271,20 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
          size_t loadIndex = index;
          currentMicroOp->makeLoad(
                  loadIndex
-               , ins->inst_num_id()
-               , dec->inst_name(ins->inst_num_id())
-               , memop_load_size[loadIndex]
+               , analysis.opcode
+               , opcode_name
+               , analysis.loadSize[loadIndex]
                );
       }
       else if (index < numLoads + numExecs) /* EXEC */
       {      
          size_t execIndex = index - numLoads;
-         LOG_ASSERT_ERROR(numExecs <= 2, "More than 2 exec uops"); 
          currentMicroOp->makeExecute(
                  execIndex
                , numLoads
-               , ins->inst_num_id()
-               , dec->inst_name(ins->inst_num_id())
-               , ins->is_conditional_branch() /* is conditional branch? */);
+               , analysis.opcode
+               , opcode_name
+               , analysis.flags & Analysis::IS_CONDITIONAL_BRANCH /* is conditional branch? */);
       }
       else /* STORE */
       {      
@@ -186,9 +292,9 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
          currentMicroOp->makeStore(
                  storeIndex
                , numExecs
-               , ins->inst_num_id()
-               , dec->inst_name(ins->inst_num_id())
-               , memop_store_size[storeIndex]
+               , analysis.opcode
+               , opcode_name
+               , analysis.storeSize[storeIndex]
                );
          if (is_atomic)
             currentMicroOp->setMemBarrier(true);
@@ -199,47 +305,47 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
       if (index < numLoads) /* LOAD */
       {      
          size_t loadIndex = index;
-         addSrcs(regs_loads[loadIndex], currentMicroOp);
-         addAddrs(regs_loads[loadIndex], currentMicroOp);
+         addSrcs(analysis, Analysis::LIST_LOAD + loadIndex, currentMicroOp);
+         addAddrs(analysis, Analysis::LIST_LOAD + loadIndex, currentMicroOp);
 
          if (numExecs == 0) {
             // No execute microop: we inherit its read operands
-            addSrcs(regs_src, currentMicroOp);
+            addSrcs(analysis, Analysis::LIST_SRC, currentMicroOp);
             if (numStores == 0)
                // No store microop either: we also inherit its write operands
-               addDsts(regs_dst, currentMicroOp);
+               addDsts(analysis, Analysis::LIST_DST, currentMicroOp);
          }
 
       }
 
       else if (index < numLoads + numExecs) /* EXEC */
       {      
-         addSrcs(regs_src, currentMicroOp);
-         addDsts(regs_dst, currentMicroOp);
+         addSrcs(analysis, Analysis::LIST_SRC, currentMicroOp);
+         addDsts(analysis, Analysis::LIST_DST, currentMicroOp);
 
-         if (ins->is_barrier())
+         if (analysis.flags & Analysis::IS_BARRIER)
             currentMicroOp->setMemBarrier(true);
 
          // Special cases
-         if (ins->src_dst_merge())
+         if (analysis.flags & Analysis::SRC_DST_MERGE)
          {
             // In this case, we have a memory to XMM load, where the result merges the source and destination
-            addSrcs(regs_dst, currentMicroOp);
+            addSrcs(analysis, Analysis::LIST_DST, currentMicroOp);
          }
       }
 
       else /* STORE */
       {      
          size_t storeIndex = index - numLoads - numExecs;
-         addSrcs(regs_stores[storeIndex], currentMicroOp);
-         addAddrs(regs_stores[storeIndex], currentMicroOp);
+         addSrcs(analysis, Analysis::LIST_STORE + storeIndex, currentMicroOp);
+         addAddrs(analysis, Analysis::LIST_STORE + storeIndex, currentMicroOp);
 
          if (numExecs == 0) {
             // No execute microop: we inherit its write operands
-            addDsts(regs_dst, currentMicroOp);
+            addDsts(analysis, Analysis::LIST_DST, currentMicroOp);
             if (numLoads == 0)
                // No load microops either: we also inherit its read operands
-               addSrcs(regs_src, currentMicroOp);
+               addSrcs(analysis, Analysis::LIST_SRC, currentMicroOp);
          }
          if (is_atomic)
             currentMicroOp->setMemBarrier(true);
@@ -253,7 +359,7 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
          currentMicroOp->setFirst(true);
 
          // Use of x87 FPU?
-         if (ins->is_X87())
+         if (analysis.flags & Analysis::IS_X87)
             currentMicroOp->setIsX87(true);
       }
 
@@ -276,7 +382,7 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
          #endif
 
          // Check if the instruction is serializing, place the serializing flag
-         if (is_serializing)
+         if (analysis.flags & Analysis::IS_SERIALIZING)
             currentMicroOp->setSerializing(true);
       }
 
@@ -285,3 +391,10 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
 
    return uops;
 }
+
+const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address, const dl::DecodedInst *ins, Instruction *ins_ptr)
+{
+   Analysis analysis;
+   analyze(ins, analysis);
+   return build(address, ins, ins_ptr, analysis);
+}
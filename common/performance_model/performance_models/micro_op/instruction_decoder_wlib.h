@@ -2,6 +2,7 @@
 #define INSTRUCTION_INFOWLIB_HPP_
 
 #include "fixed_types.h"
+#include "register_set.h"
 
 #include <decoder.h>
 
@@ -10,19 +11,72 @@
 //}
 
 #include <vector>
-#include <set>
 
 class Instruction;
 class MicroOp;
 
 class InstructionDecoder {
-private:
-   static void addSrcs(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
-   static void addAddrs(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
-   static void addDsts(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
-   static unsigned int getNumExecs(const dl::DecodedInst *ins, int numLoads, int numStores);
 public:
+   static const unsigned int MAX_MEMORY_OPERANDS = 4;
+
+   // Everything decode() takes from the decoder to build the uops of an instruction: uop counts, memory operand sizes,
+   // flags and, per operand role, the (already mapped) registers in the order they are added to the uops.
+   // It does not depend on the instruction's address and is plain data, so the trace front-end can store it in its
+   // persistent decode cache (TraceDecodeCache) and skip the operand walk in later runs.
+   struct Analysis
+   {
+      static const unsigned int MAX_REGISTERS = 64;
+      // Bump whenever analyze() or the layout of Analysis changes, existing decode caches are then ignored
+      static const UInt32 VERSION = 1;
+
+      // Register lists: the address registers of each load and store, and the source and destination registers
+      enum { LIST_LOAD = 0, LIST_STORE = LIST_LOAD + MAX_MEMORY_OPERANDS, LIST_SRC = LIST_STORE + MAX_MEMORY_OPERANDS, LIST_DST, NUM_LISTS };
+
+      enum
+      {
+         IS_ATOMIC             = 1 << 0,
+         IS_BARRIER            = 1 << 1,
+         IS_SERIALIZING        = 1 << 2,
+         IS_X87                = 1 << 3,
+         IS_CONDITIONAL_BRANCH = 1 << 4,
+         SRC_DST_MERGE         = 1 << 5,
+      };
+
+      UInt32 opcode;
+      UInt16 operandSize;
+      UInt8 numLoads, numExecs, numStores;
+      UInt8 flags;
+      UInt16 loadSize[MAX_MEMORY_OPERANDS];
+      UInt16 storeSize[MAX_MEMORY_OPERANDS];
+      UInt8 listStart[NUM_LISTS + 1];   //< Registers of list l are regs[listStart[l] .. listStart[l+1])
+      UInt16 regs[MAX_REGISTERS];
+   };
+
+   static void analyze(const dl::DecodedInst *ins, Analysis &analysis);
+   static const std::vector<const MicroOp*>* build(IntPtr address, const dl::DecodedInst *ins, Instruction *ins_ptr, const Analysis &analysis);
    static const std::vector<const MicroOp*>* decode(IntPtr address, const dl::DecodedInst *ins, Instruction *ins_ptr);
+
+private:
+   // What a decoder register turns into as a uop operand: its largest enclosing register.
+   // Invalid registers and the program counter (known at decode time) are not operands.
+   struct RegisterInfo
+   {
+      bool valid;
+      dl::Decoder::decoder_reg reg;
+   };
+   static const std::vector<RegisterInfo>& getRegisterInfo();
+   static std::vector<RegisterInfo> buildRegisterInfo();
+   static RegisterInfo makeRegisterInfo(dl::Decoder::decoder_reg reg);
+   // Names of the registers that are used as operands, indexed by register
+   static const std::vector<String>& getRegisterNames();
+   static std::vector<String> buildRegisterNames();
+   static const String& getRegisterName(dl::Decoder::decoder_reg reg);
+
+   static void addList(const RegisterSet &regs, unsigned int list, Analysis &analysis);
+   static void addSrcs(const Analysis &analysis, unsigned int list, MicroOp *uop);
+   static void addAddrs(const Analysis &analysis, unsigned int list, MicroOp *uop);
+   static void addDsts(const Analysis &analysis, unsigned int list, MicroOp *uop);
+   static unsigned int getNumExecs(const dl::DecodedInst *ins, int numLoads, int numStores);
 };
 
 #endif /* INSTRUCTION_INFO_HPP_ */
@@ -0,0 +1,65 @@
+#ifndef __REGISTER_SET_H
+#define __REGISTER_SET_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+#include <cstring>
+
+// Fixed-width bitmask of decoder register numbers, used by InstructionDecoder instead of std::set so that
+// decoding does not allocate. Registers are visited in ascending order, the same order as a std::set.
+//
+//    for(unsigned int reg = set.first(); reg != RegisterSet::END; reg = set.next(reg))
+
+class RegisterSet
+{
+   public:
+      static const unsigned int MAX_REGISTERS = 1024;
+      static const unsigned int END = MAX_REGISTERS;
+
+      RegisterSet() { clear(); }
+
+      void clear() { memset(m_bits, 0, sizeof(m_bits)); }
+
+      void insert(unsigned int reg)
+      {
+         LOG_ASSERT_ERROR(reg < MAX_REGISTERS, "Register %u does not fit in a RegisterSet, increase MAX_REGISTERS(%u)", reg, MAX_REGISTERS);
+         m_bits[reg / WORD_BITS] |= UInt64(1) << (reg % WORD_BITS);
+      }
+      void insert(const RegisterSet &other)
+      {
+         for(unsigned int w = 0; w < WORDS; ++w)
+            m_bits[w] |= other.m_bits[w];
+      }
+      bool count(unsigned int reg) const
+      {
+         return reg < MAX_REGISTERS && (m_bits[reg / WORD_BITS] & (UInt64(1) << (reg % WORD_BITS)));
+      }
+
+      unsigned int first() const { return find(0); }
+      unsigned int next(unsigned int reg) const { return find(reg + 1); }
+
+   private:
+      static const unsigned int WORD_BITS = 64;
+      static const unsigned int WORDS = MAX_REGISTERS / WORD_BITS;
+
+      UInt64 m_bits[WORDS];
+
+      // First register in the set that is not below reg, or END
+      unsigned int find(unsigned int reg) const
+      {
+         if (reg >= MAX_REGISTERS)
+            return END;
+         unsigned int w = reg / WORD_BITS;
+         UInt64 bits = m_bits[w] & (~UInt64(0) << (reg % WORD_BITS));
+         while (bits == 0)
+         {
+            if (++w == WORDS)
+               return END;
+            bits = m_bits[w];
+         }
+         return w * WORD_BITS + __builtin_ctzll(bits);
+      }
+};
+
+#endif // __REGISTER_SET_H
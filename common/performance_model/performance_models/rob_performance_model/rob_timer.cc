@@ -17,6 +17,7 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 // Define to get per-cycle printout of dispatch, issue, writeback stages
 //#define DEBUG_PERCYCLE
@@ -25,6 +26,10 @@
 // Define to not skip any cycles, but assert that the skip logic is working fine
 //#define ASSERT_SKIP
 
+// Define to also do the full ROB walk of the original issue stage each cycle, and assert that it makes the same issue
+// decisions, stops at the same entry and sees the same next event as the event-driven issue stage
+//#define ASSERT_ISSUE_WALK
+
 RobTimer::RobTimer(
          Core *core, PerformanceModel *_perf, const CoreModel *core_model,
          int misprediction_penalty,
@@ -46,6 +51,11 @@ RobTimer::RobTimer(
          Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/issue_contention", core->getId())
          ? core_model->createRobContentionModel(core)
          : NULL)
+      , m_allocations(0)
+      , m_dependant_pool(window_size + 255, m_allocations)
+      , m_events(window_size + 255 + 1)
+      , m_first_unissued(0)
+      , m_unissued_stores(window_size)
       , now(core->getDvfsDomain())
       , frontend_stalled_until(SubsecondTime::Zero())
       , in_icache_miss(false)
@@ -63,6 +73,14 @@ RobTimer::RobTimer(
 {
 
    registerStatsMetric("rob_timer", core->getId(), "time_skipped", &time_skipped);
+   registerStatsMetric("rob_timer", core->getId(), "allocations", &m_allocations);
+
+   // Each uop is in at most one of these at a time, so they never need to grow beyond the size of the ROB
+   m_ready_queue.reserve(window_size + 255);
+   m_issue_queue.reserve(window_size + 255);
+   m_issue_queue_new.reserve(window_size + 255);
+   m_issue_queue_merged.reserve(window_size + 255);
+   m_done_queue.reserve(window_size + 255);
 
    for(int i = 0; i < MicroOp::UOP_SUBTYPE_SIZE; ++i)
    {
@@ -177,7 +195,94 @@ RobTimer::RobTimer(
 RobTimer::~RobTimer()
 {
    for(Rob::iterator it = this->rob.begin(); it != this->rob.end(); ++it)
-      it->free();
+      it->free(m_dependant_pool);
+}
+
+RobTimer::DependantPool::DependantPool(uint64_t blocks, UInt64 &allocations)
+   : m_chunk_size(blocks)
+   , m_free(NULL)
+   , m_allocations(allocations)
+{
+   m_chunks.reserve(16);
+   grow();
+   // The initial chunk is part of construction, not of steady-state simulation
+   m_allocations = 0;
+}
+
+RobTimer::DependantPool::~DependantPool()
+{
+   for(std::vector<Block*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+      delete [] *it;
+}
+
+void RobTimer::DependantPool::grow()
+{
+   Block *chunk = new Block[m_chunk_size];
+   m_chunks.push_back(chunk);
+   ++m_allocations;
+   for(uint64_t i = 0; i < m_chunk_size; ++i)
+   {
+      chunk[i].next = m_free;
+      m_free = &chunk[i];
+   }
+}
+
+RobTimer::DependantPool::Block *RobTimer::DependantPool::alloc()
+{
+   if (m_free == NULL)
+      grow();
+   Block *block = m_free;
+   m_free = block->next;
+   block->next = NULL;
+   return block;
+}
+
+void RobTimer::DependantPool::free(Block *block)
+{
+   while (block)
+   {
+      Block *next = block->next;
+      block->next = m_free;
+      m_free = block;
+      block = next;
+   }
+}
+
+RobTimer::EventTree::EventTree(uint64_t entries)
+   : m_size(1)
+{
+   while (m_size < entries)
+      m_size <<= 1;
+   m_tree.resize(2 * m_size, SubsecondTime::MaxTime());
+}
+
+void RobTimer::EventTree::set(uint64_t sequenceNumber, SubsecondTime time)
+{
+   uint64_t idx = m_size + (sequenceNumber & (m_size - 1));
+   m_tree[idx] = time;
+   for(idx >>= 1; idx > 0; idx >>= 1)
+      m_tree[idx] = std::min(m_tree[2 * idx], m_tree[2 * idx + 1]);
+}
+
+SubsecondTime RobTimer::EventTree::getMin(uint64_t first, uint64_t last) const
+{
+   LOG_ASSERT_ERROR(last - first <= m_size, "Range of %ld entries is larger than the ROB", last - first);
+   SubsecondTime result = SubsecondTime::MaxTime();
+   uint64_t begin = first & (m_size - 1), end = begin + (last - first);
+   // A range that wraps around is split in two
+   if (end > m_size)
+   {
+      result = getMin(first + (m_size - begin), last);
+      end = m_size;
+   }
+   for(begin += m_size, end += m_size; begin < end; begin >>= 1, end >>= 1)
+   {
+      if (begin & 1)
+         result = std::min(result, m_tree[begin++]);
+      if (end & 1)
+         result = std::min(result, m_tree[--end]);
+   }
+   return result;
 }
 
 void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
@@ -186,57 +291,62 @@ void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    readyMax = SubsecondTime::Zero();
    addressReady = SubsecondTime::MaxTime();
    addressReadyMax = SubsecondTime::Zero();
+   dispatched = SubsecondTime::MaxTime();
    issued = SubsecondTime::MaxTime();
    done = SubsecondTime::MaxTime();
 
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
-   addressProducers.clear();
+   numAddressProducers = 0;
 
-   numInlineDependants = 0;
-   vectorDependants = NULL;
+   numDependants = 0;
+   overflowDependants = overflowTail = NULL;
 }
 
-void RobTimer::RobEntry::free()
+void RobTimer::RobEntry::free(DependantPool &pool)
 {
    delete uop;
-   if (vectorDependants)
-      delete vectorDependants;
+   pool.free(overflowDependants);
 }
 
-void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep)
+void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep, DependantPool &pool)
 {
-   if (numInlineDependants < MAX_INLINE_DEPENDANTS)
+   if (numDependants < MAX_INLINE_DEPENDANTS)
    {
-      inlineDependants[numInlineDependants++] = dep;
+      inlineDependants[numDependants++] = dep;
    }
    else
    {
-      if (vectorDependants == NULL)
+      size_t offset = (numDependants - MAX_INLINE_DEPENDANTS) % DependantPool::BLOCK_SIZE;
+      if (offset == 0)
       {
-         vectorDependants = new std::vector<RobEntry*>();
+         DependantPool::Block *block = pool.alloc();
+         if (overflowTail)
+            overflowTail->next = block;
+         else
+            overflowDependants = block;
+         overflowTail = block;
       }
-      vectorDependants->push_back(dep);
+      overflowTail->dependants[offset] = dep;
+      ++numDependants;
    }
 }
 
-uint64_t RobTimer::RobEntry::getNumDependants() const
-{
-   return numInlineDependants + (vectorDependants ? vectorDependants->size() : 0);
-}
-
 RobTimer::RobEntry* RobTimer::RobEntry::getDependant(size_t idx) const
 {
+   LOG_ASSERT_ERROR(idx < numDependants, "Invalid idx %d", idx);
    if (idx < MAX_INLINE_DEPENDANTS)
    {
-      LOG_ASSERT_ERROR(idx < numInlineDependants, "Invalid idx %d", idx);
       return inlineDependants[idx];
    }
    else
    {
-      LOG_ASSERT_ERROR(idx - MAX_INLINE_DEPENDANTS < vectorDependants->size(), "Invalid idx %d", idx);
-      return (*vectorDependants)[idx - MAX_INLINE_DEPENDANTS];
+      idx -= MAX_INLINE_DEPENDANTS;
+      DependantPool::Block *block = overflowDependants;
+      for( ; idx >= DependantPool::BLOCK_SIZE; idx -= DependantPool::BLOCK_SIZE)
+         block = block->next;
+      return block->dependants[idx];
    }
 }
 
@@ -329,7 +439,7 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
          }
          else
          {
-            prodEntry->addDependant(entry);
+            prodEntry->addDependant(entry, m_dependant_pool);
          }
       }
 
@@ -514,6 +624,11 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
          // If uop is already ready, we may need to issue it in the following cycle
          entry->ready = std::max(entry->ready, (now + 1ul).getElapsedTime());
          next_event = std::min(next_event, entry->ready);
+         m_events.set(uop.getSequenceNumber(), entry->ready);
+         if (entry->ready != SubsecondTime::MaxTime())
+            scheduleIssue(entry);
+         if (uop.getMicroOp()->isStore())
+            m_unissued_stores.push(entry);
 
          #ifdef DEBUG_PERCYCLE
             std::cout<<"DISPATCH "<<entry->uop->getMicroOp()->toShortString()<<std::endl;
@@ -576,9 +691,31 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
       return std::min(frontend_stalled_until, next_event);
 }
 
-void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
+void RobTimer::scheduleIssue(RobEntry *entry)
+{
+   if (m_ready_queue.size() == m_ready_queue.capacity())
+      ++m_allocations;
+   m_ready_queue.push_back(ReadyEvent(entry->ready, entry));
+   std::push_heap(m_ready_queue.begin(), m_ready_queue.end(), std::greater<ReadyEvent>());
+}
+
+void RobTimer::pushDone(SubsecondTime done)
+{
+   // Completion times in the past are no longer needed by getNextCompletionTime(), drop them here so the heap
+   // stays bounded by the number of uops in flight even when no cycles are being skipped
+   while (!m_done_queue.empty() && m_done_queue.front() < now)
+   {
+      std::pop_heap(m_done_queue.begin(), m_done_queue.end(), std::greater<SubsecondTime>());
+      m_done_queue.pop_back();
+   }
+   if (m_done_queue.size() == m_done_queue.capacity())
+      ++m_allocations;
+   m_done_queue.push_back(done);
+   std::push_heap(m_done_queue.begin(), m_done_queue.end(), std::greater<SubsecondTime>());
+}
+
+void RobTimer::issueInstruction(RobEntry *entry)
 {
-   RobEntry *entry = &rob[idx];
    DynamicMicroOp &uop = *entry->uop;
 
    if ((uop.getMicroOp()->isLoad() || uop.getMicroOp()->isStore())
@@ -641,7 +778,21 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
    entry->issued = now;
    entry->done = cycle_done;
 
-   next_event = std::min(next_event, entry->done);
+   m_events.set(uop.getSequenceNumber(), entry->done);
+   pushDone(entry->done);
+
+   if (uop.getMicroOp()->isStore())
+   {
+      LOG_ASSERT_ERROR(m_unissued_stores.front() == entry, "Store %ld issued out of order", uop.getSequenceNumber());
+      m_unissued_stores.pop();
+   }
+   if (uop.getSequenceNumber() == m_first_unissued)
+   {
+      uint64_t first = rob.front().uop->getSequenceNumber();
+      do
+         ++m_first_unissued;
+      while (m_first_unissued < first + m_num_in_rob && rob[m_first_unissued - first].done != SubsecondTime::MaxTime());
+   }
 
    --m_rs_entries_used;
 
@@ -663,6 +814,12 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
       {
          depEntry->ready = depEntry->readyMax;
          //std::cout<<"    ready @ "<<depEntry->ready<<std::endl;
+         // Uops still in the pre-ROB buffer are scheduled when they are dispatched
+         if (depEntry->dispatched != SubsecondTime::MaxTime())
+         {
+            m_events.set(depEntry->uop->getSequenceNumber(), depEntry->ready);
+            scheduleIssue(depEntry);
+         }
       }
 
       // For stores, check if their address has been produced
@@ -707,38 +864,78 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
    }
 }
 
+bool RobTimer::compareSequenceNumber(const RobEntry *a, const RobEntry *b)
+{
+   return a->uop->getSequenceNumber() < b->uop->getSequenceNumber();
+}
+
 SubsecondTime RobTimer::doIssue()
 {
    uint64_t num_issued = 0;
-   SubsecondTime next_event = SubsecondTime::MaxTime();
-   bool head_of_queue = true, no_more_load = false, no_more_store = false, have_unresolved_store = false;
+   bool no_more_load = false, no_more_store = false;
 
    if (m_rob_contention)
       m_rob_contention->initCycle(now);
 
-   for(uint64_t i = 0; i < m_num_in_rob; ++i)
+   // Move uops that have become ready into the issue queue, keeping it in ROB order
+   while (!m_ready_queue.empty() && m_ready_queue.front().first <= now)
    {
-      RobEntry *entry = &rob.at(i);
-      DynamicMicroOp *uop = entry->uop;
+      m_issue_queue_new.push_back(m_ready_queue.front().second);
+      std::pop_heap(m_ready_queue.begin(), m_ready_queue.end(), std::greater<ReadyEvent>());
+      m_ready_queue.pop_back();
+   }
+   if (!m_issue_queue_new.empty())
+   {
+      std::sort(m_issue_queue_new.begin(), m_issue_queue_new.end(), compareSequenceNumber);
+      m_issue_queue_merged.clear();
+      std::merge(m_issue_queue.begin(), m_issue_queue.end(), m_issue_queue_new.begin(), m_issue_queue_new.end(),
+                 std::back_inserter(m_issue_queue_merged), compareSequenceNumber);
+      m_issue_queue.swap(m_issue_queue_merged);
+      m_issue_queue_new.clear();
+   }
 
+   // Only uops in the issue queue can issue this cycle. Walking them in ROB order, the uops in between (not ready, or
+   // already issued) only matter for whether a uop is at the head of the ROB, and for loads, whether there is an older
+   // store with an unknown address. Both can be found without visiting them.
+   // Like a walk over the whole ROB, stop at the same point: after the issue width is used up, at a serializing
+   // instruction that cannot issue yet, or for in-order cores, at the first uop that cannot issue.
+   const uint64_t first = m_num_in_rob ? rob.front().uop->getSequenceNumber() : 0;
+   const uint64_t unresolved_store = m_no_address_disambiguation && !m_issue_queue.empty() ? findUnresolvedStore() : INVALID_SEQNR;
+   uint64_t walked = m_num_in_rob;  // Number of ROB entries a walk from the head would have visited
+   bool stopped = false;
+   size_t idx = 0, kept = 0;
+   #ifdef ASSERT_ISSUE_WALK
+      IssueWalk walk = { 0, false, true, false, SubsecondTime::MaxTime() };
+   #endif
 
-      if (entry->done != SubsecondTime::MaxTime())
+   for( ; idx < m_issue_queue.size() && !stopped; ++idx)
+   {
+      RobEntry *entry = m_issue_queue[idx];
+      DynamicMicroOp *uop = entry->uop;
+      const uint64_t sequenceNumber = uop->getSequenceNumber();
+      const bool head_of_queue = sequenceNumber == m_first_unissued;
+
+      #ifdef ASSERT_ISSUE_WALK
+         walkIssue(walk, sequenceNumber, num_issued);
+         LOG_ASSERT_ERROR(walk.stopped == (inorder && !head_of_queue), "Issue walk %s before uop %ld", walk.stopped ? "stopped" : "did not stop", sequenceNumber);
+         LOG_ASSERT_ERROR(walk.stopped || walk.head_of_queue == head_of_queue, "Issue walk disagrees on whether uop %ld is at the head of the ROB", sequenceNumber);
+         LOG_ASSERT_ERROR(!uop->getMicroOp()->isLoad() || !m_no_address_disambiguation || walk.stopped || walk.have_unresolved_store == (unresolved_store < sequenceNumber),
+                          "Issue walk disagrees on whether load %ld follows a store with an unknown address", sequenceNumber);
+      #endif
+
+      if (inorder && !head_of_queue)
       {
-         next_event = std::min(next_event, entry->done);
-         continue;                     // already done
+         // In-order: an older uop cannot issue, so neither can this one
+         walked = m_first_unissued - first + 1;
+         stopped = true;
+         break;
       }
 
-      next_event = std::min(next_event, entry->ready);
-
-
       // See if we can issue this instruction
 
       bool canIssue = false;
 
-      if (entry->ready > now)
-         canIssue = false;          // blocked by dependency
-
-      else if ((no_more_load && uop->getMicroOp()->isLoad()) || (no_more_store && uop->getMicroOp()->isStore()))
+      if ((no_more_load && uop->getMicroOp()->isLoad()) || (no_more_store && uop->getMicroOp()->isStore()))
          canIssue = false;          // blocked by mfence
 
       else if (uop->getMicroOp()->isSerializing())
@@ -746,7 +943,14 @@ SubsecondTime RobTimer::doIssue()
          if (head_of_queue && last_store_done <= now)
             canIssue = true;
          else
+         {
+            walked = sequenceNumber - first + 1;
+            stopped = true;
+            #ifdef ASSERT_ISSUE_WALK
+               walkIssueVisit(walk, entry, true);
+            #endif
             break;
+         }
       }
 
       else if (uop->getMicroOp()->isMemBarrier())
@@ -765,7 +969,7 @@ SubsecondTime RobTimer::doIssue()
       else if (uop->getMicroOp()->isLoad() && !load_queue.hasFreeSlot(now))
          canIssue = false;          // load queue full
 
-      else if (uop->getMicroOp()->isLoad() && m_no_address_disambiguation && have_unresolved_store)
+      else if (uop->getMicroOp()->isLoad() && m_no_address_disambiguation && unresolved_store < sequenceNumber)
          canIssue = false;          // preceding store with unknown address
 
       else if (uop->getMicroOp()->isStore() && (!head_of_queue || !store_queue.hasFreeSlot(now)))
@@ -783,7 +987,7 @@ SubsecondTime RobTimer::doIssue()
       if (canIssue)
       {
          num_issued++;
-         issueInstruction(i, next_event);
+         issueInstruction(entry);
 
          // Calculate memory-level parallelism (MLP) for long-latency loads (but ignore overlapped misses)
          if (uop->getMicroOp()->isLoad() && uop->isLongLatencyLoad() && uop->getDCacheHitWhere() != HitWhere::L1_OWN)
@@ -815,30 +1019,136 @@ SubsecondTime RobTimer::doIssue()
       }
       else
       {
-         head_of_queue = false;     // Subsequent instructions are not at the head of the ROB
-
-         if (uop->getMicroOp()->isStore() && entry->addressReady > now)
-            have_unresolved_store = true;
+         // Stays in the issue queue for the next cycle
+         m_issue_queue[kept++] = entry;
 
          if (inorder)
+         {
             // In-order: only issue from head of the ROB
-            break;
+            walked = sequenceNumber - first + 1;
+            stopped = true;
+         }
       }
 
 
-      if (m_rob_contention)
+      if (m_rob_contention ? m_rob_contention->noMore() : num_issued == dispatchWidth)
       {
-         if (m_rob_contention->noMore())
-            break;
+         walked = sequenceNumber - first + 1;
+         stopped = true;
       }
+
+      #ifdef ASSERT_ISSUE_WALK
+         walkIssueVisit(walk, entry, stopped);
+      #endif
+   }
+
+   // Uops that were not visited this cycle stay in the issue queue
+   for( ; idx < m_issue_queue.size(); ++idx)
+      m_issue_queue[kept++] = m_issue_queue[idx];
+   m_issue_queue.resize(kept);
+
+   if (inorder && !stopped && m_first_unissued < first + m_num_in_rob)
+      // In-order: the walk ends at the first uop that was not issued
+      walked = m_first_unissued - first + 1;
+
+   // The next event seen by the walk: the earliest ready time of the uops waiting for issue, or completion time of the
+   // issued uops, among the entries it visited. Uops issued this cycle were seen with their (past) ready time.
+   SubsecondTime next_event = m_events.getMin(first, first + walked);
+   if (num_issued)
+      next_event = std::min(next_event, now.getElapsedTime());
+
+   #ifdef ASSERT_ISSUE_WALK
+      walkIssue(walk, INVALID_SEQNR, num_issued);
+      LOG_ASSERT_ERROR(walk.visited == walked, "Issue walk visited %ld ROB entries instead of %ld", walk.visited, walked);
+      // The walk saw the (past) ready times of the uops it issued, either way the next cycle is simulated
+      LOG_ASSERT_ERROR(walk.next_event == next_event || (walk.next_event <= now && next_event <= now),
+                       "Issue walk found next event at %ld fs instead of %ld fs", walk.next_event.getFS(), next_event.getFS());
+   #endif
+
+   return next_event;
+}
+
+void RobTimer::walkIssue(IssueWalk &walk, uint64_t sequenceNumber, uint64_t num_issued)
+{
+   // Visit the ROB entries before sequenceNumber the way the issue stage used to, which the event-driven
+   // issue stage skipped: these must all have issued already, or not be ready yet
+   const uint64_t first = m_num_in_rob ? rob.front().uop->getSequenceNumber() : 0;
+   while (!walk.stopped && walk.visited < m_num_in_rob && first + walk.visited < sequenceNumber)
+   {
+      RobEntry *entry = &rob.at(walk.visited);
+      if (entry->done != SubsecondTime::MaxTime())
+         walkIssueVisit(walk, entry, false);
       else
       {
-         if (num_issued == dispatchWidth)
-            break;
+         LOG_ASSERT_ERROR(entry->ready > now, "Uop %ld is ready but was not considered for issue", entry->uop->getSequenceNumber());
+         walkIssueVisit(walk, entry, inorder || (m_rob_contention ? m_rob_contention->noMore() : num_issued == dispatchWidth));
       }
    }
+}
 
-   return next_event;
+void RobTimer::walkIssueVisit(IssueWalk &walk, RobEntry *entry, bool stop)
+{
+   ++walk.visited;
+   if (entry->issued != now)
+      // Issued before: the walk only looked at its completion time
+      walk.next_event = std::min(walk.next_event, entry->done == SubsecondTime::MaxTime() ? entry->ready : entry->done);
+   else
+      walk.next_event = std::min(walk.next_event, std::min(entry->ready, entry->done));
+
+   if (entry->done == SubsecondTime::MaxTime())
+   {
+      // Not issued: later uops are not at the head of the ROB, and later loads are blocked by a store without address
+      walk.head_of_queue = false;
+      if (entry->uop->getMicroOp()->isStore() && entry->addressReady > now)
+         walk.have_unresolved_store = true;
+   }
+   walk.stopped = stop;
+}
+
+uint64_t RobTimer::findUnresolvedStore()
+{
+   // Sequence number of the oldest store that has not issued and does not yet know its address.
+   // Stores that do know their address by now keep it, stores that do not won't learn it before the next cycle.
+   for(uint64_t i = 0; i < m_unissued_stores.size(); ++i)
+      if (m_unissued_stores[i]->addressReady > now)
+         return m_unissued_stores[i]->uop->getSequenceNumber();
+   return INVALID_SEQNR;
+}
+
+SubsecondTime RobTimer::getNextReadyTime()
+{
+   // Earliest time at which any uop could issue
+   if (inorder)
+   {
+      // Only the oldest uop that was not yet issued can
+      uint64_t first = m_num_in_rob ? rob.front().uop->getSequenceNumber() : 0;
+      if (m_num_in_rob && m_first_unissued < first + m_num_in_rob)
+         return rob[m_first_unissued - first].ready;
+      else
+         return SubsecondTime::MaxTime();
+   }
+   else if (!m_issue_queue.empty())
+      return now;
+   else if (!m_ready_queue.empty())
+      return m_ready_queue.front().first;
+   else
+      return SubsecondTime::MaxTime();
+}
+
+SubsecondTime RobTimer::getNextCompletionTime()
+{
+   while (!m_done_queue.empty() && m_done_queue.front() < now)
+   {
+      std::pop_heap(m_done_queue.begin(), m_done_queue.end(), std::greater<SubsecondTime>());
+      m_done_queue.pop_back();
+   }
+   if (m_done_queue.empty())
+      return SubsecondTime::MaxTime();
+   else if (m_done_queue.front() == now)
+      // The CPI stack component changes once a uop is past its completion time
+      return (now + 1ul).getElapsedTime();
+   else
+      return m_done_queue.front();
 }
 
 SubsecondTime RobTimer::doCommit(uint64_t& instructionsExecuted)
@@ -865,7 +1175,8 @@ SubsecondTime RobTimer::doCommit(uint64_t& instructionsExecuted)
       if (entry->uop->isLast())
          instructionsExecuted++;
 
-      entry->free();
+      m_events.set(entry->uop->getSequenceNumber(), SubsecondTime::MaxTime());
+      entry->free(m_dependant_pool);
       rob.pop();
       m_num_in_rob--;
 
@@ -931,6 +1242,25 @@ void RobTimer::execute(uint64_t& instructionsExecuted, SubsecondTime& latency)
       std::cout<<"Next event: D("<<SubsecondTime::divideRounded(next_dispatch, now.getPeriod())<<") I("<<SubsecondTime::divideRounded(next_issue, now.getPeriod())<<") C("<<SubsecondTime::divideRounded(next_commit, now.getPeriod())<<")"<<std::endl;
    #endif
    SubsecondTime next_event = std::min(next_dispatch, std::min(next_issue, next_commit));
+
+   // The issue stage asks for the next cycle whenever it issued something, or there are completed uops that were not
+   // yet committed. If no uop can issue in the next cycle and the front-end cannot dispatch (or needs more uops),
+   // nothing changes until the next uop becomes ready: jump ahead to that time, or to the next uop completion (which
+   // still matters for the CPI stack), front-end restart, or commit.
+   // Not with the MLP histogram: it samples the loads outstanding at the end of each skipped period, so skipping
+   // differently than before would change it.
+   const SubsecondTime next_cycle = (now + 1ul).getElapsedTime();
+   if (!m_mlp_histogram
+      && next_issue <= next_cycle && next_dispatch > next_cycle && next_commit > next_cycle
+      && getNextReadyTime() > next_cycle
+      && (frontend_stalled_until > next_cycle || m_num_in_rob == windowSize)
+      && !(frontend_stalled_until <= next_cycle && rob.size() < m_num_in_rob + 2*dispatchWidth))
+   {
+      next_event = std::min(std::min(next_dispatch, next_commit), std::min(getNextReadyTime(), getNextCompletionTime()));
+      if (frontend_stalled_until > now)
+         next_event = std::min(next_event, frontend_stalled_until);
+   }
+
    SubsecondTime skip;
    if (next_event != SubsecondTime::MaxTime() && next_event > now + 1ul)
    {
@@ -14,29 +14,66 @@
 class RobTimer
 {
 private:
+   class RobEntry;
+
+   // Storage for the dependants of uops that have more than fit inline in their RobEntry. Blocks are taken from
+   // a free list and returned when their uop commits, so the pool only allocates memory while it grows to the
+   // largest number of blocks in use at any one time.
+   class DependantPool
+   {
+      public:
+         static const size_t BLOCK_SIZE = 16;
+         struct Block
+         {
+            RobEntry* dependants[BLOCK_SIZE];
+            Block *next;
+         };
+
+         DependantPool(uint64_t blocks, UInt64 &allocations);
+         ~DependantPool();
+
+         Block *alloc();
+         void free(Block *block); // Returns a chain of blocks
+
+      private:
+         const uint64_t m_chunk_size;
+         std::vector<Block*> m_chunks;
+         Block *m_free;
+         UInt64 &m_allocations;
+
+         void grow();
+   };
+
    class RobEntry
    {
       private:
          static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
+         size_t numDependants;
          RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-         std::vector<uint64_t> addressProducers;
+         DependantPool::Block *overflowDependants, *overflowTail;
+
+         static const size_t MAX_ADDRESS_PRODUCERS = 4;
+         size_t numAddressProducers;
+         uint64_t addressProducers[MAX_ADDRESS_PRODUCERS];
 
       public:
          void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
-         void free();
+         void free(DependantPool &pool);
 
-         void addDependant(RobEntry* dep);
-         uint64_t getNumDependants() const;
+         void addDependant(RobEntry* dep, DependantPool &pool);
+         uint64_t getNumDependants() const { return numDependants; }
          RobEntry* getDependant(size_t idx) const;
 
-         void addAddressProducer(UInt64 sequenceNumber) { addressProducers.push_back(sequenceNumber); }
-         UInt64 getNumAddressProducers() const { return addressProducers.size(); }
-         UInt64 getAddressProducer(size_t idx) const { return addressProducers.at(idx); }
+         void addAddressProducer(UInt64 sequenceNumber)
+         {
+            LOG_ASSERT_ERROR(numAddressProducers < MAX_ADDRESS_PRODUCERS, "Too many address producers, increase MAX_ADDRESS_PRODUCERS(%d)", MAX_ADDRESS_PRODUCERS);
+            addressProducers[numAddressProducers++] = sequenceNumber;
+         }
+         UInt64 getNumAddressProducers() const { return numAddressProducers; }
+         UInt64 getAddressProducer(size_t idx) const { return addressProducers[idx]; }
 
          DynamicMicroOp *uop;
-         SubsecondTime dispatched;
+         SubsecondTime dispatched; // MaxTime while still in the pre-ROB buffer
          SubsecondTime ready;    // Once all dependencies are resolved, cycle number that this uop becomes ready for issue
          SubsecondTime readyMax; // While some but not all dependencies are resolved, keep the time of the latest known resolving dependency
          SubsecondTime addressReady;
@@ -45,6 +82,21 @@ private:
          SubsecondTime done;
    };
 
+   // Minimum over a range of ROB entries of the time of their next event: when they become ready while waiting for issue,
+   // when they complete once issued. Entries are indexed by sequence number, modulo a power of two larger than the ROB.
+   class EventTree
+   {
+      private:
+         uint64_t m_size;
+         std::vector<SubsecondTime> m_tree;
+
+      public:
+         EventTree(uint64_t entries);
+
+         void set(uint64_t sequenceNumber, SubsecondTime time);
+         SubsecondTime getMin(uint64_t first, uint64_t last) const; // Over sequence numbers [first, last)
+   };
+
    const uint64_t dispatchWidth;
    const uint64_t commitWidth;
    const uint64_t windowSize;
@@ -61,6 +113,19 @@ private:
    uint64_t m_num_in_rob;
    uint64_t m_rs_entries_used;
    RobContention *m_rob_contention;
+   UInt64 m_allocations;                        // Heap allocations after construction (dependant pool and queue growth)
+   DependantPool m_dependant_pool;
+
+   // Event-driven issue: dispatched uops enter the ready queue (a heap on ready time) once all their dependencies
+   // have been issued, and move to the issue queue (sorted on sequence number, i.e. ROB order) when that time is reached.
+   typedef std::pair<SubsecondTime, RobEntry*> ReadyEvent;
+   std::vector<ReadyEvent> m_ready_queue;
+   std::vector<RobEntry*> m_issue_queue;
+   std::vector<RobEntry*> m_issue_queue_new, m_issue_queue_merged;
+   std::vector<SubsecondTime> m_done_queue;     // Heap of completion times of issued uops
+   EventTree m_events;
+   uint64_t m_first_unissued;                   // Sequence number of the oldest dispatched uop that was not yet issued
+   CircularQueue<RobEntry*> m_unissued_stores;  // Stores only issue from the head of the ROB, so they leave this queue in order
 
    ComponentTime now;
    SubsecondTime frontend_stalled_until;
@@ -136,6 +201,7 @@ private:
    std::vector<SubsecondTime> m_outstandingLoadsAll;
 
    RobEntry *findEntryBySequenceNumber(UInt64 sequenceNumber);
+   static bool compareSequenceNumber(const RobEntry *a, const RobEntry *b);
    SubsecondTime* findCpiComponent();
    void countOutstandingMemop(SubsecondTime time);
    void printRob();
@@ -145,7 +211,24 @@ private:
    SubsecondTime doIssue();
    SubsecondTime doCommit(uint64_t& instructionsExecuted);
 
-   void issueInstruction(uint64_t idx, SubsecondTime &next_event);
+   void issueInstruction(RobEntry *entry);
+   void scheduleIssue(RobEntry *entry);
+   void pushDone(SubsecondTime done);
+   uint64_t findUnresolvedStore();
+
+   // State of the full ROB walk the issue stage used to do, replayed alongside doIssue() to check it (ASSERT_ISSUE_WALK)
+   struct IssueWalk
+   {
+      uint64_t visited;          // Number of ROB entries visited
+      bool stopped;
+      bool head_of_queue;
+      bool have_unresolved_store;
+      SubsecondTime next_event;
+   };
+   void walkIssue(IssueWalk &walk, uint64_t sequenceNumber, uint64_t num_issued);
+   void walkIssueVisit(IssueWalk &walk, RobEntry *entry, bool stop);
+   SubsecondTime getNextReadyTime();
+   SubsecondTime getNextCompletionTime();
 
 public:
 
@@ -3,6 +3,7 @@
 #include "config.h"
 #include "queue_model_basic.h"
 #include "queue_model_history_list.h"
+#include "queue_model_history_tree.h"
 #include "queue_model_contention.h"
 #include "queue_model_windowed_mg1.h"
 #include "log.h"
@@ -22,6 +23,10 @@ QueueModel::create(String name, UInt32 id, String model_type, SubsecondTime min_
    {
       return new QueueModelHistoryList(name, id, min_processing_time);
    }
+   else if (model_type == "history_tree")
+   {
+      return new QueueModelHistoryTree(name, id, min_processing_time);
+   }
    else if (model_type == "contention")
    {
       return new QueueModelContention(name, id, 1);
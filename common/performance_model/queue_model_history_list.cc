@@ -30,6 +30,7 @@ QueueModelHistoryList::QueueModelHistoryList(String name, UInt32 id, SubsecondTi
    try
    {
       m_analytical_model_enabled = Sim()->getCfg()->getBool("queue_model/history_list/analytical_model_enabled");
+      m_fix_interval_wraparound = Sim()->getCfg()->getBool("queue_model/history_list/fix_interval_wraparound");
       max_list_size = Sim()->getCfg()->getInt("queue_model/history_list/max_list_size");
    }
    catch(...)
@@ -176,7 +177,10 @@ QueueModelHistoryList::computeUsingHistoryList(SubsecondTime pkt_time, Subsecond
          queue_delay = interval.first - pkt_time;
          // Adjust the data structure accordingly
          curr_it = m_free_interval_list.erase(curr_it);
-         if ((interval.second - (interval.first + processing_time)) >= m_min_processing_time)
+         // When the request does not fit, the remainder starts after it ends and its size wraps around.
+         // Keeping it schedules later requests into busy time, but is what this model has always done.
+         if ((!m_fix_interval_wraparound || (interval.first + processing_time) < interval.second)
+             && (interval.second - (interval.first + processing_time)) >= m_min_processing_time)
          {
             m_free_interval_list.insert(curr_it, std::pair<SubsecondTime,SubsecondTime>(interval.first + processing_time, interval.second));
          }
@@ -33,6 +33,8 @@ private:
 
    // Is analytical model used ?
    bool m_analytical_model_enabled;
+   // Drop the remainder of a free interval that a delayed packet does not fit in ?
+   bool m_fix_interval_wraparound;
 
    // Performance Counters
    UInt64 m_total_requests;
@@ -0,0 +1,274 @@
+#include "queue_model_history_tree.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+#include "stats.h"
+#include "config.hpp"
+
+QueueModelHistoryTree::NodePool::~NodePool()
+{
+   for(std::vector<char*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+      delete [] *it;
+}
+
+void*
+QueueModelHistoryTree::NodePool::allocate(size_t size)
+{
+   if (m_size == 0)
+      m_size = std::max(size, sizeof(void*));
+   LOG_ASSERT_ERROR(size <= m_size, "NodePool can only allocate objects of %zu bytes, not %zu", m_size, size);
+
+   if (!m_free)
+   {
+      char *chunk = new char[CHUNK_NODES * m_size];
+      m_chunks.push_back(chunk);
+      for(UInt32 i = 0; i < CHUNK_NODES; ++i)
+         deallocate(chunk + i * m_size);
+   }
+
+   void *ptr = m_free;
+   m_free = *(void**)ptr;
+   return ptr;
+}
+
+QueueModelHistoryTree::QueueModelHistoryTree(String name, UInt32 id, SubsecondTime min_processing_time):
+   m_min_processing_time(min_processing_time),
+   m_free_intervals(std::less<SubsecondTime>(), PoolAllocator<std::pair<const SubsecondTime, SubsecondTime> >(&m_pool)),
+   m_inverted_intervals(std::less<SubsecondTime>(), PoolAllocator<std::pair<const SubsecondTime, SubsecondTime> >(&m_pool)),
+   m_inverted_steps(std::less<SubsecondTime>(), PoolAllocator<std::pair<const SubsecondTime, SubsecondTime> >(&m_pool)),
+   m_utilized_time(SubsecondTime::Zero()),
+   m_total_queue_delay(SubsecondTime::Zero()),
+   m_total_requests(0),
+   m_total_requests_using_analytical_model(0)
+{
+   UInt32 max_list_size = 0;
+   try
+   {
+      m_analytical_model_enabled = Sim()->getCfg()->getBool("queue_model/history_tree/analytical_model_enabled");
+      m_fix_interval_wraparound = Sim()->getCfg()->getBool("queue_model/history_tree/fix_interval_wraparound");
+      max_list_size = Sim()->getCfg()->getInt("queue_model/history_tree/max_list_size");
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read parameters from cfg");
+   }
+   // Non-empty intervals have unique start times, which the tree relies on
+   LOG_ASSERT_ERROR(m_min_processing_time > SubsecondTime::Zero(), "history_tree queue model requires a non-zero minimum processing time");
+   m_max_free_interval_list_size = max_list_size;
+   m_average_delay = MovingAverage<SubsecondTime>::createAvgType(MovingAverage<SubsecondTime>::ARITHMETIC_MEAN, max_list_size);
+   SubsecondTime max_simulation_time = SubsecondTime::FS() << 63;
+   m_free_intervals[SubsecondTime::Zero()] = max_simulation_time;
+
+   registerStatsMetric(name, id, "num-requests", &m_total_requests);
+   registerStatsMetric(name, id, "num-requests-analytical", &m_total_requests_using_analytical_model);
+   registerStatsMetric(name, id, "total-time-used", &m_utilized_time);
+   registerStatsMetric(name, id, "total-queue-delay", &m_total_queue_delay);
+}
+
+QueueModelHistoryTree::~QueueModelHistoryTree()
+{
+   delete m_average_delay;
+}
+
+SubsecondTime
+QueueModelHistoryTree::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester)
+{
+   LOG_ASSERT_ERROR(m_free_intervals.size() >= 1,
+         "Free Interval tree size < 1");
+
+   SubsecondTime queue_delay;
+
+   // Check if it is an old packet
+   // If yes, use analytical model
+   // If not, use the history tree based queue model
+   SubsecondTime oldest_start = isOldestInverted() ? m_inverted_intervals.begin()->second : m_free_intervals.begin()->first;
+   if (m_analytical_model_enabled && ((pkt_time + processing_time) <= oldest_start))
+   {
+      // Increment the number of requests that use the analytical model
+      m_total_requests_using_analytical_model ++;
+      queue_delay = computeUsingAnalyticalModel(pkt_time, processing_time);
+   }
+   else
+   {
+      queue_delay = computeUsingHistoryTree(pkt_time, processing_time);
+      updateAverageDelay(queue_delay);
+   }
+
+   updateQueueUtilization(processing_time);
+
+   // Increment total queue requests
+   m_total_requests ++;
+   m_total_queue_delay += queue_delay;
+
+   return queue_delay;
+}
+
+float
+QueueModelHistoryTree::getQueueUtilization()
+{
+   SubsecondTime total_time = m_free_intervals.rbegin()->first;
+
+   if (total_time == SubsecondTime::Zero())
+   {
+      LOG_ASSERT_ERROR(m_utilized_time == SubsecondTime::Zero(), "m_utilized_time(%s), total_time(%s)",
+            itostr(m_utilized_time).c_str(), itostr(total_time).c_str());
+      return 0;
+   }
+   else
+   {
+      return ((float) m_utilized_time.getInternalDataForced() / total_time.getInternalDataForced());
+   }
+}
+
+float
+QueueModelHistoryTree::getFracRequestsUsingAnalyticalModel()
+{
+  if (m_total_requests == 0)
+     return 0;
+  else
+     return ((float) m_total_requests_using_analytical_model / m_total_requests);
+}
+
+// QueueModelHistoryList keeps its intervals ordered on end time, this tells whether its first one is an inverted one
+bool
+QueueModelHistoryTree::isOldestInverted() const
+{
+   return !m_inverted_intervals.empty() && m_inverted_intervals.begin()->first < m_free_intervals.begin()->second;
+}
+
+// Makes the inverted interval [start, end) a step, unless an inverted interval that ends before it starts at or after start.
+// Steps that end after it but do not start later are no longer steps.
+void
+QueueModelHistoryTree::insertInvertedStep(SubsecondTime start, SubsecondTime end)
+{
+   // Steps are ordered on both start and end time
+   FreeIntervalTree::iterator it = m_inverted_steps.lower_bound(start);
+   if (it != m_inverted_steps.end() && it->second < end)
+      return;
+   if (it != m_inverted_steps.end() && it->first == start)
+      it = m_inverted_steps.erase(it);
+   while (it != m_inverted_steps.begin())
+   {
+      FreeIntervalTree::iterator prev = it;
+      if ((--prev)->second < end)
+         break;
+      m_inverted_steps.erase(prev);
+   }
+   m_inverted_steps.insert(it, std::pair<SubsecondTime,SubsecondTime>(start, end));
+}
+
+void
+QueueModelHistoryTree::eraseOldestInverted()
+{
+   // The oldest inverted interval is always the first step
+   m_inverted_intervals.erase(m_inverted_intervals.begin());
+   m_inverted_steps.erase(m_inverted_steps.begin());
+
+   // Intervals that were only hidden by it, up to the next step, can now be steps
+   FreeIntervalTree::iterator next_step = m_inverted_steps.begin();
+   SubsecondTime next_step_end = next_step == m_inverted_steps.end() ? SubsecondTime::MaxTime() : next_step->second;
+   SubsecondTime max_start = SubsecondTime::Zero();
+   for(FreeIntervalTree::iterator it = m_inverted_intervals.begin(); it != m_inverted_intervals.end() && it->first < next_step_end; ++it)
+   {
+      if (it == m_inverted_intervals.begin() || it->second > max_start)
+      {
+         max_start = it->second;
+         m_inverted_steps.insert(next_step, std::pair<SubsecondTime,SubsecondTime>(it->second, it->first));
+      }
+   }
+}
+
+void
+QueueModelHistoryTree::updateQueueUtilization(SubsecondTime processing_time)
+{
+   // Update queue utilization parameter
+   m_utilized_time += processing_time;
+}
+
+void
+QueueModelHistoryTree::updateAverageDelay(SubsecondTime queue_delay)
+{
+   m_average_delay->update(queue_delay);
+}
+
+SubsecondTime
+QueueModelHistoryTree::computeUsingAnalyticalModel(SubsecondTime pkt_time, SubsecondTime processing_time)
+{
+   // See QueueModelHistoryList::computeUsingAnalyticalModel
+   return m_average_delay->compute();
+}
+
+SubsecondTime
+QueueModelHistoryTree::computeUsingHistoryTree(SubsecondTime pkt_time, SubsecondTime processing_time)
+{
+   LOG_ASSERT_ERROR(getNumIntervals() <= m_max_free_interval_list_size,
+         "Free Interval tree size(%u) > %u", getNumIntervals(), m_max_free_interval_list_size);
+   SubsecondTime queue_delay;
+
+   // Intervals are disjoint, so the only one that can hold the packet without delay is the last one starting at or before pkt_time.
+   // If it does not fit there, the packet is delayed until the next free interval (see QueueModelHistoryList::computeUsingHistoryList).
+   FreeIntervalTree::iterator next = m_free_intervals.upper_bound(pkt_time);
+   FreeIntervalTree::iterator curr = next;
+   bool fits = curr != m_free_intervals.begin() && (pkt_time + processing_time) <= (--curr)->second;
+   SubsecondTime candidate_end = fits ? curr->second : next != m_free_intervals.end() ? next->second : SubsecondTime::MaxTime();
+
+   // QueueModelHistoryList takes the first interval, in order of end time, that the packet fits in or that starts after it.
+   // A packet never fits in an inverted interval, so the first one that starts after pkt_time is used if it ends earlier.
+   FreeIntervalTree::iterator step = m_inverted_steps.upper_bound(pkt_time);
+   if (step != m_inverted_steps.end() && step->second < candidate_end)
+   {
+      std::pair<SubsecondTime,SubsecondTime> interval = *step;
+      queue_delay = interval.first - pkt_time;
+      // Adjust the data structure accordingly. The remainder wraps around in QueueModelHistoryList's size check,
+      // so it is always kept, and is still inverted
+      m_inverted_steps.erase(step);
+      m_inverted_intervals[interval.second] = interval.first + processing_time;
+      insertInvertedStep(interval.first + processing_time, interval.second);
+   }
+   else if (fits)
+   {
+      std::pair<SubsecondTime,SubsecondTime> interval = *curr;
+      queue_delay = SubsecondTime::Zero();
+      // Adjust the data structure accordingly
+      m_free_intervals.erase(curr);
+      if ((pkt_time - interval.first) >= m_min_processing_time)
+      {
+         m_free_intervals.insert(next, std::pair<SubsecondTime,SubsecondTime>(interval.first, pkt_time));
+      }
+      if ((interval.second - (pkt_time + processing_time)) >= m_min_processing_time)
+      {
+         m_free_intervals.insert(next, std::pair<SubsecondTime,SubsecondTime>(pkt_time + processing_time, interval.second));
+      }
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(next != m_free_intervals.end(), "pkt_time(%s), free interval not found", itostr(pkt_time).c_str());
+
+      std::pair<SubsecondTime,SubsecondTime> interval = *next;
+      queue_delay = interval.first - pkt_time;
+      // Adjust the data structure accordingly
+      next = m_free_intervals.erase(next);
+      if ((interval.second - (interval.first + processing_time)) >= m_min_processing_time)
+      {
+         if ((interval.first + processing_time) < interval.second)
+            m_free_intervals.insert(next, std::pair<SubsecondTime,SubsecondTime>(interval.first + processing_time, interval.second));
+         else if (!m_fix_interval_wraparound)
+         {
+            m_inverted_intervals[interval.second] = interval.first + processing_time;
+            insertInvertedStep(interval.first + processing_time, interval.second);
+         }
+      }
+   }
+
+   if (getNumIntervals() > m_max_free_interval_list_size)
+   {
+      if (isOldestInverted())
+         eraseOldestInverted();
+      else
+         m_free_intervals.erase(m_free_intervals.begin());
+   }
+
+   LOG_PRINT("HistoryTree: pkt_time(%s), processing_time(%s), queue_delay(%s)", itostr(pkt_time).c_str(), itostr(processing_time).c_str(), itostr(queue_delay).c_str());
+
+   return queue_delay;
+}
@@ -0,0 +1,96 @@
+#ifndef __QUEUE_MODEL_HISTORY_TREE_H__
+#define __QUEUE_MODEL_HISTORY_TREE_H__
+
+#include <map>
+#include <vector>
+
+#include "queue_model.h"
+#include "fixed_types.h"
+#include "moving_average.h"
+
+// Same model as QueueModelHistoryList, but the free intervals are kept in a balanced tree keyed on their start time,
+// so finding the interval a packet goes into is O(log n) rather than a linear scan. Tree nodes come from a per-queue
+// pool, so steady-state operation does not call malloc. This makes much larger history sizes affordable.
+//
+// QueueModelHistoryList keeps the remainder of a free interval that a delayed packet does not fit in, which then
+// starts after it ends (its size check wraps around). Such inverted intervals are kept in a second tree, keyed on
+// their end time, so that this model returns the same delays (unless fix_interval_wraparound is set). A packet is delayed into the first one, in order of end
+// time, that starts after it. Only the inverted intervals that start later than all that end before them can be that
+// one; they are also kept in a third tree, keyed on start time, to find it in O(log n).
+class QueueModelHistoryTree : public QueueModel
+{
+public:
+   QueueModelHistoryTree(String name, UInt32 id, SubsecondTime min_processing_time);
+   ~QueueModelHistoryTree();
+
+   SubsecondTime computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester = INVALID_CORE_ID);
+
+   float getQueueUtilization();
+   float getFracRequestsUsingAnalyticalModel();
+
+private:
+   // Free list of equally-sized tree nodes, allocated in chunks and only released on destruction
+   class NodePool
+   {
+      public:
+         NodePool() : m_size(0), m_free(NULL) {}
+         ~NodePool();
+         void* allocate(size_t size);
+         void deallocate(void *ptr) { *(void**)ptr = m_free; m_free = ptr; }
+      private:
+         static const UInt32 CHUNK_NODES = 256;
+         size_t m_size;
+         void *m_free;
+         std::vector<char*> m_chunks;
+   };
+
+   template <typename T> class PoolAllocator
+   {
+      public:
+         typedef T value_type;
+         PoolAllocator(NodePool *pool) : m_pool(pool) {}
+         template <typename U> PoolAllocator(const PoolAllocator<U> &other) : m_pool(other.m_pool) {}
+         T* allocate(size_t n) { return (T*)m_pool->allocate(n * sizeof(T)); }
+         void deallocate(T *ptr, size_t n) { m_pool->deallocate(ptr); }
+         template <typename U> bool operator==(const PoolAllocator<U> &other) const { return m_pool == other.m_pool; }
+         template <typename U> bool operator!=(const PoolAllocator<U> &other) const { return m_pool != other.m_pool; }
+         NodePool *m_pool;
+   };
+
+   typedef std::map<SubsecondTime, SubsecondTime, std::less<SubsecondTime>,
+                    PoolAllocator<std::pair<const SubsecondTime, SubsecondTime> > > FreeIntervalTree;
+
+   SubsecondTime m_min_processing_time;
+   UInt32 m_max_free_interval_list_size;
+
+   NodePool m_pool;
+   FreeIntervalTree m_free_intervals;       //< Start -> end of each free interval; intervals are disjoint
+   FreeIntervalTree m_inverted_intervals;   //< End -> start of each interval that starts after it ends
+   FreeIntervalTree m_inverted_steps;       //< Start -> end of the inverted intervals that start later than all that end before them
+
+   // Tracks queue utilization
+   SubsecondTime m_utilized_time;
+   SubsecondTime m_total_queue_delay;
+   MovingAverage<SubsecondTime>* m_average_delay;
+
+   // Is analytical model used ?
+   bool m_analytical_model_enabled;
+   // Drop the remainder of a free interval that a delayed packet does not fit in ?
+   bool m_fix_interval_wraparound;
+
+   // Performance Counters
+   UInt64 m_total_requests;
+   UInt64 m_total_requests_using_analytical_model;
+
+   UInt32 getNumIntervals() const { return m_free_intervals.size() + m_inverted_intervals.size(); }
+   bool isOldestInverted() const;
+   void insertInvertedStep(SubsecondTime start, SubsecondTime end);
+   void eraseOldestInverted();
+
+   void updateQueueUtilization(SubsecondTime processing_time);
+   void updateAverageDelay(SubsecondTime queue_delay);
+   SubsecondTime computeUsingHistoryTree(SubsecondTime pkt_time, SubsecondTime processing_time);
+   SubsecondTime computeUsingAnalyticalModel(SubsecondTime pkt_time, SubsecondTime processing_time);
+};
+
+#endif /* __QUEUE_MODEL_HISTORY_TREE_H__ */
@@ -2,6 +2,7 @@
 #include "simulator.h"
 #include "magic_server.h"
 #include "sim_api.h"
+#include "self_profile.h"
 
 static PyObject *
 setROI(PyObject *self, PyObject *args)
@@ -52,6 +53,19 @@ setProgress(PyObject *self, PyObject *args)
    Py_RETURN_NONE;
 }
 
+static PyObject *
+setSelfProfile(PyObject *self, PyObject *args)
+{
+   bool enabled = false;
+
+   if (!PyArg_ParseTuple(args, "b", &enabled))
+      return NULL;
+
+   SelfProfile::setEnabled(enabled);
+
+   Py_RETURN_NONE;
+}
+
 static PyObject *
 simulatorAbort(PyObject *self, PyObject *args)
 {
@@ -71,6 +85,7 @@ static PyMethodDef PyControlMethods[] = {
    { "set_roi", setROI, METH_VARARGS, "Set whether or not we are in the ROI" },
    { "set_instrumentation_mode", setInstrumentationMode, METH_VARARGS, "Set instrumentation mode" },
    { "set_progress", setProgress, METH_VARARGS, "Set simulation progress indicator (0..1)" },
+   { "set_self_profile", setSelfProfile, METH_VARARGS, "Enable or disable host-time accounting of the simulator's subsystems" },
    { "abort", simulatorAbort, METH_VARARGS, "Stop simulation now" },
    { NULL, NULL, 0, NULL } /* Sentinel */
 };
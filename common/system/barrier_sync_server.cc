@@ -3,6 +3,7 @@
 #include "simulator.h"
 #include "core_manager.h"
 #include "core.h"
+#include "self_profile.h"
 #include "thread.h"
 #include "performance_model.h"
 #include "hooks_manager.h"
@@ -12,18 +13,27 @@
 #include "stats.h"
 #include "config.hpp"
 #include "circular_log.h"
+#include "timer.h"
 
 #include <algorithm>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 BarrierSyncServer::BarrierSyncServer()
    : m_local_clock_list(Sim()->getConfig()->getApplicationCores(), SubsecondTime::Zero())
    , m_barrier_acquire_list(Sim()->getConfig()->getApplicationCores(), false)
-   , m_core_cond(Sim()->getConfig()->getApplicationCores(), NULL)
+   , m_release(new release_t[Sim()->getConfig()->getApplicationCores()])
+   , m_spin_iterations(Sim()->getCfg()->getInt("clock_skew_minimization/barrier/spin_iterations"))
    , m_core_group(Sim()->getConfig()->getApplicationCores(), INVALID_CORE_ID)
    , m_core_thread(Sim()->getConfig()->getApplicationCores(), INVALID_THREAD_ID)
    , m_global_time(SubsecondTime::Zero())
    , m_fastforward(false)
    , m_disable(false)
+   , m_wait_count(Sim()->getConfig()->getApplicationCores(), 0)
+   , m_wait_spin_count(Sim()->getConfig()->getApplicationCores(), 0)
+   , m_wait_time(Sim()->getConfig()->getApplicationCores(), SubsecondTime::Zero())
 {
    try
    {
@@ -35,7 +45,11 @@ BarrierSyncServer::BarrierSyncServer()
    }
 
    for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
-      m_core_cond[core_id] = new ConditionVariable();
+   {
+      m_release[core_id].gen = 0;
+      m_release[core_id].sleepers = 0;
+      m_release[core_id].children[0] = m_release[core_id].children[1] = INVALID_CORE_ID;
+   }
 
    m_next_barrier_time = m_barrier_interval;
 
@@ -45,63 +59,82 @@ BarrierSyncServer::BarrierSyncServer()
    Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_MIGRATE, BarrierSyncServer::hookThreadMigrate, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
 
    registerStatsMetric("barrier", 0, "global_time", &m_global_time);
+   for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
+   {
+      registerStatsMetric("barrier", core_id, "wait_count", &m_wait_count[core_id]);
+      registerStatsMetric("barrier", core_id, "wait_spin_count", &m_wait_spin_count[core_id]);
+      registerStatsMetric("barrier", core_id, "wait_host_time", &m_wait_time[core_id]);
+   }
 }
 
 BarrierSyncServer::~BarrierSyncServer()
 {
-   for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
-      delete m_core_cond[core_id];
+   delete [] m_release;
 }
 
 void
 BarrierSyncServer::synchronize(core_id_t core_id, SubsecondTime time)
 {
-   ScopedLock sl(Sim()->getThreadManager()->getLock());
-   if (m_disable)
-      return;
+   SelfProfile::Scope profile(SelfProfile::BARRIER);
 
-   Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
    core_id_t master_core_id;
-   if (m_fastforward)
-      master_core_id = core_id;  // In fast-forward, the SMT performance model in not active so every core (HW context) calls into the barrier
-   else
-      master_core_id = m_core_group[core_id] == INVALID_CORE_ID ? core_id : m_core_group[core_id];
-   Core *master_core = Sim()->getCoreManager()->getCoreFromID(core_id);
-   thread_id_t thread_me = core->getThread()->getId();
+   UInt32 gen;
+   {
+      ScopedLock sl(Sim()->getThreadManager()->getLock());
+      if (m_disable)
+         return;
 
-   CLOG("barrier", "Core %d entry (master core %d, thread %d, ffwd %d)", core_id, master_core_id, thread_me, m_fastforward);
-   LOG_PRINT("Received 'SIM_BARRIER_WAIT' from Core(%i), Time(%s)", core_id, itostr(time).c_str());
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      if (m_fastforward)
+         master_core_id = core_id;  // In fast-forward, the SMT performance model in not active so every core (HW context) calls into the barrier
+      else
+         master_core_id = m_core_group[core_id] == INVALID_CORE_ID ? core_id : m_core_group[core_id];
+      Core *master_core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      thread_id_t thread_me = core->getThread()->getId();
 
-   LOG_ASSERT_ERROR(core->getState() == Core::RUNNING || core->getState() == Core::INITIALIZING, "Core(%i) is not running or initializing at time(%s)", core_id, itostr(time).c_str());
-   LOG_ASSERT_ERROR(m_barrier_acquire_list[master_core_id] == false, "Core(%i) or its sibling is already in the barrier (this is thread %d, we have thread %d)", master_core_id, thread_me, m_core_thread[master_core_id]);
+      CLOG("barrier", "Core %d entry (master core %d, thread %d, ffwd %d)", core_id, master_core_id, thread_me, m_fastforward);
+      LOG_PRINT("Received 'SIM_BARRIER_WAIT' from Core(%i), Time(%s)", core_id, itostr(time).c_str());
 
-   if (time < m_next_barrier_time && !m_fastforward)
-   {
-      LOG_PRINT("Sent 'SIM_BARRIER_RELEASE' immediately time(%s), m_next_barrier_time(%s)", itostr(time).c_str(), itostr(m_next_barrier_time).c_str());
-      // LOG_PRINT_WARNING("core_id(%i), local_clock(%llu), m_next_barrier_time(%llu), m_barrier_interval(%llu)", core_id, time, m_next_barrier_time, m_barrier_interval);
-      CLOG("barrier", "Core %d immediate exit", core_id);
-      return;
-   }
+      LOG_ASSERT_ERROR(core->getState() == Core::RUNNING || core->getState() == Core::INITIALIZING, "Core(%i) is not running or initializing at time(%s)", core_id, itostr(time).c_str());
+      LOG_ASSERT_ERROR(m_barrier_acquire_list[master_core_id] == false, "Core(%i) or its sibling is already in the barrier (this is thread %d, we have thread %d)", master_core_id, thread_me, m_core_thread[master_core_id]);
 
-   // One thread entered the barrier, another one can resume
-   doRelease(1);
+      if (time < m_next_barrier_time && !m_fastforward)
+      {
+         LOG_PRINT("Sent 'SIM_BARRIER_RELEASE' immediately time(%s), m_next_barrier_time(%s)", itostr(time).c_str(), itostr(m_next_barrier_time).c_str());
+         // LOG_PRINT_WARNING("core_id(%i), local_clock(%llu), m_next_barrier_time(%llu), m_barrier_interval(%llu)", core_id, time, m_next_barrier_time, m_barrier_interval);
+         CLOG("barrier", "Core %d immediate exit", core_id);
+         return;
+      }
 
-   master_core->getPerformanceModel()->barrierEnter();
+      // One thread entered the barrier, another one can resume
+      doRelease(1);
 
-   m_local_clock_list[master_core_id] = time;
-   m_barrier_acquire_list[master_core_id] = true;
-   m_core_thread[master_core_id] = thread_me;
+      master_core->getPerformanceModel()->barrierEnter();
 
-   bool mustWait = true;
-   if (isBarrierReached())
-      mustWait = barrierRelease(thread_me);
+      m_local_clock_list[master_core_id] = time;
+      m_barrier_acquire_list[master_core_id] = true;
+      m_core_thread[master_core_id] = thread_me;
+
+      bool mustWait = true;
+      if (isBarrierReached())
+         mustWait = barrierRelease(thread_me);
+
+      if (!mustWait)
+      {
+         master_core->getPerformanceModel()->barrierExit();
+         CLOG("barrier", "Core %d exit (master core %d, thread %d)", core_id, master_core_id, thread_me);
+         return;
+      }
+
+      // Any release of this core happens after this point, either by someone holding the lock or by a core
+      // that was itself released after this point, so this is the generation we should wait to move on from
+      gen = __atomic_load_n(&m_release[master_core_id].gen, __ATOMIC_ACQUIRE);
+   }
 
-   if (mustWait)
-      m_core_cond[master_core_id]->wait(Sim()->getThreadManager()->getLock());
-   else
-      master_core->getPerformanceModel()->barrierExit();
+   // Wait without holding the thread manager lock
+   waitRelease(master_core_id, gen);
 
-   CLOG("barrier", "Core %d exit (master core %d, thread %d)", core_id, master_core_id, thread_me);
+   CLOG("barrier", "Core %d exit (master core %d)", core_id, master_core_id);
 }
 
 void
@@ -326,12 +359,78 @@ BarrierSyncServer::doRelease(int n)
 {
    // Release up to n threads from the list.
    // When n == -1, all threads are released
+   m_release_wave.clear();
    while(m_to_release.size() && n--)
    {
-      core_id_t core_id = m_to_release.back();
+      m_release_wave.push_back(m_to_release.back());
       m_to_release.pop_back();
-      m_core_cond[core_id]->signal();
    }
+
+   if (m_release_wave.empty())
+      return;
+
+   // Arrange this wave as a binary tree, we only wake up the root ourselves
+   for(size_t idx = 0; idx < m_release_wave.size(); ++idx)
+   {
+      release_t &release = m_release[m_release_wave[idx]];
+      release.children[0] = 2 * idx + 1 < m_release_wave.size() ? m_release_wave[2 * idx + 1] : INVALID_CORE_ID;
+      release.children[1] = 2 * idx + 2 < m_release_wave.size() ? m_release_wave[2 * idx + 2] : INVALID_CORE_ID;
+   }
+   wake(m_release_wave[0]);
+}
+
+void
+BarrierSyncServer::wake(core_id_t core_id)
+{
+   release_t &release = m_release[core_id];
+   __atomic_add_fetch(&release.gen, 1, __ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&release.sleepers, __ATOMIC_SEQ_CST))
+      syscall(SYS_futex, (void*) &release.gen, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
+}
+
+void
+BarrierSyncServer::waitRelease(core_id_t core_id, UInt32 gen)
+{
+   release_t &release = m_release[core_id];
+   UInt64 t_start = Timer::now();
+
+   // Spin for a while first: with a short quantum, most waits end before a futex round trip would
+   bool spun = false;
+   for(UInt32 i = 0; i < m_spin_iterations; ++i)
+   {
+      if (__atomic_load_n(&release.gen, __ATOMIC_ACQUIRE) != gen)
+      {
+         spun = true;
+         break;
+      }
+      #if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+      #endif
+   }
+
+   if (!spun)
+   {
+      __atomic_add_fetch(&release.sleepers, 1, __ATOMIC_SEQ_CST);
+      while(__atomic_load_n(&release.gen, __ATOMIC_SEQ_CST) == gen)
+         syscall(SYS_futex, (void*) &release.gen, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, gen, NULL, NULL, 0);
+      __atomic_sub_fetch(&release.sleepers, 1, __ATOMIC_SEQ_CST);
+   }
+
+   // Pass on the release to our children in the release tree
+   for(int child = 0; child < 2; ++child)
+   {
+      core_id_t child_core_id = release.children[child];
+      if (child_core_id != INVALID_CORE_ID)
+      {
+         release.children[child] = INVALID_CORE_ID;
+         wake(child_core_id);
+      }
+   }
+
+   ++m_wait_count[core_id];
+   if (spun)
+      ++m_wait_spin_count[core_id];
+   m_wait_time[core_id] += SubsecondTime::NS(Timer::now() - t_start);
 }
 
 void
@@ -347,9 +446,11 @@ BarrierSyncServer::abortBarrier()
 
          Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
          core->getPerformanceModel()->barrierExit();
-         m_core_cond[core_id]->signal();
+         wake(core_id);
       }
    }
+   // Cores that were already selected for release but were being throttled can go as well
+   doRelease(-1);
 }
 
 void
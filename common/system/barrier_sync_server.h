@@ -2,7 +2,6 @@
 #define __BARRIER_SYNC_SERVER_H__
 
 #include "fixed_types.h"
-#include "cond.h"
 #include "hooks_manager.h"
 
 #include <vector>
@@ -12,18 +11,35 @@ class CoreManager;
 class BarrierSyncServer : public ClockSkewMinimizationServer
 {
    private:
+      // Per (master) core release word. Waiters spin on gen for a while, then sleep on it as a futex.
+      // Released cores are woken as a binary tree: each woken core wakes its children, so waking
+      // N cores costs log2(N) rather than N serial wake-ups on the releasing thread.
+      struct release_t
+      {
+         UInt32 gen;                //< Incremented to release the core (and with it, its whole core group)
+         UInt32 sleepers;           //< Number of threads sleeping in futex_wait on gen
+         core_id_t children[2];     //< Cores to be woken by this core once it is released
+         UInt8 padding[64 - 2 * sizeof(UInt32) - 2 * sizeof(core_id_t)];
+      };
+
       SubsecondTime m_barrier_interval;
       SubsecondTime m_next_barrier_time;
       std::vector<SubsecondTime> m_local_clock_list;
       std::vector<bool> m_barrier_acquire_list;
-      std::vector<ConditionVariable*> m_core_cond;
+      release_t *m_release;
+      UInt32 m_spin_iterations;
       std::vector<core_id_t> m_to_release;
+      std::vector<core_id_t> m_release_wave;
       std::vector<core_id_t> m_core_group;
       std::vector<thread_id_t> m_core_thread;
       SubsecondTime m_global_time;
       bool m_fastforward;
       volatile bool m_disable;
 
+      std::vector<UInt64> m_wait_count;         //< Number of times each core waited in the barrier
+      std::vector<UInt64> m_wait_spin_count;    //< Number of those waits that ended while still spinning
+      std::vector<SubsecondTime> m_wait_time;   //< Host time each core spent waiting to be released
+
       bool isBarrierReached(void);
       bool barrierRelease(thread_id_t thread_id = INVALID_THREAD_ID, bool continue_until_release = false);
       void abortBarrier(void);
@@ -31,6 +47,8 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
       void releaseThread(thread_id_t thread_id);
       void signal();
       void doRelease(int n);
+      void wake(core_id_t core_id);
+      void waitRelease(core_id_t core_id, UInt32 gen);
 
       static SInt64 hookThreadExit(UInt64 object, UInt64 argument) {
          ((BarrierSyncServer*)object)->threadExit((HooksManager::ThreadTime*)argument); return 0;
@@ -0,0 +1,58 @@
+#include "calling_context.h"
+
+CallingContext::CallingContext(CallingContext *parent, IntPtr eip)
+   : m_eip(eip)
+   , m_parent(parent)
+   , m_depth(parent ? parent->m_depth + 1 : 0)
+   , m_data(NULL)
+{
+}
+
+CallingContext::~CallingContext()
+{
+   // Delete iteratively: recursive call chains make for trees that are too deep to recurse into
+   std::vector<CallingContext*> nodes;
+   getDescendants(nodes);
+   for(std::vector<CallingContext*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+      (*it)->m_children.clear();
+   for(std::vector<CallingContext*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+      delete *it;
+}
+
+CallingContext* CallingContext::getChild(IntPtr eip)
+{
+   ScopedLock sl(m_lock);
+
+   Children::iterator it = m_children.find(eip);
+   if (it != m_children.end())
+      return it->second;
+
+   CallingContext *child = new CallingContext(this, eip);
+   m_children[eip] = child;
+   return child;
+}
+
+CallStack CallingContext::getStack() const
+{
+   CallStack stack;
+   for(const CallingContext *node = this; node->m_parent; node = node->m_parent)
+      stack.push_front(node->m_eip);
+   return stack;
+}
+
+void CallingContext::getDescendants(std::vector<CallingContext*> &nodes)
+{
+   size_t start = nodes.size();
+   {
+      ScopedLock sl(m_lock);
+      for(Children::iterator it = m_children.begin(); it != m_children.end(); ++it)
+         nodes.push_back(it->second);
+   }
+   for(size_t idx = start; idx < nodes.size(); ++idx)
+   {
+      CallingContext *node = nodes[idx];
+      ScopedLock sl(node->m_lock);
+      for(Children::iterator it = node->m_children.begin(); it != node->m_children.end(); ++it)
+         nodes.push_back(it->second);
+   }
+}
@@ -0,0 +1,53 @@
+#ifndef __CALLING_CONTEXT_H
+#define __CALLING_CONTEXT_H
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+typedef std::deque<IntPtr> CallStack;
+
+// Calling-context tree: one node per distinct call stack, shared by all threads.
+// A thread keeps a pointer to the node of its current context, so that entering a routine is a lookup among the
+// children of that node and returning is following the parent pointer, independent of the depth of the stack.
+// Nodes are never removed while the tree exists, pointers to them can be kept (e.g. as cache line owners).
+class CallingContext
+{
+   public:
+      const IntPtr m_eip;                 //< 0 for the root
+      CallingContext * const m_parent;    //< NULL for the root
+      const UInt32 m_depth;               //< Number of routines on the stack, 0 for the root
+      void *m_data;                       //< Per-context statistics, owned by the tracer using the tree
+
+      CallingContext(CallingContext *parent, IntPtr eip);
+      ~CallingContext();
+
+      // Find or create the context reached by calling eip from this one
+      CallingContext* getChild(IntPtr eip);
+      // Routines on the stack, outermost first
+      CallStack getStack() const;
+      // All descendants of this node, parents before their children
+      void getDescendants(std::vector<CallingContext*> &nodes);
+
+   private:
+      typedef std::unordered_map<IntPtr, CallingContext*> Children;
+
+      Lock m_lock;                        //< Other threads may add children concurrently
+      Children m_children;
+};
+
+class CallingContextTree
+{
+   public:
+      CallingContextTree() : m_root(NULL, 0) {}
+
+      CallingContext* getRoot() { return &m_root; }
+
+   private:
+      CallingContext m_root;
+};
+
+#endif // __CALLING_CONTEXT_H
@@ -0,0 +1,131 @@
+#include "checkpoint_manager.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "config.h"
+#include "config.hpp"
+#include "log.h"
+
+CheckpointManager::CheckpointManager()
+   : m_save_filename(Sim()->getCfg()->getString("checkpoint/save"))
+   , m_load_filename(Sim()->getCfg()->getString("checkpoint/load"))
+   , m_marker(Sim()->getCfg()->getInt("checkpoint/marker"))
+   , m_done(false)
+   , m_pending(false)
+{
+   LOG_ASSERT_ERROR(m_save_filename.empty() || m_load_filename.empty(), "Cannot both save and load a checkpoint in the same run");
+   if (!m_save_filename.empty() && m_save_filename[0] != '/')
+      m_save_filename = Sim()->getConfig()->formatOutputFileName(m_save_filename);
+}
+
+void
+CheckpointManager::init()
+{
+   if (!isEnabled())
+      return;
+
+   // Only the barrier scheme stops all cores at once, and calls HOOK_PERIODIC while they are stopped
+   LOG_ASSERT_ERROR(Sim()->getConfig()->getClockSkewMinimizationScheme() == ClockSkewMinimizationObject::BARRIER,
+                    "Checkpoints require clock_skew_minimization/scheme = barrier");
+
+   if (m_marker >= 0)
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_MAGIC_MARKER, __hook_magic_marker, (UInt64)this);
+   else
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, __hook_roi_begin, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, __hook_periodic, (UInt64)this, HooksManager::ORDER_ACTION);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, __hook_sim_end, (UInt64)this);
+}
+
+void
+CheckpointManager::registerObject(String name, UInt32 index, Checkpointable *object)
+{
+   if (!isEnabled())
+      return;
+
+   ScopedLock sl(m_lock);
+   Entry entry = { name + "/" + itostr(index), object };
+   for(std::vector<Entry>::const_iterator it = m_objects.begin(); it != m_objects.end(); ++it)
+      LOG_ASSERT_ERROR(it->name != entry.name, "Checkpoint object %s registered twice", entry.name.c_str());
+   m_objects.push_back(entry);
+}
+
+SInt64
+CheckpointManager::__hook_magic_marker(UInt64 user, UInt64 arg)
+{
+   CheckpointManager *manager = (CheckpointManager*)user;
+   MagicServer::MagicMarkerType *marker = (MagicServer::MagicMarkerType *)arg;
+   if ((SInt64)marker->arg0 == manager->m_marker)
+      manager->trigger();
+   return 0;
+}
+
+void
+CheckpointManager::trigger()
+{
+   // Only the first occurrence of the trigger point is used
+   if (m_done)
+      return;
+   m_done = true;
+
+   // We are on the thread that reached the trigger point, while other cores keep running:
+   // wait for the next barrier to save or restore their state
+   __atomic_store_n(&m_pending, true, __ATOMIC_RELEASE);
+}
+
+void
+CheckpointManager::periodic()
+{
+   // Called from the barrier, with all cores stopped
+   if (!__atomic_load_n(&m_pending, __ATOMIC_ACQUIRE))
+      return;
+   __atomic_store_n(&m_pending, false, __ATOMIC_RELAXED);
+
+   if (!m_save_filename.empty())
+      save(m_save_filename);
+   else
+      load(m_load_filename);
+}
+
+void
+CheckpointManager::simEnd()
+{
+   if (!__atomic_load_n(&m_pending, __ATOMIC_ACQUIRE))
+      return;
+   __atomic_store_n(&m_pending, false, __ATOMIC_RELAXED);
+
+   // No barrier was reached after the trigger point. All threads have ended, so it is still safe to save.
+   if (!m_save_filename.empty())
+      save(m_save_filename);
+   else
+      LOG_PRINT_WARNING("Simulation ended before checkpoint %s could be restored", m_load_filename.c_str());
+}
+
+void
+CheckpointManager::save(String filename)
+{
+   ScopedLock sl(m_lock);
+   printf("[SNIPER] Saving checkpoint to %s\n", filename.c_str());
+
+   CheckpointWriter writer(filename);
+   for(std::vector<Entry>::const_iterator it = m_objects.begin(); it != m_objects.end(); ++it)
+   {
+      writer.beginSection(it->name);
+      it->object->saveCheckpoint(writer);
+      writer.endSection();
+   }
+}
+
+void
+CheckpointManager::load(String filename)
+{
+   ScopedLock sl(m_lock);
+   printf("[SNIPER] Restoring checkpoint from %s\n", filename.c_str());
+
+   CheckpointReader reader(filename);
+   for(std::vector<Entry>::const_iterator it = m_objects.begin(); it != m_objects.end(); ++it)
+   {
+      reader.beginSection(it->name);
+      it->object->loadCheckpoint(reader);
+      reader.endSection();
+   }
+}
@@ -0,0 +1,59 @@
+#ifndef __CHECKPOINT_MANAGER_H
+#define __CHECKPOINT_MANAGER_H
+
+#include "fixed_types.h"
+#include "checkpoint.h"
+#include "lock.h"
+
+#include <vector>
+
+// Saves the warmed-up microarchitectural state (cache and TLB contents, directory entries, branch predictor
+// and prefetcher tables) of all registered objects at a trigger point, and restores it at the same point in a
+// later run with the same configuration. The trigger is the start of the region of interest, or a magic marker.
+// Saving and restoring happen at the first barrier after the trigger, when all cores are stopped, so that no other
+// core changes the state while it is being copied.
+class CheckpointManager
+{
+   public:
+      CheckpointManager();
+
+      void init();
+
+      // Objects are saved in section <name>/<index>, which must be unique
+      void registerObject(String name, UInt32 index, Checkpointable *object);
+
+      bool isEnabled() const { return !m_save_filename.empty() || !m_load_filename.empty(); }
+
+      void save(String filename);
+      void load(String filename);
+
+   private:
+      struct Entry
+      {
+         String name;
+         Checkpointable *object;
+      };
+
+      String m_save_filename;
+      String m_load_filename;
+      SInt64 m_marker;
+      bool m_done;
+      bool m_pending;      //< Triggered, waiting for the next barrier
+
+      Lock m_lock;
+      std::vector<Entry> m_objects;
+
+      void trigger();
+      void periodic();
+      void simEnd();
+
+      static SInt64 __hook_roi_begin(UInt64 user, UInt64 arg)
+      { ((CheckpointManager*)user)->trigger(); return 0; }
+      static SInt64 __hook_magic_marker(UInt64 user, UInt64 arg);
+      static SInt64 __hook_periodic(UInt64 user, UInt64 arg)
+      { ((CheckpointManager*)user)->periodic(); return 0; }
+      static SInt64 __hook_sim_end(UInt64 user, UInt64 arg)
+      { ((CheckpointManager*)user)->simEnd(); return 0; }
+};
+
+#endif // __CHECKPOINT_MANAGER_H
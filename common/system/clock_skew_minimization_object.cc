@@ -1,6 +1,8 @@
 #include "clock_skew_minimization_object.h"
 #include "barrier_sync_client.h"
 #include "barrier_sync_server.h"
+#include "lookahead_sync_client.h"
+#include "lookahead_sync_server.h"
 #include "simulator.h"
 #include "log.h"
 #include "config.hpp"
@@ -10,6 +12,8 @@ ClockSkewMinimizationObject::parseScheme(String scheme)
 {
    if (scheme == "barrier")
       return BARRIER;
+   else if (scheme == "lookahead")
+      return LOOKAHEAD;
    else
    {
       config::Error("Unrecognized clock skew minimization scheme: %s", scheme.c_str());
@@ -26,6 +30,9 @@ ClockSkewMinimizationClient::create(Core* core)
       case BARRIER:
          return new BarrierSyncClient(core);
 
+      case LOOKAHEAD:
+         return new LookaheadSyncClient(core);
+
       default:
          LOG_PRINT_ERROR("Unrecognized scheme: %u", scheme);
          return (ClockSkewMinimizationClient*) NULL;
@@ -40,6 +47,7 @@ ClockSkewMinimizationManager::create()
    switch (scheme)
    {
       case BARRIER:
+      case LOOKAHEAD:
          return (ClockSkewMinimizationManager*) NULL;
 
       default:
@@ -58,6 +66,9 @@ ClockSkewMinimizationServer::create()
       case BARRIER:
          return new BarrierSyncServer();
 
+      case LOOKAHEAD:
+         return new LookaheadSyncServer();
+
       default:
          LOG_PRINT_ERROR("Unrecognized scheme: %u", scheme);
          return (ClockSkewMinimizationServer*) NULL;
@@ -14,6 +14,7 @@ class ClockSkewMinimizationObject
       {
          NONE = 0,
          BARRIER,
+         LOOKAHEAD,
          NUM_SCHEMES
       };
 
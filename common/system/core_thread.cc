@@ -40,10 +40,12 @@ void CoreThread::run()
                          (void *)&cont);
 
    PerformanceModel *prfmdl = Sim()->getCoreManager()->getCurrentCore()->getPerformanceModel();
-   while (cont) {
-      prfmdl->iterate();
-      usleep(1000); // Reduce system load while there's nothing to do (outside ROI)
-   }
+   if (prfmdl->hasOwnThread())
+      prfmdl->runOwnThread(&cont);
+   else
+      // This core's performance model runs on its functional thread, wait for the quit message
+      while (cont)
+         usleep(1000);
 
    Sim()->getSimThreadManager()->simThreadExitCallback();
 
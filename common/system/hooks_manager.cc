@@ -1,5 +1,6 @@
 #include "hooks_manager.h"
 #include "log.h"
+#include "self_profile.h"
 
 const char* HookType::hook_type_names[] = {
    "HOOK_PERIODIC",
@@ -42,6 +43,8 @@ void HooksManager::registerHook(HookType::hook_type_t type, HookCallbackFunc fun
 
 SInt64 HooksManager::callHooks(HookType::hook_type_t type, UInt64 arg, bool expect_return)
 {
+   SelfProfile::Scope profile(SelfProfile::HOOKS);
+
    for(unsigned int order = 0; order < NUM_HOOK_ORDER; ++order)
    {
       for(std::vector<HookCallback>::iterator it = m_registry[type].begin(); it != m_registry[type].end(); ++it)
@@ -0,0 +1,47 @@
+#include "lookahead_sync_client.h"
+#include "lookahead_sync_server.h"
+#include "simulator.h"
+#include "core.h"
+#include "performance_model.h"
+#include "subsecond_time.h"
+
+#include <algorithm>
+
+LookaheadSyncClient::LookaheadSyncClient(Core* core)
+   : m_core(core)
+   , m_server(dynamic_cast<LookaheadSyncServer*>(Sim()->getClockSkewMinimizationServer()))
+   , m_next_sync_time(SubsecondTime::Zero())
+   , m_next_event(SubsecondTime::Zero())
+   , m_published_time(SubsecondTime::Zero())
+{
+   LOG_ASSERT_ERROR(m_server, "LookaheadSyncClient requires a LookaheadSyncServer");
+}
+
+LookaheadSyncClient::~LookaheadSyncClient()
+{}
+
+void
+LookaheadSyncClient::synchronize(SubsecondTime time, bool ignore_time, bool abort_func(void*), void* abort_arg)
+{
+   SubsecondTime curr_elapsed_time = time;
+   if (time == SubsecondTime::Zero())
+      curr_elapsed_time = m_core->getPerformanceModel()->getElapsedTime();
+
+   SubsecondTime next_event = m_server->getNextEvent();
+   if (next_event != m_next_event)
+   {
+      // The next event moved: a periodic callback was done, or a core started waiting. If the time we last published
+      // is before it, we may be the core that has to move the global minimum past it, so call in once we get there.
+      // The server sets it to zero to have all cores call in, see LookaheadSyncServer::setDisable().
+      m_next_event = next_event;
+      if (m_published_time < next_event || next_event == SubsecondTime::Zero())
+         m_next_sync_time = std::min(m_next_sync_time, next_event);
+   }
+
+   // Fast path: we are within our window, and not behind an event we may have to move the global minimum past
+   if (curr_elapsed_time >= m_next_sync_time || ignore_time)
+   {
+      m_published_time = curr_elapsed_time;
+      m_next_sync_time = m_server->sync(m_core->getId(), curr_elapsed_time);
+   }
+}
@@ -0,0 +1,32 @@
+#ifndef __LOOKAHEAD_SYNC_CLIENT_H__
+#define __LOOKAHEAD_SYNC_CLIENT_H__
+
+#include "fixed_types.h"
+#include "clock_skew_minimization_object.h"
+#include "subsecond_time.h"
+
+// Forward Decls
+class Core;
+class LookaheadSyncServer;
+
+class LookaheadSyncClient : public ClockSkewMinimizationClient
+{
+   private:
+      Core* m_core;
+      LookaheadSyncServer* m_server;
+
+      SubsecondTime m_next_sync_time;   //< We can run until here without calling into the server
+      SubsecondTime m_next_event;       //< Last seen value of the server's next event
+      SubsecondTime m_published_time;   //< Time we last published to the server
+
+   public:
+      LookaheadSyncClient(Core* core);
+      ~LookaheadSyncClient();
+
+      void enable() {}
+      void disable() {}
+
+      void synchronize(SubsecondTime time, bool ignore_time, bool abort_func(void*) = NULL, void* abort_arg = NULL);
+};
+
+#endif /* __LOOKAHEAD_SYNC_CLIENT_H__ */
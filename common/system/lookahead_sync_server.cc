@@ -0,0 +1,349 @@
+#include "lookahead_sync_server.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "thread_manager.h"
+#include "core.h"
+#include "thread.h"
+#include "performance_model.h"
+#include "hooks_manager.h"
+#include "syscall_server.h"
+#include "config.h"
+#include "log.h"
+#include "stats.h"
+#include "config.hpp"
+#include "circular_log.h"
+
+#include <algorithm>
+
+LookaheadSyncServer::LookaheadSyncServer()
+   : m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_slots(new slot_t[m_num_cores])
+   , m_core_group(m_num_cores, INVALID_CORE_ID)
+   , m_core_thread(m_num_cores, INVALID_THREAD_ID)
+   , m_waiting(m_num_cores, false)
+   , m_wait_until(m_num_cores, SubsecondTime::Zero())
+   , m_core_cond(m_num_cores, NULL)
+   , m_global_time(SubsecondTime::Zero())
+   , m_fastforward(false)
+   , m_disable(false)
+   , m_in_update(false)
+   , m_num_waits(0)
+   , m_max_skew(SubsecondTime::Zero())
+{
+   m_quantum = SubsecondTime::NS() * (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lookahead/quantum");
+   m_window = SubsecondTime::NS() * (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lookahead/window");
+   LOG_ASSERT_ERROR(m_window > SubsecondTime::Zero(), "clock_skew_minimization/lookahead/window must be positive");
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      m_slots[core_id].time = SubsecondTime::MaxTime().getFS();
+      m_core_cond[core_id] = new ConditionVariable();
+   }
+
+   m_next_periodic = m_quantum;
+   m_next_event = m_next_periodic.getFS();
+
+   // Order our hooks to occur after possible reschedulings (which are done with ORDER_ACTION)
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_EXIT, LookaheadSyncServer::hookThreadExit, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_STALL, LookaheadSyncServer::hookThreadStall, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_MIGRATE, LookaheadSyncServer::hookThreadMigrate, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+
+   // Keep the barrier.global_time name so existing tools keep working
+   registerStatsMetric("barrier", 0, "global_time", &m_global_time);
+   registerStatsMetric("barrier", 0, "lookahead_waits", &m_num_waits);
+   registerStatsMetric("barrier", 0, "lookahead_max_skew", &m_max_skew);
+}
+
+LookaheadSyncServer::~LookaheadSyncServer()
+{
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+      delete m_core_cond[core_id];
+   delete [] m_slots;
+}
+
+core_id_t
+LookaheadSyncServer::getMaster(core_id_t core_id) const
+{
+   // In fast-forward, the SMT performance model in not active so every core (HW context) synchronizes by itself
+   if (m_fastforward || m_core_group[core_id] == INVALID_CORE_ID)
+      return core_id;
+   else
+      return m_core_group[core_id];
+}
+
+SubsecondTime
+LookaheadSyncServer::sync(core_id_t core_id, SubsecondTime time)
+{
+   core_id_t master_core_id = getMaster(core_id);
+   Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+
+   // m_core_thread is read by releaseThread() with the thread manager lock held, only take it to make a change
+   thread_id_t thread_id = core->getThread() ? core->getThread()->getId() : INVALID_THREAD_ID;
+   if (__atomic_load_n(&m_core_thread[master_core_id], __ATOMIC_RELAXED) != thread_id)
+   {
+      ScopedLock sl(Sim()->getThreadManager()->getLock());
+      __atomic_store_n(&m_core_thread[master_core_id], thread_id, __ATOMIC_RELAXED);
+   }
+
+   // Publish our time. This store and the loads in scanMin() are sequentially consistent, so of two cores
+   // passing the same point concurrently, at least one sees the other's new time.
+   __atomic_store_n(&m_slots[master_core_id].time, time.getFS(), __ATOMIC_SEQ_CST);
+
+   UInt64 global_min = scanMin(false);
+
+   // We may have moved the slowest core past a periodic callback, or past the point a waiting core is waiting for
+   if (global_min != SubsecondTime::MaxTime().getFS() && global_min >= __atomic_load_n(&m_next_event, __ATOMIC_SEQ_CST))
+   {
+      ScopedLock sl(Sim()->getThreadManager()->getLock());
+      update();
+   }
+
+   if (m_disable || m_fastforward)
+      return time + m_quantum;
+
+   if (global_min == SubsecondTime::MaxTime().getFS() || time <= SubsecondTime::FS(global_min) + m_window)
+   {
+      SubsecondTime next_sync = global_min == SubsecondTime::MaxTime().getFS() ? time + m_window : SubsecondTime::FS(global_min) + m_window;
+      // If we are behind the next event we may be the core that moves the global minimum past it, call back in
+      // when we get there. Cores that are already past it cannot move the minimum there.
+      SubsecondTime next_event = getNextEvent();
+      if (time < next_event)
+         next_sync = std::min(next_sync, next_event);
+      return next_sync;
+   }
+
+   // We're too far ahead of the slowest running core, wait for it to catch up
+   ScopedLock sl(Sim()->getThreadManager()->getLock());
+
+   CLOG("lookahead", "Core %d wait at %" PRId64 "ns (min %" PRId64 "ns)", core_id, time.getNS(), SubsecondTime::FS(global_min).getNS());
+   LOG_ASSERT_ERROR(m_waiting[master_core_id] == false, "Core(%i) or its sibling is already waiting", master_core_id);
+
+   ++m_num_waits;
+   m_max_skew = std::max(m_max_skew, time - SubsecondTime::FS(global_min));
+
+   m_waiting[master_core_id] = true;
+   m_wait_until[master_core_id] = time - m_window;
+   updateNextEvent();
+
+   core->getPerformanceModel()->barrierEnter();
+   while(m_waiting[master_core_id])
+   {
+      // Rescan, considering only cores that are actually running, in case the slowest core went away without us noticing
+      update();
+      if (!m_waiting[master_core_id])
+         break;
+      // Everything that can release us does so holding the thread manager lock, which wait() only gives up once we sleep
+      m_core_cond[master_core_id]->wait(Sim()->getThreadManager()->getLock());
+   }
+   core->getPerformanceModel()->barrierExit();
+
+   CLOG("lookahead", "Core %d resume", core_id);
+
+   // Our slot may have been cleared while waiting (e.g. if our thread migrated), call back in immediately to republish
+   return time;
+}
+
+UInt64
+LookaheadSyncServer::scanMin(bool check_running)
+{
+   UInt64 global_min = SubsecondTime::MaxTime().getFS();
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      // Only consider group masters
+      if (!m_fastforward && m_core_group[core_id] != INVALID_CORE_ID)
+         continue;
+      UInt64 time = __atomic_load_n(&m_slots[core_id].time, __ATOMIC_SEQ_CST);
+      if (time < global_min && (!check_running || isCoreRunning(core_id)))
+         global_min = time;
+   }
+   return global_min;
+}
+
+bool
+LookaheadSyncServer::isCoreRunning(core_id_t core_id)
+{
+   Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+   if (core->getState() == Core::RUNNING && core->getThread() && Sim()->getThreadManager()->isThreadRunning(core->getThread()->getId()))
+      return true;
+
+   if (!m_fastforward)
+   {
+      for(core_id_t sibling_core_id = 0; sibling_core_id < (core_id_t)m_num_cores; sibling_core_id++)
+      {
+         if (m_core_group[sibling_core_id] == core_id)
+         {
+            Core *sibling = Sim()->getCoreManager()->getCoreFromID(sibling_core_id);
+            if (sibling->getState() == Core::RUNNING && sibling->getThread() && Sim()->getThreadManager()->isThreadRunning(sibling->getThread()->getId()))
+               return true;
+         }
+      }
+   }
+
+   return false;
+}
+
+void
+LookaheadSyncServer::update()
+{
+   // Called with the thread manager lock held.
+   // HOOK_PERIODIC can cause threads to stall or migrate, which calls back into us through the hooks
+   if (m_in_update)
+      return;
+   m_in_update = true;
+
+   UInt64 global_min = scanMin(true);
+   while(!m_disable && global_min != SubsecondTime::MaxTime().getFS() && global_min >= m_next_periodic.getFS())
+   {
+      m_global_time = m_next_periodic;
+      CLOG("lookahead", "Periodic %" PRId64 "ns", m_next_periodic.getNS());
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC, static_cast<subsecond_time_t>(m_next_periodic).m_time);
+      m_next_periodic += m_quantum;
+      global_min = scanMin(true);
+   }
+
+   m_in_update = false;
+
+   wakeWaiting();
+}
+
+void
+LookaheadSyncServer::wakeWaiting()
+{
+   // Called with the thread manager lock held, after anything that can let a waiting core continue:
+   // the global minimum moving up, or the server being disabled or put into fast-forward
+   UInt64 global_min = scanMin(true);
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      if (m_waiting[core_id]
+          && (m_disable || m_fastforward || global_min == SubsecondTime::MaxTime().getFS() || m_wait_until[core_id].getFS() <= global_min))
+      {
+         m_waiting[core_id] = false;
+         m_core_cond[core_id]->signal();
+      }
+   }
+
+   updateNextEvent();
+}
+
+void
+LookaheadSyncServer::updateNextEvent()
+{
+   SubsecondTime next_event = m_next_periodic;
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+      if (m_waiting[core_id])
+         next_event = std::min(next_event, m_wait_until[core_id]);
+   __atomic_store_n(&m_next_event, next_event.getFS(), __ATOMIC_SEQ_CST);
+}
+
+void
+LookaheadSyncServer::releaseThread(thread_id_t thread_id)
+{
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; core_id++)
+   {
+      if (__atomic_load_n(&m_core_thread[core_id], __ATOMIC_RELAXED) == thread_id)
+      {
+         // Thread no longer runs here, stop holding back the other cores
+         __atomic_store_n(&m_slots[core_id].time, SubsecondTime::MaxTime().getFS(), __ATOMIC_SEQ_CST);
+         __atomic_store_n(&m_core_thread[core_id], INVALID_THREAD_ID, __ATOMIC_RELAXED);
+         if (m_waiting[core_id])
+         {
+            m_waiting[core_id] = false;
+            m_core_cond[core_id]->signal();
+         }
+      }
+   }
+   // The slowest core may have gone away, see if others can continue
+   update();
+}
+
+void
+LookaheadSyncServer::releaseAll()
+{
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; core_id++)
+   {
+      if (m_waiting[core_id])
+      {
+         m_waiting[core_id] = false;
+         m_core_cond[core_id]->signal();
+      }
+   }
+   updateNextEvent();
+}
+
+void
+LookaheadSyncServer::release()
+{
+   CLOG("lookahead", "Release");
+   releaseAll();
+}
+
+void
+LookaheadSyncServer::advance()
+{
+   // All threads are stalled: keep advancing time until a HOOK_PERIODIC wakes someone up
+   bool in_update = m_in_update;
+   m_in_update = true;
+   while(true)
+   {
+      m_global_time = m_next_periodic;
+      CLOG("lookahead", "Advance %" PRId64 "ns", m_next_periodic.getNS());
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC, static_cast<subsecond_time_t>(m_next_periodic).m_time);
+      m_next_periodic += m_quantum;
+
+      if (m_disable || Sim()->getThreadManager()->anyThreadRunning())
+         break;
+      LOG_ASSERT_ERROR(Sim()->getSyscallServer()->getNextTimeout(m_global_time) < SubsecondTime::MaxTime(), "No threads running, no timeout. Application has deadlocked...");
+   }
+   m_in_update = in_update;
+   wakeWaiting();
+}
+
+void
+LookaheadSyncServer::setDisable(bool disable)
+{
+   m_disable = disable;
+   if (disable)
+      releaseAll();
+   else
+      // Force all cores to call in and republish their time
+      __atomic_store_n(&m_next_event, 0, __ATOMIC_SEQ_CST);
+}
+
+void
+LookaheadSyncServer::setGroup(core_id_t core_id, core_id_t master_core_id)
+{
+   if (master_core_id != INVALID_CORE_ID)
+      LOG_ASSERT_ERROR(m_waiting[core_id] == false, "Core(%d) is waiting, cannot make it part of a group", core_id);
+
+   m_core_group[core_id] = master_core_id;
+}
+
+void
+LookaheadSyncServer::setFastForward(bool fastforward, SubsecondTime next_barrier_time)
+{
+   if (m_fastforward != fastforward)
+      CLOG("lookahead", "FastForward %d > %d", m_fastforward, fastforward);
+   m_fastforward = fastforward;
+   if (next_barrier_time != SubsecondTime::MaxTime())
+      m_next_periodic = std::max(m_next_periodic, next_barrier_time);
+   // Waiting cores are released in fast-forward, and groups change
+   wakeWaiting();
+}
+
+void
+LookaheadSyncServer::printState(void)
+{
+   printf("Lookahead state:");
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; core_id++)
+   {
+      if (m_core_group[core_id] != INVALID_CORE_ID)
+         printf(" .");
+      else if (m_waiting[core_id])
+         printf(" W");
+      else if (isCoreRunning(core_id))
+         printf(" R");
+      else
+         printf(" _");
+   }
+   printf("\n");
+}
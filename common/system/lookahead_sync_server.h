@@ -0,0 +1,84 @@
+#ifndef __LOOKAHEAD_SYNC_SERVER_H__
+#define __LOOKAHEAD_SYNC_SERVER_H__
+
+#include "fixed_types.h"
+#include "clock_skew_minimization_object.h"
+#include "cond.h"
+#include "hooks_manager.h"
+
+#include <vector>
+
+// Lookahead-based clock skew minimization: rather than having all cores meet at every quantum boundary,
+// each core may run ahead of the slowest running core by up to a fixed window.
+// Cores publish their local time into per-core slots; the global minimum is computed by scanning these
+// slots without taking any lock. Only cores that get too far ahead, and whoever advances the minimum
+// past the next interesting point in time (a periodic callback or a waiting core), take the thread manager lock.
+class LookaheadSyncServer : public ClockSkewMinimizationServer
+{
+   private:
+      struct slot_t
+      {
+         UInt64 time;            //< Published local time (fs), MaxTime when the core does not participate
+         UInt8 padding[64 - sizeof(UInt64)];
+      };
+
+      const UInt32 m_num_cores;
+      SubsecondTime m_quantum;               //< Interval of HOOK_PERIODIC callbacks
+      SubsecondTime m_window;                //< Maximum time a core can run ahead of the slowest running core
+      slot_t *m_slots;
+      std::vector<core_id_t> m_core_group;
+      std::vector<thread_id_t> m_core_thread;
+      std::vector<bool> m_waiting;
+      std::vector<SubsecondTime> m_wait_until;  //< A waiting core is released once the global minimum reaches this time
+      std::vector<ConditionVariable*> m_core_cond;
+      SubsecondTime m_global_time;
+      SubsecondTime m_next_periodic;
+      UInt64 m_next_event;                   //< min(m_next_periodic, m_wait_until[*]) in fs, read lock-free by clients
+      bool m_fastforward;
+      volatile bool m_disable;
+      bool m_in_update;
+
+      UInt64 m_num_waits;
+      SubsecondTime m_max_skew;
+
+      core_id_t getMaster(core_id_t core_id) const;
+      UInt64 scanMin(bool check_running);
+      bool isCoreRunning(core_id_t core_id);
+      void update();
+      void wakeWaiting();
+      void updateNextEvent();
+      void releaseAll();
+      void releaseThread(thread_id_t thread_id);
+
+      static SInt64 hookThreadExit(UInt64 object, UInt64 argument) {
+         ((LookaheadSyncServer*)object)->releaseThread(((HooksManager::ThreadTime*)argument)->thread_id); return 0;
+      }
+      static SInt64 hookThreadStall(UInt64 object, UInt64 argument) {
+         ((LookaheadSyncServer*)object)->releaseThread(((HooksManager::ThreadStall*)argument)->thread_id); return 0;
+      }
+      static SInt64 hookThreadMigrate(UInt64 object, UInt64 argument) {
+         ((LookaheadSyncServer*)object)->releaseThread(((HooksManager::ThreadMigrate*)argument)->thread_id); return 0;
+      }
+
+   public:
+      LookaheadSyncServer();
+      ~LookaheadSyncServer();
+
+      // Publish core_id's time, wait if it is too far ahead, and return the time until which it can run without calling us again
+      SubsecondTime sync(core_id_t core_id, SubsecondTime time);
+      SubsecondTime getNextEvent() const { return SubsecondTime::FS(__atomic_load_n(&m_next_event, __ATOMIC_RELAXED)); }
+
+      virtual void setDisable(bool disable);
+      virtual void setGroup(core_id_t core_id, core_id_t master_core_id);
+      void synchronize(core_id_t core_id, SubsecondTime time) { sync(core_id, time); }
+      void release();
+      void advance();
+      void setFastForward(bool fastforward, SubsecondTime next_barrier_time = SubsecondTime::MaxTime());
+      SubsecondTime getGlobalTime(bool upper_bound = false) { return upper_bound ? m_next_periodic : m_global_time; }
+      void setBarrierInterval(SubsecondTime barrier_interval) { m_quantum = barrier_interval; }
+      SubsecondTime getBarrierInterval() const { return m_quantum; }
+
+      void printState(void);
+};
+
+#endif /* __LOOKAHEAD_SYNC_SERVER_H__ */
@@ -23,8 +23,8 @@ MemoryTracker::~MemoryTracker()
 
    for(auto it = m_allocation_sites.begin(); it != m_allocation_sites.end(); ++it)
    {
-      const CallStack &stack = it->first;
-      const AllocationSite *site = it->second;
+      const CallStack stack = (*it)->getStack();
+      const AllocationSite *site = (AllocationSite*)(*it)->m_data;
 
       if (site->total_loads + site->total_stores)
       {
@@ -68,16 +68,14 @@ void MemoryTracker::logMalloc(thread_id_t thread_id, UInt64 eip, UInt64 address,
    ScopedLock sl(m_lock);
 
    ::RoutineTracerThread *tracer = Sim()->getThreadManager()->getThreadFromID(thread_id)->getRoutineTracer();
-   const CallStack stack = dynamic_cast<MemoryTracker::RoutineTracerThread*>(tracer)->getCallsiteStack();
+   CallingContext *context = dynamic_cast<MemoryTracker::RoutineTracerThread*>(tracer)->getCallsiteContext();
 
-   AllocationSite *site = NULL;
-   AllocationSites::iterator it = m_allocation_sites.find(stack);
-   if (it != m_allocation_sites.end())
-      site = it->second;
-   else
+   AllocationSite *site = (AllocationSite*)context->m_data;
+   if (!site)
    {
       site = new AllocationSite();
-      m_allocation_sites[stack] = site;
+      context->m_data = site;
+      m_allocation_sites.push_back(context);
    }
 
    // Store the first address of the first cache line that no longer belongs to the allocation
@@ -113,8 +111,8 @@ void MemoryTracker::logMalloc(thread_id_t thread_id, UInt64 eip, UInt64 address,
          m_allocations_slow[addr] = site;
    #endif
 
-   m_allocation_sites[stack]->num_allocations++;
-   m_allocation_sites[stack]->total_size += size;
+   site->num_allocations++;
+   site->total_size += size;
 }
 
 void MemoryTracker::logFree(thread_id_t thread_id, UInt64 eip, UInt64 address)
@@ -203,10 +201,11 @@ bool MemoryTracker::RoutineTracer::hasRoutine(IntPtr eip)
 
 void MemoryTracker::RoutineTracerThread::functionEnter(IntPtr eip, IntPtr callEip)
 {
-   m_callsite_stack.push_back(callEip);
+   m_callsite_context = m_callsite_context->getChild(callEip);
 }
 
 void MemoryTracker::RoutineTracerThread::functionExit(IntPtr eip)
 {
-   m_callsite_stack.pop_back();
+   if (m_callsite_context->m_parent)
+      m_callsite_context = m_callsite_context->m_parent;
 }
@@ -20,15 +20,15 @@ class MemoryTracker
       class RoutineTracerThread : public ::RoutineTracerThread
       {
          public:
-            RoutineTracerThread(Thread *thread) : ::RoutineTracerThread(thread) {}
-            const CallStack& getCallsiteStack() const { return m_callsite_stack; }
+            RoutineTracerThread(Thread *thread, CallingContext *callsites) : ::RoutineTracerThread(thread), m_callsite_context(callsites) {}
+            CallingContext* getCallsiteContext() const { return m_callsite_context; }
          protected:
             virtual void functionEnter(IntPtr eip, IntPtr callEip);
             virtual void functionExit(IntPtr eip);
             virtual void functionChildEnter(IntPtr eip, IntPtr eip_child) {}
             virtual void functionChildExit(IntPtr eip, IntPtr eip_child) {}
          private:
-            CallStack m_callsite_stack;
+            CallingContext *m_callsite_context;    //< Context in the tree of call sites (rather than called routines)
       };
       class RoutineTracer : public ::RoutineTracer
       {
@@ -36,7 +36,7 @@ class MemoryTracker
             RoutineTracer();
             virtual ~RoutineTracer();
 
-            virtual RoutineTracerThread* getThreadHandler(Thread *thread) { return new RoutineTracerThread(thread); }
+            virtual RoutineTracerThread* getThreadHandler(Thread *thread) { return new RoutineTracerThread(thread, m_callsites.getRoot()); }
             virtual void addRoutine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename);
             virtual bool hasRoutine(IntPtr eip);
 
@@ -46,6 +46,7 @@ class MemoryTracker
             Lock m_lock;
             typedef std::unordered_map<IntPtr, RoutineTracer::Routine*> RoutineMap;
             RoutineMap m_routines;
+            CallingContextTree m_callsites;
       };
 
       MemoryTracker();
@@ -68,7 +69,8 @@ class MemoryTracker
          std::vector<UInt64> hit_where_load, hit_where_store;
          std::unordered_map<AllocationSite*, UInt64> evicted_by;
       };
-      typedef std::unordered_map<CallStack, AllocationSite*> AllocationSites;
+      // Allocation sites are stored in the m_data field of their call-site context, this lists the contexts that have one
+      typedef std::vector<CallingContext*> AllocationSites;
 
       struct Allocation
       {
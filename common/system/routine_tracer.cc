@@ -8,9 +8,12 @@
 #include "memory_tracker.h"
 
 #include <cstring>
+#include <vector>
 
 RoutineTracerThread::RoutineTracerThread(Thread *thread)
    : m_thread(thread)
+   , m_context(Sim()->getRoutineTracer()->getRootContext())
+   , m_last_esp(0)
 {
    Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, __hook_roi_begin, (UInt64)this);
    Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __hook_roi_end, (UInt64)this);
@@ -29,11 +32,11 @@ void RoutineTracerThread::routineEnter(IntPtr eip, IntPtr esp, IntPtr callEip)
 
 void RoutineTracerThread::routineEnter_unlocked(IntPtr eip, IntPtr esp, IntPtr callEip)
 {
-   if (m_stack.size())
+   if (inRoutine())
       if (Sim()->getMagicServer()->inROI())
-         functionChildEnter(m_stack.back(), eip);
+         functionChildEnter(currentRoutine(), eip);
 
-   m_stack.push_back(eip);
+   m_context = m_context->getChild(eip);
    m_last_esp = esp;
 
    if (Sim()->getMagicServer()->inROI())
@@ -44,11 +47,11 @@ void RoutineTracerThread::routineExit(IntPtr eip, IntPtr esp)
 {
    ScopedLock sl(m_lock);
 
-   if (m_stack.size() == 0)
+   if (!inRoutine())
       return;
 
    bool found = true;
-   if (m_stack.back() != eip)
+   if (currentRoutine() != eip)
    {
       // If we are returning from a function that's not at the top of the stack, search for it further down
       found = unwindTo(eip);
@@ -63,26 +66,26 @@ void RoutineTracerThread::routineExit(IntPtr eip, IntPtr esp)
       // Unwound into eip, now exit it
       if (Sim()->getMagicServer()->inROI())
          functionExit(eip);
-      m_stack.pop_back();
+      m_context = m_context->m_parent;
    }
 
    m_last_esp = esp;
 
-   if (m_stack.size())
+   if (inRoutine())
       if (Sim()->getMagicServer()->inROI())
-         functionChildExit(m_stack.back(), eip);
+         functionChildExit(currentRoutine(), eip);
 }
 
 void RoutineTracerThread::routineAssert(IntPtr eip, IntPtr esp)
 {
    ScopedLock sl(m_lock);
 
-   if (m_stack.size() == 0)
+   if (!inRoutine())
    {
       // Newly created thread just jumps into the first routine
       routineEnter_unlocked(eip, esp, 0);
    }
-   else if (m_stack.back() == eip)
+   else if (currentRoutine() == eip)
    {
       // We are where we think we are, no action
    }
@@ -108,24 +111,24 @@ void RoutineTracerThread::routineAssert(IntPtr eip, IntPtr esp)
       }
 
       // After all this, the current function should be at the top of the stack
-      LOG_ASSERT_ERROR(m_stack.back() == eip, "Expected to be in function %lx but now in %lx", eip, m_stack.back());
+      LOG_ASSERT_ERROR(currentRoutine() == eip, "Expected to be in function %lx but now in %lx", eip, currentRoutine());
    }
 }
 
 bool RoutineTracerThread::unwindTo(IntPtr eip)
 {
-   for(CallStack::reverse_iterator it = m_stack.rbegin(); it != m_stack.rend(); ++it)
+   for(CallingContext *context = m_context; context->m_parent; context = context->m_parent)
    {
-      if (*it == eip)
+      if (context->m_eip == eip)
       {
          // We found this eip further down the stack: unwind
-         while(m_stack.back() != eip)
+         while(currentRoutine() != eip)
          {
             if (Sim()->getMagicServer()->inROI())
-               functionExit(m_stack.back());
-            m_stack.pop_back();
+               functionExit(currentRoutine());
+            m_context = m_context->m_parent;
             if (Sim()->getMagicServer()->inROI())
-               functionChildExit(m_stack.back(), eip);
+               functionChildExit(currentRoutine(), eip);
          }
          return true;
       }
@@ -137,13 +140,19 @@ void RoutineTracerThread::hookRoiBegin()
 {
    ScopedLock sl(m_lock);
 
-   IntPtr eip_parent = 0;
-   for(CallStack::iterator it = m_stack.begin(); it != m_stack.end(); ++it)
+   // Enter all functions on the stack, outermost first, moving m_context along so that
+   // functionEnter sees the context of the function being entered.
+   std::vector<CallingContext*> path;
+   for(CallingContext *context = m_context; context->m_parent; context = context->m_parent)
+      path.push_back(context);
+
+   m_context = Sim()->getRoutineTracer()->getRootContext();
+   for(std::vector<CallingContext*>::reverse_iterator it = path.rbegin(); it != path.rend(); ++it)
    {
-      if (eip_parent)
-         functionChildEnter(eip_parent, *it);
-      functionEnter(*it, 0);
-      eip_parent = *it;
+      if (inRoutine())
+         functionChildEnter(currentRoutine(), (*it)->m_eip);
+      m_context = *it;
+      functionEnter(currentRoutine(), 0);
    }
 }
 
@@ -152,25 +161,20 @@ void RoutineTracerThread::hookRoiEnd()
    ScopedLock sl(m_lock);
 
    // Call functionExit for all functions that are left on the stack.
-   // Since functionExit might use m_stack we need to keep it up-to-date by popping items off,
-   // we'll use stack_save to remember them and restore m_stack to its original state on exit.
-   CallStack stack_save;
+   // Since functionExit might use m_context we need to keep it up-to-date by moving to the parent,
+   // and restore it to the innermost context on exit.
+   CallingContext *context_save = m_context;
    IntPtr eip_child = 0;
 
-   while(m_stack.size())
+   while(inRoutine())
    {
       if (eip_child)
-         functionChildExit(m_stack.back(), eip_child);
-      functionExit(m_stack.back());
-      eip_child = m_stack.back();
-      stack_save.push_back(m_stack.back());
-      m_stack.pop_back();
-   }
-   while(stack_save.size())
-   {
-      m_stack.push_back(stack_save.back());
-      stack_save.pop_back();
+         functionChildExit(currentRoutine(), eip_child);
+      functionExit(currentRoutine());
+      eip_child = currentRoutine();
+      m_context = m_context->m_parent;
    }
+   m_context = context_save;
 }
 
 RoutineTracer::Routine::Routine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename)
@@ -3,27 +3,10 @@
 
 #include "fixed_types.h"
 #include "subsecond_time.h"
-
-#include <deque>
-#include <boost/functional/hash.hpp>
-
-// From http://stackoverflow.com/questions/8027368/are-there-no-specializations-of-stdhash-for-standard-containers
-namespace std
-{
-   template<typename T>
-   struct hash<std::deque<T> >
-   {
-      size_t operator()(const std::deque<T>& a) const
-      {
-         return boost::hash_range(a.begin(), a.end());
-      }
-   };
-}
+#include "calling_context.h"
 
 class Thread;
 
-typedef std::deque<IntPtr> CallStack;
-
 class RoutineTracerThread
 {
    public:
@@ -34,14 +17,17 @@ class RoutineTracerThread
       void routineExit(IntPtr eip, IntPtr esp);
       void routineAssert(IntPtr eip, IntPtr esp);
 
-      const CallStack& getCallStack() const { return m_stack; }
+      CallStack getCallStack() const { return m_context->getStack(); }
 
    protected:
       Lock m_lock;
       Thread *m_thread;
-      CallStack m_stack;
+      CallingContext *m_context;    //< Current calling context, the tree's root when no routine is active
       IntPtr m_last_esp;
 
+      bool inRoutine() const { return m_context->m_depth > 0; }
+      IntPtr currentRoutine() const { return m_context->m_eip; }
+
    private:
       bool unwindTo(IntPtr eip);
 
@@ -83,6 +69,12 @@ class RoutineTracer
       virtual RoutineTracerThread* getThreadHandler(Thread *thread) = 0;
 
       virtual const Routine* getRoutineInfo(IntPtr eip) { return NULL; }
+
+      // Calling contexts of all threads
+      CallingContext* getRootContext() { return m_contexts.getRoot(); }
+
+   private:
+      CallingContextTree m_contexts;
 };
 
 #endif // __ROUTINE_TRACER_H
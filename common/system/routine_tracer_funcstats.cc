@@ -59,15 +59,15 @@ void RoutineTracerFunctionStats::RtnThread::functionEndHelper(IntPtr eip, UInt64
    m_master->updateRoutine(eip, count, values);
 }
 
-void RoutineTracerFunctionStats::RtnThread::functionEndFullHelper(const CallStack &stack, UInt64 count)
+void RoutineTracerFunctionStats::RtnThread::functionEndFullHelper(CallingContext *context, UInt64 count)
 {
    RtnValues values;
    const ThreadStatsManager::ThreadStatTypeList& types = Sim()->getThreadStatsManager()->getThreadStatTypes();
    for(auto it = types.begin(); it != types.end(); ++it)
    {
-      values[*it] = getThreadStat(*it) - m_values_start_full[stack][*it];
+      values[*it] = getThreadStat(*it) - m_values_start_full[*it];
    }
-   m_master->updateRoutineFull(stack, count, values);
+   m_master->updateRoutineFull(context, count, values);
 }
 
 void RoutineTracerFunctionStats::RtnThread::functionBegin(IntPtr eip)
@@ -75,8 +75,8 @@ void RoutineTracerFunctionStats::RtnThread::functionBegin(IntPtr eip)
    Sim()->getThreadStatsManager()->update(m_thread->getId());
 
    functionBeginHelper(eip, m_values_start);
-   if (m_stack.size())
-      functionBeginHelper(eip, m_values_start_full[m_stack]);
+   if (inRoutine())
+      functionBeginHelper(eip, m_values_start_full);
 
 }
 
@@ -85,8 +85,8 @@ void RoutineTracerFunctionStats::RtnThread::functionEnd(IntPtr eip, bool is_func
    Sim()->getThreadStatsManager()->update(m_thread->getId());
 
    functionEndHelper(eip, is_function_start ? 1 : 0);
-   if (m_stack.size())
-      functionEndFullHelper(m_stack, is_function_start ? 1 : 0);
+   if (inRoutine())
+      functionEndFullHelper(m_context, is_function_start ? 1 : 0);
 }
 
 UInt64 RoutineTracerFunctionStats::RtnThread::getThreadStat(ThreadStatsManager::ThreadStatType type)
@@ -98,8 +98,8 @@ UInt64 RoutineTracerFunctionStats::RtnThread::getCurrentRoutineId()
 {
    ScopedLock sl(m_lock);
 
-   if (m_stack.size())
-      return (UInt64)m_master->getRoutineFullPtr(m_stack);
+   if (inRoutine())
+      return (UInt64)m_master->getRoutineFullPtr(m_context);
    else
       return 0;
 }
@@ -203,27 +203,27 @@ void RoutineTracerFunctionStats::RtnMaster::updateRoutine(IntPtr eip, UInt64 cal
    }
 }
 
-RoutineTracerFunctionStats::Routine* RoutineTracerFunctionStats::RtnMaster::getRoutineFullPtr(const CallStack& stack)
+RoutineTracerFunctionStats::Routine* RoutineTracerFunctionStats::RtnMaster::getRoutineFullPtr(CallingContext *context)
 {
    ScopedLock sl(m_lock);
 
-   if (m_routines.count(stack.back()) == 0)
+   if (context->m_data == NULL)
    {
-      m_routines[stack.back()] = new RoutineTracerFunctionStats::Routine(stack.back(), "(unknown)", "(unknown)", 0, 0, 0, "");
-      m_routines[stack.back()]->setProvisional(true);
-   }
+      if (m_routines.count(context->m_eip) == 0)
+      {
+         m_routines[context->m_eip] = new RoutineTracerFunctionStats::Routine(context->m_eip, "(unknown)", "(unknown)", 0, 0, 0, "");
+         m_routines[context->m_eip]->setProvisional(true);
+      }
 
-   if (m_callstack_routines.count(stack) == 0)
-   {
-      m_callstack_routines[stack] = new RoutineTracerFunctionStats::Routine(*m_routines[stack.back()]);
+      context->m_data = new RoutineTracerFunctionStats::Routine(*m_routines[context->m_eip]);
    }
 
-   return m_callstack_routines[stack];
+   return (RoutineTracerFunctionStats::Routine*)context->m_data;
 }
 
-void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(const CallStack& stack, UInt64 calls, RtnValues values)
+void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(CallingContext *context, UInt64 calls, RtnValues values)
 {
-   updateRoutineFull(getRoutineFullPtr(stack), calls, values);
+   updateRoutineFull(getRoutineFullPtr(context), calls, values);
 }
 
 void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(RoutineTracerFunctionStats::Routine* rtn, UInt64 calls, RtnValues values)
@@ -279,21 +279,25 @@ void RoutineTracerFunctionStats::RtnMaster::writeResultsFull(const char *filenam
          fprintf(fp, ":%" PRIxPTR "\t%s\t%s\n", it->second->m_eip, it->second->m_name, it->second->m_location);
    }
 
-   // now print context-aware statistics
-   for(auto it = m_callstack_routines.begin(); it != m_callstack_routines.end(); ++it)
+   // now print context-aware statistics, one line per calling context
+   std::vector<CallingContext*> contexts;
+   getRootContext()->getDescendants(contexts);
+   for(std::vector<CallingContext*>::iterator it = contexts.begin(); it != contexts.end(); ++it)
    {
-      if (it->second->m_calls)
+      RoutineTracerFunctionStats::Routine *rtn = (RoutineTracerFunctionStats::Routine*)(*it)->m_data;
+      if (rtn && rtn->m_calls)
       {
+         const CallStack stack = (*it)->getStack();
          std::ostringstream s;
-         s << std::hex << it->first.front();
-         for (auto kt = ++it->first.begin(); kt != it->first.end(); ++kt)
+         s << std::hex << stack.front();
+         for (CallStack::const_iterator kt = ++stack.begin(); kt != stack.end(); ++kt)
          {
             s << ":" << std::hex << *kt << std::dec;
          }
          fprintf(fp, "%s\t%" PRId64 "\t%" PRId64 "\t%" PRId64,
-            s.str().c_str(), it->second->m_calls, it->second->m_bits_used, it->second->m_bits_total);
+            s.str().c_str(), rtn->m_calls, rtn->m_bits_used, rtn->m_bits_total);
          for(ThreadStatsManager::ThreadStatTypeList::const_iterator jt = types.begin(); jt != types.end(); ++jt)
-            fprintf(fp, "\t%" PRId64, it->second->m_values[*jt]);
+            fprintf(fp, "\t%" PRId64, rtn->m_values[*jt]);
          fprintf(fp, "\n");
       }
    }
@@ -49,18 +49,17 @@ class RoutineTracerFunctionStats
             virtual void addRoutine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename);
             virtual bool hasRoutine(IntPtr eip);
             void updateRoutine(IntPtr eip, UInt64 calls, RtnValues values);
-            void updateRoutineFull(const CallStack& stack, UInt64 calls, RtnValues values);
+            void updateRoutineFull(CallingContext *context, UInt64 calls, RtnValues values);
             void updateRoutineFull(RoutineTracerFunctionStats::Routine* rtn, UInt64 calls, RtnValues values);
-            RoutineTracerFunctionStats::Routine* getRoutineFullPtr(const CallStack& stack);
+            RoutineTracerFunctionStats::Routine* getRoutineFullPtr(CallingContext *context);
 
          private:
             Lock m_lock;
             // Flat-profile per-thread statistics (excludes statistics from child calls).
             typedef std::unordered_map<IntPtr, RoutineTracerFunctionStats::Routine*> RoutineMap;
             RoutineMap m_routines;
-            // Call-stack-based statistics (includes statistics from child calls).
-            typedef std::unordered_map<CallStack, RoutineTracerFunctionStats::Routine*> RoutineMapFull;
-            RoutineMapFull m_callstack_routines;
+            // Call-stack-based statistics (includes statistics from child calls) are kept in the calling context tree,
+            // each CallingContext's m_data points to its RoutineTracerFunctionStats::Routine.
 
             UInt64 ce_get_owner(core_id_t core_id, UInt64 address);
             void ce_notify_evict(bool on_roi_end, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total);
@@ -85,14 +84,14 @@ class RoutineTracerFunctionStats
 
             IntPtr m_current_eip;
             RtnValues m_values_start;
-            std::unordered_map<CallStack, RtnValues> m_values_start_full;
+            RtnValues m_values_start_full;   //< Start values for the current calling context
 
             void functionBegin(IntPtr eip);
             void functionEnd(IntPtr eip, bool is_function_start);
 
             void functionBeginHelper(IntPtr eip, RtnValues&);
             void functionEndHelper(IntPtr eip, UInt64 count);
-            void functionEndFullHelper(const CallStack &stack, UInt64 count);
+            void functionEndFullHelper(CallingContext *context, UInt64 count);
 
             UInt64 getThreadStat(ThreadStatsManager::ThreadStatType type);
 
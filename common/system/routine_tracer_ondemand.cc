@@ -18,9 +18,9 @@ void RoutineTracerOndemand::RtnThread::printStack()
    printf("\n");
    if (m_thread->getSyscallMdl()->inSyscall())
       printf("\tSyscall: %s\n", m_thread->getSyscallMdl()->formatSyscall().c_str());
-   for(std::deque<IntPtr>::reverse_iterator it = m_stack.rbegin(); it != m_stack.rend(); ++it)
+   for(CallingContext *context = m_context; context->m_parent; context = context->m_parent)
    {
-      printf("\t(%12" PRIxPTR ") %s\n", *it, m_master->getRoutine(*it) ? m_master->getRoutine(*it)->m_name : "(unknown)");
+      printf("\t(%12" PRIxPTR ") %s\n", context->m_eip, m_master->getRoutine(context->m_eip) ? m_master->getRoutine(context->m_eip)->m_name : "(unknown)");
    }
    printf("\n");
 }
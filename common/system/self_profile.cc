@@ -0,0 +1,119 @@
+#include "self_profile.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+struct SelfProfile::HostThread
+{
+   UInt64 tid;                               //< Linux thread id, to match with the host's view of the process
+   Scope *current;                           //< Innermost active scope
+   UInt32 depth[NUM_SUBSYSTEMS];             //< Active scopes per subsystem, time is counted by the outermost one
+   UInt64 calls[NUM_SUBSYSTEMS];
+   UInt64 cycles[NUM_SUBSYSTEMS];
+   UInt64 self_cycles[NUM_SUBSYSTEMS];
+   // Reported values, converted from cycles before each statistics snapshot
+   SubsecondTime time[NUM_SUBSYSTEMS];
+   SubsecondTime self_time[NUM_SUBSYSTEMS];
+   bool registered;
+};
+
+static const char *subsystem_names[] = { "trace", "core", "cache", "network", "barrier", "hooks" };
+static_assert(SelfProfile::NUM_SUBSYSTEMS == sizeof(subsystem_names) / sizeof(subsystem_names[0]),
+              "Not enough values in subsystem_names");
+
+bool SelfProfile::s_enabled = false;
+__thread SelfProfile::HostThread *SelfProfile::t_thread = NULL;
+Lock SelfProfile::s_lock;
+std::vector<SelfProfile::HostThread*> SelfProfile::s_threads;
+static UInt64 s_tsc_start = 0, s_ns_start = 0;
+
+void SelfProfile::init()
+{
+   s_tsc_start = rdtsc();
+   s_ns_start = Timer::now();
+   setEnabled(Sim()->getCfg()->getBoolDefault("general/self_profile", false));
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, hook_pre_stat_write, 0, HooksManager::ORDER_NOTIFY_PRE);
+}
+
+SelfProfile::HostThread* SelfProfile::registerThread()
+{
+   HostThread *thread = new HostThread();
+   thread->tid = syscall(SYS_gettid);
+   thread->current = NULL;
+   for(UInt32 subsystem = 0; subsystem < NUM_SUBSYSTEMS; ++subsystem)
+   {
+      thread->depth[subsystem] = 0;
+      thread->calls[subsystem] = 0;
+      thread->cycles[subsystem] = 0;
+      thread->self_cycles[subsystem] = 0;
+      thread->time[subsystem] = SubsecondTime::Zero();
+      thread->self_time[subsystem] = SubsecondTime::Zero();
+   }
+   // Statistics are registered from the statistics writer, see update()
+   thread->registered = false;
+
+   ScopedLock sl(s_lock);
+   s_threads.push_back(thread);
+   return thread;
+}
+
+void SelfProfile::Scope::begin(subsystem_t subsystem)
+{
+   if (!t_thread)
+      t_thread = registerThread();
+
+   m_thread = t_thread;
+   m_subsystem = subsystem;
+   m_parent = m_thread->current;
+   m_children = 0;
+   m_thread->current = this;
+   ++m_thread->depth[subsystem];
+   ++m_thread->calls[subsystem];
+   m_start = rdtsc();
+}
+
+void SelfProfile::Scope::end()
+{
+   UInt64 elapsed = rdtsc() - m_start;
+
+   if (--m_thread->depth[m_subsystem] == 0)
+      m_thread->cycles[m_subsystem] += elapsed;
+   m_thread->self_cycles[m_subsystem] += elapsed - m_children;
+
+   if (m_parent)
+      m_parent->m_children += elapsed;
+   m_thread->current = m_parent;
+}
+
+void SelfProfile::update()
+{
+   UInt64 tsc = rdtsc() - s_tsc_start, ns = Timer::now() - s_ns_start;
+   double ns_per_cycle = tsc ? double(ns) / tsc : 0.;
+
+   ScopedLock sl(s_lock);
+
+   for(UInt32 index = 0; index < s_threads.size(); ++index)
+   {
+      HostThread *thread = s_threads[index];
+      if (!thread->registered)
+      {
+         registerStatsMetric("self_profile", index, "host_tid", &thread->tid);
+         for(UInt32 subsystem = 0; subsystem < NUM_SUBSYSTEMS; ++subsystem)
+         {
+            registerStatsMetric("self_profile", index, String(subsystem_names[subsystem]) + "_calls", &thread->calls[subsystem]);
+            registerStatsMetric("self_profile", index, String(subsystem_names[subsystem]) + "_time", &thread->time[subsystem]);
+            registerStatsMetric("self_profile", index, String(subsystem_names[subsystem]) + "_self_time", &thread->self_time[subsystem]);
+         }
+         thread->registered = true;
+      }
+      for(UInt32 subsystem = 0; subsystem < NUM_SUBSYSTEMS; ++subsystem)
+      {
+         thread->time[subsystem] = SubsecondTime::NS(thread->cycles[subsystem] * ns_per_cycle);
+         thread->self_time[subsystem] = SubsecondTime::NS(thread->self_cycles[subsystem] * ns_per_cycle);
+      }
+   }
+}
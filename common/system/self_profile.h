@@ -0,0 +1,78 @@
+#ifndef __SELF_PROFILE_H
+#define __SELF_PROFILE_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "timer.h"
+#include "lock.h"
+
+#include <vector>
+
+// Host-time accounting of the simulator itself (general/self_profile, or sim_control.set_self_profile() at runtime).
+// A Scope placed at the main entry point of a subsystem counts TSC cycles and calls per host thread.
+// Time is counted both inclusive, from the outermost scope of a subsystem on a thread, and self, excluding nested
+// scopes: the trace frontend's self time does not include the core timing model and caches it calls into, and the
+// self times of a host thread add up to the time it spent inside scopes. Results are self_profile.<subsystem>_{calls,time,self_time} statistics, indexed by host thread.
+// When profiling is off, a Scope costs a load and a branch.
+class SelfProfile
+{
+   private:
+      struct HostThread;
+
+   public:
+      enum subsystem_t
+      {
+         TRACE,      //< TraceThread::run
+         CORE,       //< PerformanceModel::iterate
+         CACHE,      //< CacheCntlr::processMemOpFromCore
+         NETWORK,    //< Network::netSend
+         BARRIER,    //< BarrierSyncServer::synchronize
+         HOOKS,      //< HooksManager::callHooks
+         NUM_SUBSYSTEMS
+      };
+
+      class Scope
+      {
+         public:
+            Scope(subsystem_t subsystem)
+               : m_thread(NULL)
+            {
+               if (__builtin_expect(__atomic_load_n(&s_enabled, __ATOMIC_RELAXED), 0))
+                  begin(subsystem);
+            }
+            ~Scope()
+            {
+               if (__builtin_expect(m_thread != NULL, 0))
+                  end();
+            }
+
+         private:
+            HostThread *m_thread;
+            Scope *m_parent;
+            subsystem_t m_subsystem;
+            UInt64 m_start;
+            UInt64 m_children;      //< Cycles spent in nested scopes
+
+            void begin(subsystem_t subsystem);
+            void end();
+
+            friend class SelfProfile;
+      };
+
+      static void init();
+      static void setEnabled(bool enabled) { __atomic_store_n(&s_enabled, enabled, __ATOMIC_RELAXED); }
+      static bool isEnabled() { return __atomic_load_n(&s_enabled, __ATOMIC_RELAXED); }
+
+   private:
+      static bool s_enabled;
+      static __thread HostThread *t_thread;
+      static Lock s_lock;
+      static std::vector<HostThread*> s_threads;
+
+      static HostThread* registerThread();
+
+      static SInt64 hook_pre_stat_write(UInt64, UInt64) { update(); return 0; }
+      static void update();
+};
+
+#endif // __SELF_PROFILE_H
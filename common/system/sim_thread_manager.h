@@ -17,6 +17,7 @@ public:
    void simThreadExitCallback();
    
 private:
+   const bool m_core_threads_enabled;   //< perf_model/core/own_thread: each core's performance model runs on a CoreThread
    SimThread *m_sim_threads;
    CoreThread *m_core_threads;
 
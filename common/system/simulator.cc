@@ -27,6 +27,8 @@
 #include "instruction_tracer.h"
 #include "memory_tracker.h"
 #include "circular_log.h"
+#include "checkpoint_manager.h"
+#include "self_profile.h"
 
 #include <sstream>
 
@@ -120,6 +122,7 @@ Simulator::Simulator()
    , m_hooks_manager(NULL)
    , m_sampling_manager(NULL)
    , m_faultinjection_manager(NULL)
+   , m_checkpoint_manager(NULL)
    , m_rtn_tracer(NULL)
    , m_memory_tracker(NULL)
    , m_running(false)
@@ -135,6 +138,8 @@ void Simulator::start()
    createDecoder();
    
    m_hooks_manager = new HooksManager();
+   SelfProfile::init();
+   m_checkpoint_manager = new CheckpointManager();
    m_syscall_server = new SyscallServer();
    m_sync_server = new SyncServer();
    m_magic_server = new MagicServer();
@@ -165,6 +170,7 @@ void Simulator::start()
    PthreadEmu::init();
 
    m_hooks_manager->init();
+   m_checkpoint_manager->init();
    if (m_trace_manager)
       m_trace_manager->init();
 
@@ -251,6 +257,7 @@ Simulator::~Simulator()
    //delete m_thread_manager;            m_thread_manager = NULL;
    delete m_thread_stats_manager;      m_thread_stats_manager = NULL;
    delete m_core_manager;              m_core_manager = NULL;
+   delete m_checkpoint_manager;        m_checkpoint_manager = NULL;
    delete m_dvfs_manager;              m_dvfs_manager = NULL;
    delete m_magic_server;              m_magic_server = NULL;
    delete m_sync_server;               m_sync_server = NULL;
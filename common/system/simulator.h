@@ -27,6 +27,7 @@ class DvfsManager;
 class SamplingManager;
 class FaultinjectionManager;
 class TagsManager;
+class CheckpointManager;
 class RoutineTracer;
 class MemoryTracker;
 namespace config { class Config; }
@@ -68,6 +69,7 @@ public:
    FaultinjectionManager *getFaultinjectionManager() { return m_faultinjection_manager; }
    TraceManager *getTraceManager() { return m_trace_manager; }
    TagsManager *getTagsManager() { return m_tags_manager; }
+   CheckpointManager *getCheckpointManager() { return m_checkpoint_manager; }
    RoutineTracer *getRoutineTracer() { return m_rtn_tracer; }
    MemoryTracker *getMemoryTracker() { return m_memory_tracker; }
    void setMemoryTracker(MemoryTracker *memory_tracker) { m_memory_tracker = memory_tracker; }
@@ -104,6 +106,7 @@ private:
    HooksManager *m_hooks_manager;
    SamplingManager *m_sampling_manager;
    FaultinjectionManager *m_faultinjection_manager;
+   CheckpointManager *m_checkpoint_manager;
    RoutineTracer *m_rtn_tracer;
    MemoryTracker *m_memory_tracker;
 
@@ -0,0 +1,319 @@
+#include "trace_decode_ahead.h"
+#include "stats.h"
+#include "timer.h"
+#include "log.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <sched.h>
+
+TraceDecodeAhead::TraceDecodeAhead(UInt32 num_workers, UInt32 depth)
+   : m_depth(depth)
+   , m_batch(depth > 4 ? depth / 4 : 1)
+   , m_next_worker(0)
+   , m_stop(false)
+{
+   LOG_ASSERT_ERROR(num_workers > 0, "Decode-ahead requires at least one worker thread");
+   LOG_ASSERT_ERROR(depth > 0, "Decode-ahead ring depth must be positive");
+
+   for(UInt32 i = 0; i < num_workers; ++i)
+   {
+      m_workers.push_back(new Worker(this));
+      m_workers.back()->spawn();
+   }
+}
+
+TraceDecodeAhead::~TraceDecodeAhead()
+{
+   __atomic_store_n(&m_stop, true, __ATOMIC_RELEASE);
+   for(std::vector<Worker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+      delete *it;
+   for(std::unordered_map<thread_id_t, Stream::stats_t*>::iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+      delete it->second;
+}
+
+TraceDecodeAhead::Stream*
+TraceDecodeAhead::addStream(Sift::Reader *reader, thread_id_t thread_id, bool mirror_output, bool routines)
+{
+   Worker *worker;
+   Stream::stats_t *stats;
+   {
+      ScopedLock sl(m_lock);
+
+      // Stats need to outlive the TraceThread, keep them here
+      if (m_stats.count(thread_id) == 0)
+      {
+         stats = new Stream::stats_t();
+         stats->producer_stall = SubsecondTime::Zero();
+         stats->consumer_stall = SubsecondTime::Zero();
+         stats->entries = 0;
+         m_stats[thread_id] = stats;
+         registerStatsMetric("thread", thread_id, "decode_ahead_producer_stall_time", &stats->producer_stall);
+         registerStatsMetric("thread", thread_id, "decode_ahead_consumer_stall_time", &stats->consumer_stall);
+         registerStatsMetric("thread", thread_id, "decode_ahead_entries", &stats->entries);
+      }
+      else
+         stats = m_stats[thread_id];
+
+      // Static round-robin assignment of traces to workers
+      worker = m_workers[m_next_worker];
+      m_next_worker = (m_next_worker + 1) % m_workers.size();
+   }
+
+   Stream *stream = new Stream(reader, stats, m_depth, mirror_output, routines);
+
+   ScopedLock sl(worker->m_lock);
+   worker->m_streams.push_back(stream);
+
+   return stream;
+}
+
+void
+TraceDecodeAhead::removeStream(Stream *stream)
+{
+   for(std::vector<Worker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+   {
+      // Once we hold the worker's lock it is not inside fill(), so the stream can be released safely
+      ScopedLock sl((*it)->m_lock);
+      for(std::vector<Stream*>::iterator jt = (*it)->m_streams.begin(); jt != (*it)->m_streams.end(); ++jt)
+      {
+         if (*jt == stream)
+         {
+            (*it)->m_streams.erase(jt);
+            delete stream;
+            return;
+         }
+      }
+   }
+   LOG_PRINT_ERROR("Decode-ahead stream %p not found", stream);
+}
+
+
+TraceDecodeAhead::Worker::Worker(TraceDecodeAhead *pool)
+   : m_pool(pool)
+   , m_thread(NULL)
+   , m_exited(0)
+{
+}
+
+TraceDecodeAhead::Worker::~Worker()
+{
+   if (m_thread)
+   {
+      m_exited.wait();
+      delete m_thread;
+   }
+}
+
+void
+TraceDecodeAhead::Worker::spawn()
+{
+   m_thread = _Thread::create(this);
+   m_thread->run();
+}
+
+void
+TraceDecodeAhead::Worker::run()
+{
+   UInt32 idle = 0;
+
+   while(!__atomic_load_n(&m_pool->m_stop, __ATOMIC_ACQUIRE))
+   {
+      bool progress = false;
+      {
+         ScopedLock sl(m_lock);
+         for(std::vector<Stream*>::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+            progress |= (*it)->fill(m_pool->m_batch);
+      }
+
+      if (progress)
+      {
+         idle = 0;
+         continue;
+      }
+
+      // All our rings are full (or drained): back off, and charge the wait to every stream that still has data to produce
+      UInt64 t_start = Timer::now();
+      if (++idle < 64)
+         sched_yield();
+      else
+         usleep(100);
+      SubsecondTime elapsed = SubsecondTime::NS(Timer::now() - t_start);
+
+      ScopedLock sl(m_lock);
+      for(std::vector<Stream*>::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+         if (!(*it)->m_done && !__atomic_load_n(&(*it)->m_closed, __ATOMIC_ACQUIRE))
+            (*it)->m_stats->producer_stall += elapsed;
+   }
+
+   m_exited.signal();
+}
+
+
+TraceDecodeAhead::Stream::Stream(Sift::Reader *reader, stats_t *stats, UInt32 depth, bool mirror_output, bool routines)
+   : m_reader(reader)
+   , m_stats(stats)
+   , m_ring(depth)
+   , m_done(false)
+   , m_closed(false)
+   , m_position(reader->getPosition())
+{
+   // Redirect all callbacks to ourselves: they are now called from a worker thread
+   m_reader->setHandleCacheOnlyFunc(__handleCacheOnlyFunc, this);
+   if (mirror_output)
+      m_reader->setHandleOutputFunc(__handleOutputFunc, this);
+   if (routines)
+      m_reader->setHandleRoutineFunc(__handleRoutineChangeFunc, __handleRoutineAnnounceFunc, this);
+   m_reader->setHandleInstructionCountFunc(__handleInstructionCountFunc, this);
+   m_reader->setHandleSyscallFunc(__handleSyscallFunc, this);
+   m_reader->setHandleNewThreadFunc(__handleNewThreadFunc, this);
+   m_reader->setHandleJoinFunc(__handleJoinFunc, this);
+   m_reader->setHandleMagicFunc(__handleMagicFunc, this);
+   m_reader->setHandleEmuFunc(__handleEmuFunc, this);
+   m_reader->setHandleForkFunc(__handleForkFunc, this);
+}
+
+TraceDecodeAhead::Stream::~Stream()
+{
+   // Release payloads of entries that were never consumed
+   while(!m_ring.empty())
+   {
+      delete [] m_ring.front().data;
+      m_ring.pop();
+   }
+   for(std::deque<Entry>::iterator it = m_pending.begin(); it != m_pending.end(); ++it)
+      delete [] it->data;
+}
+
+void
+TraceDecodeAhead::Stream::unsupported(const char *what)
+{
+   LOG_PRINT_ERROR("SIFT %s record requires a response channel, which is not supported with decode-ahead", what);
+}
+
+TraceDecodeAhead::Entry&
+TraceDecodeAhead::Stream::front()
+{
+   if (m_ring.empty())
+   {
+      UInt64 t_start = Timer::now();
+      while(m_ring.empty())
+         sched_yield();
+      m_stats->consumer_stall += SubsecondTime::NS(Timer::now() - t_start);
+   }
+   return m_ring.front();
+}
+
+void
+TraceDecodeAhead::Stream::enqueue(const Entry &entry)
+{
+   // Keep ordering: once anything is pending, everything after it has to queue up behind it
+   if (m_pending.empty() && !m_ring.full())
+      m_ring.push(entry);
+   else
+      m_pending.push_back(entry);
+}
+
+bool
+TraceDecodeAhead::Stream::fill(UInt32 max_entries)
+{
+   if (__atomic_load_n(&m_closed, __ATOMIC_ACQUIRE))
+      return false;
+
+   bool progress = false;
+
+   while(!m_pending.empty() && !m_ring.full())
+   {
+      m_ring.push(m_pending.front());
+      m_pending.pop_front();
+      progress = true;
+   }
+
+   if (m_done || !m_pending.empty())
+      return progress;
+
+   UInt32 count = 0;
+   while(count < max_entries && !m_ring.full())
+   {
+      Entry entry;
+      entry.data = NULL;
+      if (m_reader->Read(entry.inst))
+      {
+         entry.type = Entry::INSTRUCTION;
+      }
+      else
+      {
+         entry.type = Entry::END;
+         m_done = true;
+      }
+      enqueue(entry);
+      ++count;
+      if (m_done)
+         break;
+   }
+
+   if (count)
+   {
+      m_stats->entries += count;
+      __atomic_store_n(&m_position, m_reader->getPosition(), __ATOMIC_RELAXED);
+   }
+
+   return progress || count;
+}
+
+void
+TraceDecodeAhead::Stream::__handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+{
+   Entry entry;
+   entry.type = Entry::CACHE_ONLY;
+   entry.args[0] = icount;
+   entry.args[1] = type;
+   entry.args[2] = eip;
+   entry.args[3] = address;
+   entry.data = NULL;
+   ((Stream*)arg)->enqueue(entry);
+}
+
+void
+TraceDecodeAhead::Stream::__handleOutputFunc(void* arg, uint8_t fd, const uint8_t *data, uint32_t size)
+{
+   Entry entry;
+   entry.type = Entry::OUTPUT;
+   entry.args[0] = fd;
+   entry.size = size;
+   entry.data = new char[size];
+   memcpy(entry.data, data, size);
+   ((Stream*)arg)->enqueue(entry);
+}
+
+void
+TraceDecodeAhead::Stream::__handleRoutineChangeFunc(void* arg, Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
+{
+   Entry entry;
+   entry.type = Entry::ROUTINE_CHANGE;
+   entry.args[0] = event;
+   entry.args[1] = eip;
+   entry.args[2] = esp;
+   entry.args[3] = callEip;
+   entry.data = NULL;
+   ((Stream*)arg)->enqueue(entry);
+}
+
+void
+TraceDecodeAhead::Stream::__handleRoutineAnnounceFunc(void* arg, uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
+{
+   // Pack the three strings as consecutive zero-terminated strings: name, imgname, filename
+   size_t len_name = strlen(name) + 1, len_imgname = strlen(imgname) + 1, len_filename = strlen(filename) + 1;
+   Entry entry;
+   entry.type = Entry::ROUTINE_ANNOUNCE;
+   entry.args[0] = eip;
+   entry.args[1] = offset;
+   entry.args[2] = line;
+   entry.args[3] = column;
+   entry.size = len_name + len_imgname + len_filename;
+   entry.data = new char[entry.size];
+   memcpy(entry.data, name, len_name);
+   memcpy(entry.data + len_name, imgname, len_imgname);
+   memcpy(entry.data + len_name + len_imgname, filename, len_filename);
+   ((Stream*)arg)->enqueue(entry);
+}
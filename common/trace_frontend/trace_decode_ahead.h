@@ -0,0 +1,129 @@
+#ifndef __TRACE_DECODE_AHEAD_H
+#define __TRACE_DECODE_AHEAD_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "sift_reader.h"
+#include "spsc_queue.h"
+#include "semaphore.h"
+#include "_thread.h"
+#include "lock.h"
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+// Decode-ahead stage for offline SIFT traces: a small pool of worker threads runs the
+// Sift::Reader of each TraceThread ahead of simulation, pushing parsed instructions and
+// (deferred) side-band events into one single-producer/single-consumer ring per trace.
+// The TraceThread consumes the ring in order and replays the side-band events on its own thread.
+// Only records that do not require a response can be deferred, so this is limited to traces
+// that were recorded without a response channel.
+
+class TraceDecodeAhead
+{
+   public:
+      struct Entry
+      {
+         enum type_t
+         {
+            INSTRUCTION,
+            CACHE_ONLY,
+            OUTPUT,
+            ROUTINE_CHANGE,
+            ROUTINE_ANNOUNCE,
+            END,
+         };
+         type_t type;
+         Sift::Instruction inst;
+         uint64_t args[4];
+         uint32_t size;
+         char *data;             //< Heap copy of variable-length payload (OUTPUT, ROUTINE_ANNOUNCE), owned by the consumer once popped
+      };
+
+      class Stream
+      {
+         public:
+            // Consumer side, called from the owning TraceThread only.
+            // Waits (and accounts consumer stall time) until an entry is available.
+            Entry& front();
+            void pop() { m_ring.pop(); }
+            UInt64 getPosition() const { return __atomic_load_n(&m_position, __ATOMIC_RELAXED); }
+            // Consumer is done, the worker stops producing for this stream
+            void close() { __atomic_store_n(&m_closed, true, __ATOMIC_RELEASE); }
+
+         private:
+            struct stats_t
+            {
+               SubsecondTime producer_stall;
+               SubsecondTime consumer_stall;
+               UInt64 entries;
+            };
+
+            Stream(Sift::Reader *reader, stats_t *stats, UInt32 depth, bool mirror_output, bool routines);
+            ~Stream();
+
+            bool fill(UInt32 max_entries);
+            void enqueue(const Entry &entry);
+            static void unsupported(const char *what);
+
+            static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address);
+            static void __handleOutputFunc(void* arg, uint8_t fd, const uint8_t *data, uint32_t size);
+            static void __handleRoutineChangeFunc(void* arg, Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip);
+            static void __handleRoutineAnnounceFunc(void* arg, uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename);
+            static uint64_t __handleSyscallFunc(void*, uint16_t, const uint8_t*, uint32_t) { unsupported("Syscall"); return 0; }
+            static int32_t __handleNewThreadFunc(void*) { unsupported("NewThread"); return 0; }
+            static int32_t __handleJoinFunc(void*, int32_t) { unsupported("Join"); return 0; }
+            static int32_t __handleForkFunc(void*) { unsupported("Fork"); return 0; }
+            static uint64_t __handleMagicFunc(void*, uint64_t a, uint64_t, uint64_t) { unsupported("Magic"); return a; }
+            static bool __handleEmuFunc(void*, Sift::EmuType, Sift::EmuRequest&, Sift::EmuReply&) { unsupported("Emu"); return false; }
+            static Sift::Mode __handleInstructionCountFunc(void*, uint32_t) { unsupported("InstructionCount"); return Sift::ModeUnknown; }
+
+            Sift::Reader *m_reader;
+            stats_t *m_stats;
+            SPSCQueue<Entry> m_ring;
+            std::deque<Entry> m_pending;  //< Entries produced while the ring was full, flushed before reading on
+            bool m_done;                  //< Producer has seen the end of the trace
+            bool m_closed;                //< Consumer no longer reads from this stream
+            UInt64 m_position;            //< Reader position, published by the producer for progress reporting
+
+            friend class TraceDecodeAhead;
+      };
+
+      TraceDecodeAhead(UInt32 num_workers, UInt32 depth);
+      ~TraceDecodeAhead();
+
+      // Start decoding ahead on reader, whose stream should already be initialized.
+      // The reader may no longer be used directly by the caller until removeStream().
+      Stream* addStream(Sift::Reader *reader, thread_id_t thread_id, bool mirror_output, bool routines);
+      void removeStream(Stream *stream);
+
+   private:
+      class Worker : public Runnable
+      {
+         public:
+            Worker(TraceDecodeAhead *pool);
+            ~Worker();
+            void spawn();
+
+            Lock m_lock;                     //< Protects m_streams
+            std::vector<Stream*> m_streams;
+
+         private:
+            void run();
+
+            TraceDecodeAhead *m_pool;
+            _Thread *m_thread;
+            Semaphore m_exited;
+      };
+
+      const UInt32 m_depth;
+      const UInt32 m_batch;              //< Maximum number of entries produced for a stream before moving on to the next one
+      std::vector<Worker*> m_workers;
+      UInt32 m_next_worker;
+      std::unordered_map<thread_id_t, Stream::stats_t*> m_stats;
+      Lock m_lock;
+      bool m_stop;
+};
+
+#endif // __TRACE_DECODE_AHEAD_H
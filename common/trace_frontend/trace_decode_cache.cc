@@ -0,0 +1,199 @@
+#include "trace_decode_cache.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "timer.h"
+#include "log.h"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char DECODE_CACHE_MAGIC[8] = { 'S', 'N', 'D', 'E', 'C', 'O', 'D', 'E' };
+static const UInt32 DECODE_CACHE_VERSION = 2;
+
+TraceDecodeCache::TraceDecodeCache(String filename)
+   : m_filename(filename)
+   , m_fd(-1)
+   , m_data(NULL)
+   , m_size(0)
+{
+   UInt64 t_start = Timer::now();
+   open();
+   printf("[SNIPER] Loaded %zu decoded instructions from %s in %.1f ms\n", m_records.size(), m_filename.c_str(), (Timer::now() - t_start) / 1e6);
+}
+
+TraceDecodeCache::~TraceDecodeCache()
+{
+   if (m_data)
+      munmap((void*)m_data, m_size);
+   if (m_fd >= 0)
+      close(m_fd);
+}
+
+void
+TraceDecodeCache::open()
+{
+   m_fd = ::open(m_filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+   if (m_fd < 0)
+   {
+      LOG_PRINT_WARNING("Cannot open decode cache %s, decoded instructions will not be saved", m_filename.c_str());
+      return;
+   }
+
+   // Other simulations may be starting up with, or appending to, the same file
+   flock(m_fd, LOCK_EX);
+
+   const Header header = makeHeader();
+   struct stat st;
+   LOG_ASSERT_ERROR(fstat(m_fd, &st) == 0, "Cannot stat decode cache %s", m_filename.c_str());
+
+   if (st.st_size == 0)
+   {
+      LOG_ASSERT_ERROR(write(m_fd, &header, sizeof(header)) == sizeof(header), "Error writing decode cache %s", m_filename.c_str());
+   }
+   else
+   {
+      Header file_header;
+      if ((size_t)st.st_size < sizeof(file_header)
+         || pread(m_fd, &file_header, sizeof(file_header), 0) != sizeof(file_header)
+         || memcmp(&file_header, &header, sizeof(header)) != 0)
+      {
+         LOG_PRINT_WARNING("Decode cache %s was written for a different decoder or simulator version, not using it", m_filename.c_str());
+         flock(m_fd, LOCK_UN);
+         close(m_fd);
+         m_fd = -1;
+         return;
+      }
+      load(st.st_size);
+   }
+
+   flock(m_fd, LOCK_UN);
+}
+
+void
+TraceDecodeCache::load(size_t size)
+{
+   // Map the file rather than reading it: records are used in place
+   void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+   LOG_ASSERT_ERROR(data != MAP_FAILED, "Cannot map decode cache %s", m_filename.c_str());
+   m_data = (const char*)data;
+   m_size = size;
+
+   size_t pos = sizeof(Header);
+   for( ; pos + sizeof(Record) <= size; pos += sizeof(Record))
+   {
+      const Record *record = (const Record*)(m_data + pos);
+      if (record->checksum != getChecksum(*record) || record->size > MAX_INSTRUCTION_SIZE)
+         break;
+      m_records[getKey(record->bytes, record->size, record->isa)] = record;
+   }
+
+   if (pos != size)
+   {
+      // A simulation was killed while appending: drop the rest so that new records are aligned again
+      LOG_PRINT_WARNING("Decode cache %s ends in an incomplete or corrupt record, truncating it", m_filename.c_str());
+      LOG_ASSERT_ERROR(ftruncate(m_fd, pos) == 0, "Cannot truncate decode cache %s", m_filename.c_str());
+   }
+}
+
+bool
+TraceDecodeCache::find(const UInt8 *bytes, UInt32 size, UInt32 isa, InstructionDecoder::Analysis &analysis)
+{
+   UInt64 key = getKey(bytes, size, isa);
+
+   ScopedLock sl(m_lock);
+
+   std::unordered_map<UInt64, const Record*>::const_iterator it = m_records.find(key);
+   if (it == m_records.end())
+      return false;
+
+   const Record *record = it->second;
+   // Guard against hash collisions
+   if (record->isa != isa || record->size != size || memcmp(record->bytes, bytes, size) != 0)
+      return false;
+
+   memcpy(&analysis, &record->analysis, sizeof(analysis));
+   return true;
+}
+
+void
+TraceDecodeCache::insert(const UInt8 *bytes, UInt32 size, UInt32 isa, const InstructionDecoder::Analysis &analysis)
+{
+   LOG_ASSERT_ERROR(size <= MAX_INSTRUCTION_SIZE, "Instruction of %u bytes does not fit in the decode cache", size);
+
+   // Zero the padding as well, the checksum covers the whole record
+   Record record;
+   memset(&record, 0, sizeof(record));
+   record.isa = isa;
+   record.size = size;
+   memcpy(record.bytes, bytes, size);
+   memcpy(&record.analysis, &analysis, sizeof(analysis));
+   record.checksum = getChecksum(record);
+
+   ScopedLock sl(m_lock);
+
+   m_new_records.push_back(record);
+   m_records[getKey(bytes, size, isa)] = &m_new_records.back();
+
+   if (m_fd >= 0)
+   {
+      flock(m_fd, LOCK_EX);
+      ssize_t written = write(m_fd, &record, sizeof(record));
+      flock(m_fd, LOCK_UN);
+
+      if (written != sizeof(record))
+      {
+         LOG_PRINT_WARNING("Error writing decode cache %s, decoded instructions will no longer be saved", m_filename.c_str());
+         close(m_fd);
+         m_fd = -1;
+      }
+   }
+}
+
+TraceDecodeCache::Header
+TraceDecodeCache::makeHeader() const
+{
+   Header header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, DECODE_CACHE_MAGIC, sizeof(header.magic));
+   header.version = DECODE_CACHE_VERSION;
+   header.record_size = sizeof(Record);
+   String arch = Sim()->getCfg()->getString("general/arch") + "/" + Sim()->getCfg()->getString("general/mode");
+   header.arch = hash(arch.data(), arch.size());
+   header.last_reg = Sim()->getDecoder()->last_reg();
+   const char *library = Sim()->getDecoder()->library_version();
+   header.library = hash(library, strlen(library));
+   header.analysis = InstructionDecoder::Analysis::VERSION;
+   return header;
+}
+
+UInt64
+TraceDecodeCache::hash(const void *data, size_t size, UInt64 seed)
+{
+   // 64-bit FNV-1a
+   const UInt8 *bytes = (const UInt8*)data;
+   UInt64 value = seed;
+   for(size_t i = 0; i < size; ++i)
+   {
+      value ^= bytes[i];
+      value *= 0x100000001b3ULL;
+   }
+   return value;
+}
+
+UInt64
+TraceDecodeCache::getKey(const UInt8 *bytes, UInt32 size, UInt32 isa)
+{
+   UInt64 key = hash(&isa, sizeof(isa));
+   key = hash(&size, sizeof(size), key);
+   return hash(bytes, size, key);
+}
+
+UInt64
+TraceDecodeCache::getChecksum(const Record &record)
+{
+   return hash((const char*)&record + sizeof(record.checksum), sizeof(record) - sizeof(record.checksum));
+}
@@ -0,0 +1,74 @@
+#ifndef __TRACE_DECODE_CACHE_H
+#define __TRACE_DECODE_CACHE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "instruction_decoder_wlib.h"
+
+#include <unordered_map>
+#include <deque>
+
+// Persistent decoded-instruction cache for the trace frontend (traceinput/decode_cache).
+// Maps the code bytes and ISA of a static instruction to its InstructionDecoder::Analysis, so that repeated runs
+// of the same traces (parameter sweeps) do not redo the operand walk for every static instruction.
+// Only the operand walk is saved: the decoder library still decodes each static instruction once per run, because
+// the trace thread and the timing models query the dl::DecodedInst directly. Compare the thread.decode_time_ns and
+// thread.decode_library_time_ns statistics of a run with an empty and with a filled cache to see what is saved.
+//
+// File format: a header identifying the decoder (architecture, mode, decoder library version, register count,
+// InstructionDecoder::Analysis::VERSION and record layout), followed by
+// fixed-size records that each carry a checksum. The file is memory-mapped at startup; the scan stops at the first
+// incomplete or corrupt record, and the file is truncated there so later appends stay aligned. Instructions not
+// found are appended with a single write() on an O_APPEND descriptor, so several simulations can share one file.
+// Records are keyed by code bytes rather than by PC, so they remain valid across traces of the same binary.
+class TraceDecodeCache
+{
+   public:
+      TraceDecodeCache(String filename);
+      ~TraceDecodeCache();
+
+      // Fill in analysis and return true when this instruction was analyzed before, in this run or an earlier one
+      bool find(const UInt8 *bytes, UInt32 size, UInt32 isa, InstructionDecoder::Analysis &analysis);
+      void insert(const UInt8 *bytes, UInt32 size, UInt32 isa, const InstructionDecoder::Analysis &analysis);
+
+   private:
+      static const UInt32 MAX_INSTRUCTION_SIZE = 16;
+
+      struct Header
+      {
+         char magic[8];
+         UInt32 version;
+         UInt32 record_size;
+         UInt32 arch;        //< Hash of general/arch and general/mode
+         UInt32 last_reg;    //< Register numbering of the decoder library
+         UInt32 library;     //< Hash of the decoder library's name and version
+         UInt32 analysis;    //< InstructionDecoder::Analysis::VERSION
+      };
+
+      struct Record
+      {
+         UInt64 checksum;    //< Hash of the rest of the record
+         UInt32 isa;
+         UInt8 size;
+         UInt8 bytes[MAX_INSTRUCTION_SIZE];
+         InstructionDecoder::Analysis analysis;
+      };
+
+      String m_filename;
+      int m_fd;               //< -1 when the file could not be written, the cache then only lives in memory
+      const char *m_data;     //< Records loaded from the file
+      size_t m_size;
+
+      Lock m_lock;
+      std::unordered_map<UInt64, const Record*> m_records;
+      std::deque<Record> m_new_records;   //< Records added by this run (deque: pointers stay valid while it grows)
+
+      void open();
+      void load(size_t size);
+      Header makeHeader() const;
+      static UInt64 hash(const void *data, size_t size, UInt64 seed = 0xcbf29ce484222325ULL);
+      static UInt64 getKey(const UInt8 *bytes, UInt32 size, UInt32 isa);
+      static UInt64 getChecksum(const Record &record);
+};
+
+#endif // __TRACE_DECODE_CACHE_H
@@ -0,0 +1,69 @@
+#include "trace_instruction_cache.h"
+#include "log.h"
+
+TraceInstructionCache::TraceInstructionCache(UInt32 size)
+   : m_num_entries(0)
+{
+   UInt32 table_size = 16;
+   while(table_size < size)
+      table_size <<= 1;
+   m_table = new table_t(table_size);
+}
+
+TraceInstructionCache::~TraceInstructionCache()
+{
+   for(UInt32 idx = 0; idx < m_table->size; ++idx)
+   {
+      if (m_table->slots[idx].pc)
+      {
+         delete m_table->slots[idx].entry->getDecoded();
+         delete m_table->slots[idx].entry;
+      }
+   }
+   delete m_table;
+   for(std::vector<table_t*>::iterator it = m_retired.begin(); it != m_retired.end(); ++it)
+      delete *it;
+}
+
+TraceInstructionCache::Entry*
+TraceInstructionCache::insert(IntPtr pc, const dl::DecodedInst *decoded)
+{
+   LOG_ASSERT_ERROR(pc != 0, "Cannot cache an instruction at address zero");
+
+   Entry *entry = findLocked(pc);
+   if (entry)
+      return entry;
+
+   // Keep the load factor below 1/2 so probe sequences stay short
+   if (2 * (m_num_entries + 1) > m_table->size)
+      grow();
+
+   entry = new Entry(pc, decoded);
+   place(m_table, pc, entry);
+   ++m_num_entries;
+
+   return entry;
+}
+
+void
+TraceInstructionCache::place(table_t *table, IntPtr pc, Entry *entry)
+{
+   UInt32 idx = hash(pc) & table->mask;
+   while(table->slots[idx].pc)
+      idx = (idx + 1) & table->mask;
+   table->slots[idx].entry = entry;
+   // Publish the slot only after the entry pointer is visible
+   __atomic_store_n(&table->slots[idx].pc, pc, __ATOMIC_RELEASE);
+}
+
+void
+TraceInstructionCache::grow()
+{
+   table_t *table = new table_t(2 * m_table->size);
+   for(UInt32 idx = 0; idx < m_table->size; ++idx)
+      if (m_table->slots[idx].pc)
+         place(table, m_table->slots[idx].pc, m_table->slots[idx].entry);
+
+   m_retired.push_back(m_table);
+   __atomic_store_n(&m_table, table, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,99 @@
+#ifndef __TRACE_INSTRUCTION_CACHE_H
+#define __TRACE_INSTRUCTION_CACHE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <decoder.h>
+
+#include <vector>
+
+class Instruction;
+class MicroOp;
+
+// Static-instruction cache for the trace frontend, keyed by PC.
+// One entry holds everything TraceThread needs for a static instruction: the decoded instruction,
+// and (once it has been simulated in detailed mode) the Instruction object and its micro-ops.
+// The table uses open addressing with linear probing and is shared by all threads of an application,
+// so each binary is decoded only once. Lookups are lock-free; insertions and filling in the Instruction
+// are done while holding getLock(). Entries are never removed, and old tables are kept around after
+// growing so concurrent readers never see freed memory.
+class TraceInstructionCache
+{
+   public:
+      class Entry
+      {
+         public:
+            Entry(IntPtr pc, const dl::DecodedInst *decoded)
+               : m_pc(pc), m_decoded(decoded), m_instruction(NULL), m_uops(NULL)
+            {}
+
+            IntPtr getPc() const { return m_pc; }
+            const dl::DecodedInst* getDecoded() const { return m_decoded; }
+            Instruction* getInstruction() const { return __atomic_load_n(&m_instruction, __ATOMIC_ACQUIRE); }
+            const std::vector<const MicroOp*>* getMicroOps() const { return m_uops; }
+
+            // Requires the cache lock
+            void setInstruction(Instruction *instruction, const std::vector<const MicroOp*> *uops)
+            {
+               m_uops = uops;
+               __atomic_store_n(&m_instruction, instruction, __ATOMIC_RELEASE);
+            }
+
+         private:
+            const IntPtr m_pc;
+            const dl::DecodedInst * const m_decoded;
+            Instruction *m_instruction;
+            const std::vector<const MicroOp*> *m_uops;
+      };
+
+      TraceInstructionCache(UInt32 size = 4096);
+      ~TraceInstructionCache();
+
+      // Lock-free lookup, returns NULL when pc has not been inserted yet
+      const Entry* find(IntPtr pc) const
+      {
+         const table_t *table = __atomic_load_n(&m_table, __ATOMIC_ACQUIRE);
+         for(UInt32 idx = hash(pc) & table->mask; ; idx = (idx + 1) & table->mask)
+         {
+            IntPtr key = __atomic_load_n(&table->slots[idx].pc, __ATOMIC_ACQUIRE);
+            if (key == pc)
+               return table->slots[idx].entry;
+            else if (key == 0)
+               return NULL;
+         }
+      }
+      // Requires the cache lock. Returns the existing entry for pc if there is one, else inserts a new one.
+      Entry* insert(IntPtr pc, const dl::DecodedInst *decoded);
+      Entry* findLocked(IntPtr pc) { return const_cast<Entry*>(find(pc)); }
+
+      Lock& getLock() { return m_lock; }
+      UInt64 getNumEntries() const { return m_num_entries; }
+
+   private:
+      struct slot_t
+      {
+         IntPtr pc;              //< Zero for an empty slot, written last when inserting
+         Entry *entry;
+      };
+      struct table_t
+      {
+         table_t(UInt32 _size) : size(_size), mask(_size - 1), slots(new slot_t[_size]())
+         {}
+         ~table_t() { delete [] slots; }
+         const UInt32 size;
+         const UInt32 mask;
+         slot_t * const slots;
+      };
+
+      static UInt32 hash(IntPtr pc) { return (pc * 0x9e3779b97f4a7c15ULL) >> 32; }
+      static void place(table_t *table, IntPtr pc, Entry *entry);
+      void grow();
+
+      table_t *m_table;
+      std::vector<table_t*> m_retired;  //< Previous tables, may still be in use by lock-free readers
+      UInt64 m_num_entries;
+      Lock m_lock;
+};
+
+#endif // __TRACE_INSTRUCTION_CACHE_H
@@ -1,5 +1,8 @@
 #include "trace_manager.h"
 #include "trace_thread.h"
+#include "trace_decode_ahead.h"
+#include "trace_decode_cache.h"
+#include "trace_instruction_cache.h"
 #include "simulator.h"
 #include "thread_manager.h"
 #include "hooks_manager.h"
@@ -25,8 +28,18 @@ TraceManager::TraceManager()
    , m_app_info(m_num_apps)
    , m_tracefiles(m_num_apps)
    , m_responsefiles(m_num_apps)
+   , m_decode_ahead(NULL)
+   , m_decode_cache(NULL)
 {
    setupTraceFiles(0);
+
+   UInt32 decode_ahead_workers = Sim()->getCfg()->getInt("traceinput/decode_ahead_workers");
+   if (decode_ahead_workers)
+      m_decode_ahead = new TraceDecodeAhead(decode_ahead_workers, Sim()->getCfg()->getInt("traceinput/decode_ahead_depth"));
+
+   String decode_cache = Sim()->getCfg()->getString("traceinput/decode_cache");
+   if (!decode_cache.empty())
+      m_decode_cache = new TraceDecodeCache(decode_cache);
 }
 
 void TraceManager::setupTraceFiles(int index)
@@ -236,6 +249,19 @@ void TraceManager::cleanup()
 TraceManager::~TraceManager()
 {
    cleanup();
+   delete m_decode_ahead;
+   delete m_decode_cache;
+   for(std::unordered_map<app_id_t, TraceInstructionCache*>::iterator it = m_instruction_caches.begin(); it != m_instruction_caches.end(); ++it)
+      delete it->second;
+}
+
+TraceInstructionCache* TraceManager::getInstructionCache(app_id_t app_id)
+{
+   ScopedLock sl(m_lock);
+
+   if (m_instruction_caches.count(app_id) == 0)
+      m_instruction_caches[app_id] = new TraceInstructionCache();
+   return m_instruction_caches[app_id];
 }
 
 void TraceManager::start()
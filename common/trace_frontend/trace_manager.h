@@ -7,8 +7,12 @@
 #include "_thread.h"
 
 #include <vector>
+#include <unordered_map>
 
 class TraceThread;
+class TraceDecodeAhead;
+class TraceDecodeCache;
+class TraceInstructionCache;
 
 class TraceManager
 {
@@ -51,6 +55,9 @@ class TraceManager
       std::vector<String> m_tracefiles;
       std::vector<String> m_responsefiles;
       String m_trace_prefix;
+      std::unordered_map<app_id_t, TraceInstructionCache*> m_instruction_caches;  //< Static-instruction caches shared by all threads of an application
+      TraceDecodeAhead *m_decode_ahead;  //< Worker pool that parses offline traces ahead of simulation (NULL when disabled)
+      TraceDecodeCache *m_decode_cache;  //< Decoded instructions saved across runs (NULL when disabled)
       Lock m_lock;
 
       String getFifoName(app_id_t app_id, UInt64 thread_num, bool response, bool create);
@@ -76,6 +83,10 @@ class TraceManager
       void endApplication(TraceThread *thread, SubsecondTime time);
       void accessMemory(int core_id, Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size);
 
+      TraceDecodeAhead* getDecodeAhead() const { return m_decode_ahead; }
+      TraceDecodeCache* getDecodeCache() const { return m_decode_cache; }
+      TraceInstructionCache* getInstructionCache(app_id_t app_id);
+
       UInt64 getProgressExpect();
       UInt64 getProgressValue();
 };
@@ -9,6 +9,7 @@
 #include "dynamic_instruction.h"
 #include "performance_model.h"
 #include "instruction_decoder_wlib.h"
+#include "trace_decode_cache.h"
 #include "config.hpp"
 #include "syscall_model.h"
 #include "core.h"
@@ -19,6 +20,8 @@
 #include "sim_api.h"
 
 #include "stats.h"
+#include "timer.h"
+#include "self_profile.h"
 
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -36,6 +39,17 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_address_randomization(Sim()->getCfg()->getBool("traceinput/address_randomization"))
    , m_appid_from_coreid(Sim()->getCfg()->getString("scheduler/type") == "sequential" ? true : false)
    , m_stop(false)
+   , m_icache(NULL)
+   , m_icache_private(false)
+   , m_icache_hits(0)
+   , m_icache_misses(0)
+   , m_icache_decodes(0)
+   , m_decode_file_hits(0)
+   , m_decode_file_misses(0)
+   , m_decode_time(0)
+   , m_decode_library_time(0)
+   , m_routine_events(0)
+   , m_routine_time(0)
    , m_bbv_base(0)
    , m_bbv_count(0)
    , m_bbv_last(0)
@@ -47,9 +61,11 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_blocked(false)
    , m_cleanup(cleanup)
    , m_started(false)
+   , m_decode_ahead(NULL)
    , m_stopped(false)
 {
 
+   m_trace.setUseMmap(Sim()->getCfg()->getBool("traceinput/mmap"));
    m_trace.setHandleInstructionCountFunc(TraceThread::__handleInstructionCountFunc, this);
    m_trace.setHandleCacheOnlyFunc(TraceThread::__handleCacheOnlyFunc, this);
    if (Sim()->getCfg()->getBool("traceinput/mirror_output"))
@@ -79,21 +95,34 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    }
 
    thread->setVa2paFunc(_va2pa, (UInt64)this);
-   
+
+   registerStatsMetric("thread", thread->getId(), "decode_cache_hits", &m_icache_hits);
+   registerStatsMetric("thread", thread->getId(), "decode_cache_misses", &m_icache_misses);
+   registerStatsMetric("thread", thread->getId(), "decode_cache_decodes", &m_icache_decodes);
+   registerStatsMetric("thread", thread->getId(), "decode_file_hits", &m_decode_file_hits);
+   registerStatsMetric("thread", thread->getId(), "decode_file_misses", &m_decode_file_misses);
+   registerStatsMetric("thread", thread->getId(), "decode_time_ns", &m_decode_time);
+   registerStatsMetric("thread", thread->getId(), "decode_library_time_ns", &m_decode_library_time);
+   if (Sim()->getRoutineTracer())
+   {
+      registerStatsMetric("thread", thread->getId(), "routine_tracer_events", &m_routine_events);
+      registerStatsMetric("thread", thread->getId(), "routine_tracer_time_ns", &m_routine_time);
+   }
+
 }
 
 TraceThread::~TraceThread()
 {
+   if (m_decode_ahead)
+      Sim()->getTraceManager()->getDecodeAhead()->removeStream(m_decode_ahead);
    delete m__thread;
    if (m_cleanup)
    {
       unlink(m_tracefile.c_str());
       unlink(m_responsefile.c_str());
    }
-   for(std::unordered_map<IntPtr, const dl::DecodedInst *>::iterator i = m_decoder_cache.begin() ; i != m_decoder_cache.end() ; ++i)
-   {
-      delete (*i).second;
-   }
+   if (m_icache_private)
+      delete m_icache;
 }
 
 UInt64 TraceThread::va2pa(UInt64 va, bool *noMapping)
@@ -204,6 +233,8 @@ uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *
    }
 
    LOG_ASSERT_ERROR(m_thread->getCore(), "Cannot execute while not on a core");
+   // The syscall model reads and advances our time
+   drainPerformanceModel();
    uint64_t ret = 0;
 
    switch(syscall_number)
@@ -242,17 +273,21 @@ int32_t TraceThread::handleForkFunc()
 
 int32_t TraceThread::handleJoinFunc(int32_t join_thread_id)
 {
+   drainPerformanceModel();
    Sim()->getThreadManager()->joinThread(m_thread->getId(), join_thread_id);
    return 0;
 }
 
 uint64_t TraceThread::handleMagicFunc(uint64_t a, uint64_t b, uint64_t c)
 {
+   drainPerformanceModel();
    return handleMagicInstruction(m_thread->getId(), a, b, c);
 }
 
 void TraceThread::handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
 {
+   UInt64 t_start = Timer::now();
+
    switch(event)
    {
       case Sift::RoutineEnter:
@@ -267,6 +302,9 @@ void TraceThread::handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t ei
       default:
          LOG_PRINT_ERROR("Invalid Sift::RoutineOpType %d", event);
    }
+
+   ++m_routine_events;
+   m_routine_time += Timer::now() - t_start;
 }
 
 bool TraceThread::handleEmuFunc(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuReply &res)
@@ -278,6 +316,7 @@ bool TraceThread::handleEmuFunc(Sift::EmuType type, Sift::EmuRequest &req, Sift:
    }
 
    LOG_ASSERT_ERROR(m_thread->getCore(), "Cannot execute while not on a core");
+   drainPerformanceModel();
 
    switch(type)
    {
@@ -372,32 +411,81 @@ void TraceThread::handleRoutineAnnounceFunc(uint64_t eip, const char *name, cons
 SubsecondTime TraceThread::getCurrentTime() const
 {
    LOG_ASSERT_ERROR(m_thread->getCore() != NULL, "Cannot get time while not on a core");
+   m_thread->getCore()->getPerformanceModel()->drain();
    return m_thread->getCore()->getPerformanceModel()->getElapsedTime();
 }
 
-Instruction* TraceThread::decode(Sift::Instruction &inst)
+void TraceThread::drainPerformanceModel()
 {
+   if (m_thread->getCore())
+      m_thread->getCore()->getPerformanceModel()->drain();
+}
 
-   //printf("PC: %lx Size: %d num_addresses=%d is_branch=%d\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch);
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-   
-   const dl::DecodedInst& dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+const TraceInstructionCache::Entry* TraceThread::lookupInstruction(Sift::Instruction &inst, bool detailed)
+{
+   // Fast path: single lock-free probe
+   const TraceInstructionCache::Entry *entry = m_icache->find(inst.sinst->addr);
+   if (entry && (!detailed || entry->getInstruction()))
+   {
+      ++m_icache_hits;
+      return entry;
+   }
 
-   OperandList list;
+   ++m_icache_misses;
 
-   // Ignore memory-referencing operands in NOP instructions
-   if (!(dec_inst.is_nop()))
+   // Slow path: decode while holding the cache lock, so other threads of this application
+   // that miss on the same instruction wait for us rather than decode it again
+   ScopedLock sl(m_icache->getLock());
+   UInt64 t_start = Timer::now();
+
+   TraceInstructionCache::Entry *new_entry = m_icache->findLocked(inst.sinst->addr);
+   if (!new_entry)
    {
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
-         if (Sim()->getDecoder()->op_read_mem(&dec_inst, mem_idx))
-            list.push_back(Operand(Operand::MEMORY, 0, Operand::READ));
+      UInt64 t_library = Timer::now();
+      const dl::DecodedInst *dec_inst = staticDecode(inst);
+      m_decode_library_time += Timer::now() - t_library;
+      new_entry = m_icache->insert(inst.sinst->addr, dec_inst);
+      ++m_icache_decodes;
+   }
+   if (detailed && !new_entry->getInstruction())
+   {
+      Instruction *instruction = decode(inst, *new_entry->getDecoded());
+      new_entry->setInstruction(instruction, instruction->getMicroOps());
+   }
 
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
-         if (Sim()->getDecoder()->op_write_mem(&dec_inst, mem_idx))
-            list.push_back(Operand(Operand::MEMORY, 0, Operand::WRITE));
+   m_decode_time += Timer::now() - t_start;
+   return new_entry;
+}
+
+Instruction* TraceThread::decode(Sift::Instruction &inst, const dl::DecodedInst &dec_inst)
+{
+
+   //printf("PC: %lx Size: %d num_addresses=%d is_branch=%d\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch);
+
+   // The operand walk only depends on the code bytes, so it can come from an earlier run
+   InstructionDecoder::Analysis analysis;
+   TraceDecodeCache *decode_cache = Sim()->getTraceManager()->getDecodeCache();
+   if (decode_cache && decode_cache->find(inst.sinst->data, inst.sinst->size, inst.isa, analysis))
+   {
+      ++m_decode_file_hits;
+   }
+   else
+   {
+      InstructionDecoder::analyze(&dec_inst, analysis);
+      if (decode_cache)
+      {
+         decode_cache->insert(inst.sinst->data, inst.sinst->size, inst.isa, analysis);
+         ++m_decode_file_misses;
+      }
    }
 
+   // Memory-referencing operands in NOP instructions were already left out by the analysis
+   OperandList list;
+   for(uint32_t idx = 0; idx < analysis.numLoads; ++idx)
+      list.push_back(Operand(Operand::MEMORY, 0, Operand::READ));
+   for(uint32_t idx = 0; idx < analysis.numStores; ++idx)
+      list.push_back(Operand(Operand::MEMORY, 0, Operand::WRITE));
+
    Instruction *instruction;
    if (inst.is_branch)
      instruction = new BranchInstruction(list); 
@@ -413,7 +501,7 @@ Instruction* TraceThread::decode(Sift::Instruction &inst)
    instruction->setDisassembly(disassembly);
    //printf("%s\n", instruction->getDisassembly().c_str());
    
-   const std::vector<const MicroOp*> *uops = InstructionDecoder::decode(inst.sinst->addr, &dec_inst, instruction);
+   const std::vector<const MicroOp*> *uops = InstructionDecoder::build(inst.sinst->addr, &dec_inst, instruction, analysis);
    instruction->setMicroOps(uops);
 
    return instruction;
@@ -436,6 +524,7 @@ Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
 
    Core *core = m_thread->getCore();
    LOG_ASSERT_ERROR(core, "We cannot execute instructions while not on a core");
+   core->getPerformanceModel()->drain();
    SubsecondTime time = core->getPerformanceModel()->getElapsedTime();
    core->countInstructions(0, icount);
 
@@ -447,7 +536,8 @@ Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
       core->getPerformanceModel()->iterate();
    }
 
-   // We may have been rescheduled
+   // We may have been rescheduled, let the old core's timing thread finish the time we just queued first
+   core->getPerformanceModel()->drain();
    if (m_thread->reschedule(time, core))
    {
       core = m_thread->getCore();
@@ -522,10 +612,7 @@ const dl::DecodedInst* TraceThread::staticDecode(Sift::Instruction &inst)
 
 void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size)
 {
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-   
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   const dl::DecodedInst &dec_inst = *lookupInstruction(inst, false)->getDecoded();
 
    // Warmup instruction caches
 
@@ -634,12 +721,10 @@ void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instr
 
    // Set up instruction
 
-   if (m_icache.count(inst.sinst->addr) == 0)
-      m_icache[inst.sinst->addr] = decode(inst);
-   // Here get the decoder instruction without checking, because we must have it for sure
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   const TraceInstructionCache::Entry *entry = lookupInstruction(inst, true);
+   const dl::DecodedInst &dec_inst = *entry->getDecoded();
 
-   Instruction *ins = m_icache[inst.sinst->addr];
+   Instruction *ins = entry->getInstruction();
    DynamicInstruction *dynins = prfmdl->createDynamicInstruction(ins, va2pa(inst.sinst->addr));
 
    // Add dynamic instruction info
@@ -762,6 +847,32 @@ void TraceThread::run()
    m_trace.initStream();
    m_trace_has_pa = m_trace.getTraceHasPhysicalAddresses();
 
+   // Optionally skip straight to the region of interest (block-compressed traces only)
+   UInt64 seek_icount = Sim()->getCfg()->getInt("traceinput/seek");
+   if (seek_icount)
+   {
+      bool res = m_trace.Seek(seek_icount);
+      LOG_ASSERT_ERROR(res, "Unable to seek trace %s to instruction %" PRId64, m_tracefile.c_str(), seek_icount);
+   }
+
+   // Offline traces (no response channel) can be parsed ahead of time by the decode-ahead workers.
+   // Traces with physical addresses are excluded as va2pa() needs the reader's mapping state.
+   if (Sim()->getTraceManager()->getDecodeAhead() && m_responsefile == "" && !m_trace_has_pa)
+   {
+      m_decode_ahead = Sim()->getTraceManager()->getDecodeAhead()->addStream(&m_trace, m_thread->getId(),
+         Sim()->getCfg()->getBool("traceinput/mirror_output"), Sim()->getRoutineTracer() != NULL);
+   }
+
+   // Share decoded instructions with the other threads of our application. When addresses are mapped per core
+   // (sequential scheduler) or through the trace's own page mapping, Instruction addresses are thread-specific.
+   if (m_appid_from_coreid || m_trace_has_pa)
+   {
+      m_icache = new TraceInstructionCache();
+      m_icache_private = true;
+   }
+   else
+      m_icache = Sim()->getTraceManager()->getInstructionCache(m_app_id);
+
    if (m_thread->getCore() == NULL)
    {
       // We didn't get scheduled on startup, wait here
@@ -774,13 +885,19 @@ void TraceThread::run()
 
    Sift::Instruction inst, next_inst;
 
-   bool have_first = m_trace.Read(inst);
+   bool have_first = readInstruction(inst);
    // Received first instruction, let TraceManager know our SIFT connection is up and running
    Sim()->getTraceManager()->signalStarted();
    m_started = true;
 
-   while(have_first && m_trace.Read(next_inst))
+   while(have_first)
    {
+      // Profile per instruction rather than around the whole loop, so that self-profiling can be switched at runtime
+      SelfProfile::Scope profile(SelfProfile::TRACE);
+
+      if (!readInstruction(next_inst))
+         break;
+
       if (m_blocked)
       {
          unblock();
@@ -836,11 +953,18 @@ void TraceThread::run()
       // We may have been rescheduled to a different core
       // by prfmdl->iterate (in handleInstructionDetailed),
       // or core->countInstructions (when using a fast-forward performance model)
-      SubsecondTime time = prfmdl->getElapsedTime();
-      if (m_thread->reschedule(time, core))
+      // Before moving, let this core's timing thread finish our instructions (perf_model/core/own_thread).
+      // Only call reschedule() after draining: the scheduler can move us at any time, a move that happens
+      // after this check is picked up on the next instruction.
+      if (m_thread->getCore() != core)
       {
-         core = m_thread->getCore();
-         prfmdl = core->getPerformanceModel();
+         prfmdl->drain();
+         SubsecondTime time = prfmdl->getElapsedTime();
+         if (m_thread->reschedule(time, core))
+         {
+            core = m_thread->getCore();
+            prfmdl = core->getPerformanceModel();
+         }
       }
 
 
@@ -852,12 +976,58 @@ void TraceThread::run()
 
    printf("[TRACE:%u] -- %s --\n", m_thread->getId(), m_stop ? "STOP" : "DONE");
 
+   prfmdl->drain();
    SubsecondTime time_end = prfmdl->getElapsedTime();
 
+   // Stop decoding ahead, the stream itself is released in our destructor as getProgressValue() may still use it
+   if (m_decode_ahead)
+      m_decode_ahead->close();
+
    Sim()->getThreadManager()->onThreadExit(m_thread->getId());
    Sim()->getTraceManager()->signalDone(this, time_end, m_stop /*aborted*/);
 }
 
+bool TraceThread::readInstruction(Sift::Instruction &inst)
+{
+   if (!m_decode_ahead)
+      return m_trace.Read(inst);
+
+   // Replay side-band events that the reader encountered before this instruction
+   while(true)
+   {
+      TraceDecodeAhead::Entry &entry = m_decode_ahead->front();
+      switch(entry.type)
+      {
+         case TraceDecodeAhead::Entry::INSTRUCTION:
+            inst = entry.inst;
+            m_decode_ahead->pop();
+            return true;
+         case TraceDecodeAhead::Entry::END:
+            // Leave the END marker in place so subsequent calls keep returning false
+            return false;
+         case TraceDecodeAhead::Entry::CACHE_ONLY:
+            handleCacheOnlyFunc(entry.args[0], (Sift::CacheOnlyType)entry.args[1], entry.args[2], entry.args[3]);
+            break;
+         case TraceDecodeAhead::Entry::OUTPUT:
+            handleOutputFunc(entry.args[0], (const uint8_t*)entry.data, entry.size);
+            break;
+         case TraceDecodeAhead::Entry::ROUTINE_CHANGE:
+            handleRoutineChangeFunc((Sift::RoutineOpType)entry.args[0], entry.args[1], entry.args[2], entry.args[3]);
+            break;
+         case TraceDecodeAhead::Entry::ROUTINE_ANNOUNCE:
+         {
+            const char *name = entry.data;
+            const char *imgname = name + strlen(name) + 1;
+            const char *filename = imgname + strlen(imgname) + 1;
+            handleRoutineAnnounceFunc(entry.args[0], name, imgname, entry.args[1], entry.args[2], entry.args[3], filename);
+            break;
+         }
+      }
+      delete [] entry.data;
+      m_decode_ahead->pop();
+   }
+}
+
 void TraceThread::spawn()
 {
    m__thread = _Thread::create(this);
@@ -871,6 +1041,8 @@ UInt64 TraceThread::getProgressExpect()
 
 UInt64 TraceThread::getProgressValue()
 {
+   if (m_decode_ahead)
+      return m_decode_ahead->getPosition();
    return m_trace.getPosition();
 }
 
@@ -8,6 +8,8 @@
 #include "sift_reader.h"
 #include "operand.h"
 #include "semaphore.h"
+#include "trace_decode_ahead.h"
+#include "trace_instruction_cache.h"
 
 #include <decoder.h>
 
@@ -55,8 +57,17 @@ class TraceThread : public Runnable
       bool m_appid_from_coreid;
       uint8_t m_address_randomization_table[256];
       bool m_stop;
-      std::unordered_map<IntPtr, Instruction *> m_icache;
-      std::unordered_map<IntPtr, const dl::DecodedInst *> m_decoder_cache;
+      TraceInstructionCache *m_icache;      //< Static-instruction cache, shared with other threads of the same application unless m_icache_private
+      bool m_icache_private;
+      UInt64 m_icache_hits;
+      UInt64 m_icache_misses;
+      UInt64 m_icache_decodes;
+      UInt64 m_decode_file_hits;      //< Instructions whose operands and uops came from the persistent decode cache
+      UInt64 m_decode_file_misses;
+      UInt64 m_decode_time;           //< Wall-clock time spent decoding static instructions, in nanoseconds
+      UInt64 m_decode_library_time;   //< Part of m_decode_time spent in the decoder library, which the persistent decode cache does not avoid
+      UInt64 m_routine_events;        //< Routine enter, exit and assert events handed to the routine tracer
+      UInt64 m_routine_time;          //< Wall-clock time spent in the routine tracer, in nanoseconds (its overhead over routine_tracer/type=none)
       UInt64 m_bbv_base;
       UInt64 m_bbv_count;
       UInt64 m_bbv_last;
@@ -70,8 +81,10 @@ class TraceThread : public Runnable
       bool m_blocked;
       bool m_cleanup;
       bool m_started;
+      TraceDecodeAhead::Stream *m_decode_ahead;  //< Non-NULL when instructions come from the decode-ahead stage
 
       void run();
+      bool readInstruction(Sift::Instruction &inst);
       static Sift::Mode __handleInstructionCountFunc(void* arg, uint32_t icount)
       { return ((TraceThread*)arg)->handleInstructionCountFunc(icount); }
       static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
@@ -107,13 +120,16 @@ class TraceThread : public Runnable
       void handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip);
       void handleRoutineAnnounceFunc(uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename);
 
-      Instruction* decode(Sift::Instruction &inst);
+      const TraceInstructionCache::Entry* lookupInstruction(Sift::Instruction &inst, bool detailed);
+      Instruction* decode(Sift::Instruction &inst, const dl::DecodedInst &dec_inst);
       void handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size);
       void handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl);
       void addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const dl::DecodedInst &decoded_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_pretetch, PerformanceModel *prfmdl);
       void unblock();
 
       SubsecondTime getCurrentTime() const;
+      // Wait for the timing thread to handle our queued instructions before reading or changing time (perf_model/core/own_thread)
+      void drainPerformanceModel();
       
       dl::DecoderFactory *m_factory;  // we need a factory here to be able to create instructions of any kind
       const dl::DecodedInst* staticDecode(Sift::Instruction &inst);
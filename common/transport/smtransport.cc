@@ -1,4 +1,7 @@
 #include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include "smtransport.h"
 #include "config.h"
@@ -68,13 +71,14 @@ void SmTransport::clearNodeForId(core_id_t core_id)
 
 SmTransport::SmNode::SmNode(core_id_t core_id, SmTransport *smt)
    : Node(core_id)
+   , m_sleeping(0)
    , m_smt(smt)
 {
 }
 
 SmTransport::SmNode::~SmNode()
 {
-   LOG_ASSERT_WARNING(m_queue.empty(), "Unread messages in queue for core: %d", getCoreId());
+   LOG_ASSERT_WARNING(m_queue.empty() && m_messages.empty(), "Unread messages in queue for core: %d", getCoreId());
    m_smt->clearNodeForId(getCoreId());
 }
 
@@ -129,8 +133,53 @@ Byte* SmTransport::SmNode::recv()
    }
 }
 
+void SmTransport::SmNode::send(SInt32 dest_id, Message *message)
+{
+   SmNode *dest_node = m_smt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+
+   LOG_PRINT("sending message -- message: %p, dest: %p", message, dest_node);
+
+   // The push is sequentially consistent, so either the receiver sees the message before going to sleep,
+   // or we see that it is sleeping
+   dest_node->m_messages.push(message);
+   if (__atomic_load_n(&dest_node->m_sleeping, __ATOMIC_SEQ_CST)
+      && __atomic_exchange_n(&dest_node->m_sleeping, 0, __ATOMIC_SEQ_CST))
+   {
+      syscall(SYS_futex, (void*) &dest_node->m_sleeping, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
+   }
+}
+
+Transport::Message* SmTransport::SmNode::recvMessage()
+{
+   LOG_PRINT("attempting recvMessage -- this: %p", this);
+
+   while (true)
+   {
+      // Messages usually arrive in bursts, spin for a short while before going to sleep
+      for (UInt32 i = 0; i < 1000; ++i)
+      {
+         Message *message = m_messages.pop();
+         if (message)
+         {
+            LOG_PRINT("message recv'd -- message: %p, this: %p", message, this);
+            return message;
+         }
+      }
+
+      // Only sleep when no sender is halfway through a push either
+      __atomic_store_n(&m_sleeping, 1, __ATOMIC_SEQ_CST);
+      if (m_messages.empty())
+         syscall(SYS_futex, (void*) &m_sleeping, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
+      __atomic_store_n(&m_sleeping, 0, __ATOMIC_RELAXED);
+   }
+}
+
 bool SmTransport::SmNode::query()
 {
+   if (!m_messages.empty())
+      return true;
+
    bool result = false;
 
    m_lock.acquire();
@@ -5,6 +5,7 @@
 
 #include "transport.h"
 #include "cond.h"
+#include "mpsc_queue.h"
 
 class SmTransport : public Transport
 {
@@ -21,14 +22,23 @@ public:
       void globalSend(SInt32, const void*, UInt32);
       void send(core_id_t, const void*, UInt32);
       Byte* recv();
+      void send(core_id_t, Message*);
+      Message* recvMessage();
       bool query();
 
    private:
       void send(SmNode *dest, const void *buffer, UInt32 length);
 
+      // Copy mode
       std::queue<Byte*> m_queue;
       Lock m_lock;
       ConditionVariable m_cond;
+
+      // Pooled mode: senders never take a lock. The receiver sets m_sleeping before it waits on it as a futex,
+      // a sender that finds it set clears it and wakes the receiver.
+      MPSCQueue<Message> m_messages;
+      int m_sleeping;
+
       SmTransport *m_smt;
    };
 
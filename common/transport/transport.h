@@ -10,14 +10,28 @@ class Transport
 public:
    virtual ~Transport() { };
 
+   // Object passed between nodes by pointer, without copying (network/transport = pooled).
+   // Ownership moves to the receiver: the sender must not touch a message after sending it.
+   class Message
+   {
+   public:
+      Message() : next(NULL) { }
+      Message *next;    //< Link in the destination node's queue
+   };
+
    class Node
    {
    public:
       virtual ~Node() { }
 
       virtual void globalSend(SInt32 dest_proc, const void *buffer, UInt32 length) = 0;
+      // Copy mode: the buffer is copied, recv() returns a new[]-allocated copy that the receiver deletes
       virtual void send(core_id_t dest, const void *buffer, UInt32 length) = 0;
       virtual Byte* recv() = 0;
+      // Pooled mode: the message itself is handed over. A node's owner uses either recv() or recvMessage(),
+      // query() covers both.
+      virtual void send(core_id_t dest, Message *message) = 0;
+      virtual Message* recvMessage() = 0;
       virtual bool query() = 0;
 
    protected:
@@ -1,6 +1,7 @@
 #include "arm_decoder.h"
 #include <iostream>
 #include <cstring>
+#include <cstdio>
 
 namespace dl 
 {
@@ -1150,6 +1151,18 @@ Decoder::decoder_reg ARMDecoder::last_reg()
   }
 }
 
+const char* ARMDecoder::library_version()
+{
+  static char version[32];
+  if (!version[0])
+  {
+    int major, minor;
+    cs_version(&major, &minor);
+    snprintf(version, sizeof(version), "capstone %d.%d", major, minor);
+  }
+  return version;
+}
+
 uint32_t ARMDecoder::map_register(decoder_reg reg) {
     int offset = 0;
     if (reg >= ARM64_REG_X0 && reg <= ARM64_REG_X28) {
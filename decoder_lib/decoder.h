@@ -152,6 +152,9 @@ class Decoder
   
     /// Get the value of the last register in the enumeration
     virtual decoder_reg last_reg() = 0;
+
+    /// Get the name and version of the underlying disassembler library
+    virtual const char* library_version() = 0;
     
     /// Get the input register mapped. Some registers can be mapped onto the lower bits of others.
     virtual uint32_t map_register(decoder_reg reg) = 0;
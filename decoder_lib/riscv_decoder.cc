@@ -494,6 +494,12 @@ Decoder::decoder_reg RISCVDecoder::last_reg()
   return dl::last_reg; // enum reg_num defined in riscv_decoder.h
 }
 
+/// rv8 is compiled into this object, see the includes above
+const char* RISCVDecoder::library_version()
+{
+  return "rv8";
+}
+
 
 RISCVDecodedInst::RISCVDecodedInst(Decoder* d, const uint8_t * code, size_t size, uint64_t address)
 {
@@ -169,6 +169,7 @@ class RISCVDecoder : public Decoder
     
     /// Get the value of the last register in the enumeration
     virtual decoder_reg last_reg() override;
+    virtual const char* library_version() override;
 
     // /// Get the target architecture of the decoder
     // dl_arch get_arch();
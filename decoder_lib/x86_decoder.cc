@@ -1,5 +1,6 @@
 #include "x86_decoder.h"
 #include <iostream>
+#include <cstdio>
 
 extern "C" 
 {
@@ -495,6 +496,14 @@ Decoder::decoder_reg X86Decoder::last_reg()
     return XED_REG_LAST;
 }
 
+const char* X86Decoder::library_version()
+{
+    static char version[64];
+    if (!version[0])
+      snprintf(version, sizeof(version), "xed %s", xed_get_version());
+    return version;
+}
+
 
 // TODO move part of this to superclass? possible in c++?
 X86DecodedInst::X86DecodedInst(Decoder* d, const uint8_t * code, size_t size, uint64_t address)
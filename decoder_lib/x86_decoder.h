@@ -49,6 +49,7 @@ class X86Decoder : public Decoder
     virtual bool is_fpvector_muldiv_opcode(decoder_opcode opcd, const DecodedInst* ins) override;    
     virtual bool is_fpvector_ldst_opcode(decoder_opcode opcd, const DecodedInst* ins) override;
     virtual decoder_reg last_reg() override;
+    virtual const char* library_version() override;
     virtual uint32_t map_register(decoder_reg reg) override { return reg; }
     virtual unsigned int num_read_implicit_registers(const DecodedInst *inst) override {return 0;}
     virtual decoder_reg get_read_implicit_reg(const DecodedInst* inst, unsigned int idx) override { return 0; }
@@ -27,6 +27,7 @@ extern KNOB<UINT64> KnobDetailedTarget;
 extern KNOB<UINT64> KnobUseResponseFiles;
 extern KNOB<UINT64> KnobEmulateSyscalls;
 extern KNOB<BOOL>   KnobSendPhysicalAddresses;
+extern KNOB<BOOL>   KnobBlockCompression;
 extern KNOB<UINT64> KnobFlowControl;
 extern KNOB<UINT64> KnobFlowControlFF;
 extern KNOB<INT64> KnobSiftAppId;
@@ -18,6 +18,25 @@
 # define SIFT_USE_ZLIB 1
 #endif
 
+// Memory-mapped trace input and decompression threads are only used by the simulator, not by the PinCRT-based recorder
+#if defined(PIN_CRT)
+# define SIFT_USE_MMAP 0
+# define SIFT_USE_THREADS 0
+#else
+# define SIFT_USE_MMAP 1
+# define SIFT_USE_THREADS 1
+#endif
+
+// Optional codecs for block-compressed traces, enabled by the Makefile when the libraries are found
+#if !defined(SIFT_USE_ZSTD) || defined(PIN_CRT)
+# undef SIFT_USE_ZSTD
+# define SIFT_USE_ZSTD 0
+#endif
+#if !defined(SIFT_USE_LZ4) || defined(PIN_CRT)
+# undef SIFT_USE_LZ4
+# define SIFT_USE_LZ4 0
+#endif
+
 namespace Sift
 {
 
@@ -42,8 +61,51 @@ namespace Sift
       ArchIA32 = 2,
       IcacheVariable = 4,
       PhysicalAddress = 8,
+      CompressionBlock = 16,
    } Option;
 
+   // Block-compressed traces (CompressionBlock): after the Header, the record stream is cut into independently
+   // compressed blocks, each starting at a record boundary with an InstructionExt record. A BlockHeader with
+   // compressed_size == 0 ends the blocks, and is followed by a BlockIndexEntry per block and a BlockIndexTrailer.
+
+   typedef enum
+   {
+      BlockCodecZlib = 1,
+      BlockCodecZstd = 2,
+      BlockCodecLZ4 = 3,
+   } BlockCodec;
+
+   typedef enum
+   {
+      BlockHasState = 1,   //< Block contains records that later blocks depend on (icache, address mapping, ISA changes)
+   } BlockFlags;
+
+   typedef struct
+   {
+      uint32_t compressed_size;  //< Size of the payload following this header
+      uint32_t size;             //< Uncompressed size
+      uint32_t num_instructions;
+      uint8_t  codec;            //< BlockCodec
+      uint8_t  flags;            //< Bit field of BlockFlags
+   } __attribute__ ((__packed__)) BlockHeader;
+
+   typedef struct
+   {
+      uint64_t offset;           //< File offset of the block's BlockHeader
+      uint64_t first_instruction;
+      uint32_t num_instructions;
+      uint32_t flags;
+   } __attribute__ ((__packed__)) BlockIndexEntry;
+
+   const uint32_t BlockIndexMagic = 0x58444e49; // "INDX"
+
+   typedef struct
+   {
+      uint64_t index_offset;     //< File offset of the first BlockIndexEntry
+      uint64_t num_blocks;
+      uint32_t magic;
+   } __attribute__ ((__packed__)) BlockIndexTrailer;
+
    typedef union
    {
       // Simple format for common instructions
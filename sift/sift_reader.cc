@@ -41,6 +41,13 @@ Sift::Reader::Reader(const char *filename, const char *response_filename, uint32
    , handleRoutineAnnounceFunc(NULL)
    , handleRoutineArg(NULL)   
    , filesize(0)
+   , inputstream(NULL)
+   , m_use_mmap(false)
+   , m_mapped(NULL)
+   , m_decode_in_place(false)
+   , m_block_input(NULL)
+   , m_block_state(0)
+   , m_icount(0)
    , last_address(0)
    , icache()
    , m_id(id)
@@ -80,19 +87,38 @@ bool Sift::Reader::initStream()
    std::cerr << "[DEBUG:" << m_id << "] InitStream Attempting Open" << std::endl;
    #endif
 
-   inputstream = new std::ifstream(m_filename, std::ios::in);
-
-   if ((!inputstream->is_open()) || (!inputstream->good()))
+   if (m_use_mmap)
    {
-      std::cerr << "[SIFT:" << m_id << "] Cannot open " << m_filename << "\n";
-      return false;
+      m_mapped = new vimstream(m_filename);
+      if (m_mapped->is_open())
+      {
+         filesize = m_mapped->size();
+         input = m_mapped;
+      }
+      else
+      {
+         // Not a regular file (e.g. a fifo written by the recorder): fall back to the stream path
+         delete m_mapped;
+         m_mapped = NULL;
+      }
    }
 
-   struct stat filestatus;
-   stat(m_filename, &filestatus);
-   filesize = filestatus.st_size;
+   if (!input)
+   {
+      inputstream = new std::ifstream(m_filename, std::ios::in);
 
-   input = new vifstream(inputstream);
+      if ((!inputstream->is_open()) || (!inputstream->good()))
+      {
+         std::cerr << "[SIFT:" << m_id << "] Cannot open " << m_filename << "\n";
+         return false;
+      }
+
+      struct stat filestatus;
+      stat(m_filename, &filestatus);
+      filesize = filestatus.st_size;
+
+      input = new vifstream(inputstream);
+   }
 
    Sift::Header hdr;
    input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
@@ -119,6 +145,17 @@ bool Sift::Reader::initStream()
    }
 #endif
 
+   if (hdr.options & CompressionBlock)
+   {
+      // Seeking and decompressing ahead on a helper thread are only possible for regular files
+      struct stat filestatus;
+      bool regular = m_mapped || (stat(m_filename, &filestatus) == 0 && S_ISREG(filestatus.st_mode));
+      if (regular)
+         loadBlockIndex();
+      input = m_block_input = new ibzstream(input, regular);
+      hdr.options &= ~CompressionBlock;
+   }
+
    if (hdr.options & ArchIA32)
    {
       hdr.options &= ~ArchIA32;
@@ -138,6 +175,8 @@ bool Sift::Reader::initStream()
       return false;
    }
 
+   m_decode_in_place = (m_mapped && input == m_mapped);
+
    #if VERBOSE > 0
    std::cerr << "[DEBUG:" << m_id << "] InitStream Connection Open" << std::endl;
    #endif
@@ -145,6 +184,32 @@ bool Sift::Reader::initStream()
    return true;
 }
 
+bool Sift::Reader::loadBlockIndex()
+{
+   std::ifstream file(m_filename, std::ios::in | std::ios::binary);
+   BlockIndexTrailer trailer;
+
+   file.seekg(-std::streamoff(sizeof(trailer)), std::ios::end);
+   file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   if (file.fail() || trailer.magic != BlockIndexMagic)
+   {
+      // Incomplete trace: we can still read it sequentially, but not seek
+      std::cerr << "[SIFT:" << m_id << "] Warning: No block index found, seeking is disabled\n";
+      return false;
+   }
+
+   m_block_index.resize(trailer.num_blocks);
+   file.seekg(trailer.index_offset);
+   file.read(reinterpret_cast<char*>(m_block_index.data()), trailer.num_blocks * sizeof(BlockIndexEntry));
+   if (file.fail())
+   {
+      m_block_index.clear();
+      return false;
+   }
+
+   return true;
+}
+
 bool Sift::Reader::initResponse()
 {
    if (!response)
@@ -179,6 +244,9 @@ bool Sift::Reader::Read(Instruction &inst)
 
    while(!m_seen_end)
    {
+      if (m_decode_in_place && decodeInPlace(inst))
+         return true;
+
       Record rec;
       uint8_t byte = input->peek();
       if (input->fail())
@@ -200,53 +268,12 @@ bool Sift::Reader::Read(Instruction &inst)
                //sendSimpleResponse(RecOtherEndResponse);
                return false;
             case RecOtherIcache:
-            {
-               assert(rec.Other.size == sizeof(uint64_t) + ICACHE_SIZE);
-               uint64_t address;
-               uint8_t *bytes = new uint8_t[ICACHE_SIZE];
-               input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(bytes), ICACHE_SIZE);
-               icache[address] = bytes;
-               break;
-            }
             case RecOtherIcacheVariable:
-            {
-               #if VERBOSE_ICACHE
-               std::cerr << __FUNCTION__ << ": rec=" << std::endl;
-               hexdump(&rec, sizeof(rec.Other));
-               #endif
-               uint64_t address;
-               size_t size = rec.Other.size - sizeof(uint64_t);
-               input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
-               size_t size_left = size;
-               while (size_left > 0)
-               {
-                  uint64_t base_addr = address & ICACHE_PAGE_MASK;
-                  if (icache.count(base_addr) == 0)
-                     icache[base_addr] = new uint8_t[ICACHE_SIZE];
-                  uint64_t offset = address & ICACHE_OFFSET_MASK;
-                  size_t read_amount = std::min(size_left, size_t(ICACHE_SIZE - offset));
-                  input->read(const_cast<char*>(reinterpret_cast<const char*>(&(icache[base_addr][offset]))), read_amount);
-
-                  #if VERBOSE_ICACHE
-                  std::cerr << __FUNCTION__ << ": Wrote " << read_amount << " bytes to 0x" << std::hex << (void*)&(icache[base_addr][offset]) << std::dec << std::endl;
-                  hexdump(&(icache[base_addr][offset]), read_amount);
-                  #endif
-
-                  size_left -= read_amount;
-                  address = base_addr + ICACHE_SIZE;
-               }
-               break;
-            }
             case RecOtherLogical2Physical:
-            {
-               assert(rec.Other.size == 2 * sizeof(uint64_t));
-               uint64_t vp, pp;
-               input->read(reinterpret_cast<char*>(&vp), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
-               vcache[vp] = pp;
+            case RecOtherRoutineAnnounce:
+            case RecOtherISAChange:
+               readStateRecord(rec);
                break;
-            }
             case RecOtherInstructionCount:
             {
                #if VERBOSE > 0
@@ -436,40 +463,6 @@ bool Sift::Reader::Read(Instruction &inst)
                   handleRoutineChangeFunc(handleRoutineArg, Sift::RoutineOpType(event), eip, esp, callEip);
                break;
             }
-            case RecOtherRoutineAnnounce:
-            {
-               uint64_t eip, offset;
-               uint16_t len_name, len_imgname, len_filename;
-               char *name, *imgname, *filename;
-               uint32_t line, column;
-               input->read(reinterpret_cast<char*>(&eip), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(&len_name), sizeof(uint16_t));
-               name = (char*)malloc(len_name);
-               input->read(name, len_name);
-               input->read(reinterpret_cast<char*>(&len_imgname), sizeof(uint16_t));
-               imgname = (char*)malloc(len_imgname);
-               input->read(imgname, len_imgname);
-               input->read(reinterpret_cast<char*>(&offset), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(&line), sizeof(uint32_t));
-               input->read(reinterpret_cast<char*>(&column), sizeof(uint32_t));
-               input->read(reinterpret_cast<char*>(&len_filename), sizeof(uint16_t));
-               filename = (char*)malloc(len_filename);
-               input->read(filename, len_filename);
-               if (handleRoutineAnnounceFunc)
-                  handleRoutineAnnounceFunc(handleRoutineArg, eip, name, imgname, offset, line, column, filename);
-               free(name);
-               free(filename);
-               break;
-            }            
-            case RecOtherISAChange:
-            { 
-               assert(rec.Other.size == sizeof(uint32_t));
-               uint32_t new_isa;
-               input->read(reinterpret_cast<char*>(&new_isa), sizeof(new_isa));
-               m_isa = new_isa; // save here new ISA mode value
-
-               break;
-            }
             default:
             {
                uint8_t *bytes = new uint8_t[rec.Other.size];
@@ -537,6 +530,7 @@ bool Sift::Reader::Read(Instruction &inst)
       printf("%016lx (%d) A%u %c%c %c%c\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch?'B':'.', inst.is_branch?(inst.taken?'T':'.'):'.', inst.is_predicate?'C':'.', inst.is_predicate?(inst.executed?'E':'n'):'.');
       #endif
 
+      ++m_icount;
       return true;
    }
 
@@ -545,6 +539,271 @@ bool Sift::Reader::Read(Instruction &inst)
    return true;
 }
 
+void Sift::Reader::readStateRecord(Record &rec)
+{
+   // Records that later instructions depend on, these are also replayed for skipped blocks by Seek()
+   switch(rec.Other.type)
+   {
+      case RecOtherIcache:
+      {
+         assert(rec.Other.size == sizeof(uint64_t) + ICACHE_SIZE);
+         uint64_t address;
+         input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
+         // Pages can be seen more than once when Seek() replays blocks
+         if (icache.count(address) == 0)
+            icache[address] = new uint8_t[ICACHE_SIZE];
+         input->read(const_cast<char*>(reinterpret_cast<const char*>(icache[address])), ICACHE_SIZE);
+         break;
+      }
+      case RecOtherIcacheVariable:
+      {
+         #if VERBOSE_ICACHE
+         std::cerr << __FUNCTION__ << ": rec=" << std::endl;
+         hexdump(&rec, sizeof(rec.Other));
+         #endif
+         uint64_t address;
+         size_t size = rec.Other.size - sizeof(uint64_t);
+         input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
+         size_t size_left = size;
+         while (size_left > 0)
+         {
+            uint64_t base_addr = address & ICACHE_PAGE_MASK;
+            if (icache.count(base_addr) == 0)
+               icache[base_addr] = new uint8_t[ICACHE_SIZE];
+            uint64_t offset = address & ICACHE_OFFSET_MASK;
+            size_t read_amount = std::min(size_left, size_t(ICACHE_SIZE - offset));
+            input->read(const_cast<char*>(reinterpret_cast<const char*>(&(icache[base_addr][offset]))), read_amount);
+
+            #if VERBOSE_ICACHE
+            std::cerr << __FUNCTION__ << ": Wrote " << read_amount << " bytes to 0x" << std::hex << (void*)&(icache[base_addr][offset]) << std::dec << std::endl;
+            hexdump(&(icache[base_addr][offset]), read_amount);
+            #endif
+
+            size_left -= read_amount;
+            address = base_addr + ICACHE_SIZE;
+         }
+         break;
+      }
+      case RecOtherLogical2Physical:
+      {
+         assert(rec.Other.size == 2 * sizeof(uint64_t));
+         uint64_t vp, pp;
+         input->read(reinterpret_cast<char*>(&vp), sizeof(uint64_t));
+         input->read(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
+         vcache[vp] = pp;
+         break;
+      }
+      case RecOtherRoutineAnnounce:
+      {
+         uint64_t eip, offset;
+         uint16_t len_name, len_imgname, len_filename;
+         char *name, *imgname, *filename;
+         uint32_t line, column;
+         input->read(reinterpret_cast<char*>(&eip), sizeof(uint64_t));
+         input->read(reinterpret_cast<char*>(&len_name), sizeof(uint16_t));
+         name = (char*)malloc(len_name);
+         input->read(name, len_name);
+         input->read(reinterpret_cast<char*>(&len_imgname), sizeof(uint16_t));
+         imgname = (char*)malloc(len_imgname);
+         input->read(imgname, len_imgname);
+         input->read(reinterpret_cast<char*>(&offset), sizeof(uint64_t));
+         input->read(reinterpret_cast<char*>(&line), sizeof(uint32_t));
+         input->read(reinterpret_cast<char*>(&column), sizeof(uint32_t));
+         input->read(reinterpret_cast<char*>(&len_filename), sizeof(uint16_t));
+         filename = (char*)malloc(len_filename);
+         input->read(filename, len_filename);
+         if (handleRoutineAnnounceFunc)
+            handleRoutineAnnounceFunc(handleRoutineArg, eip, name, imgname, offset, line, column, filename);
+         free(name);
+         free(filename);
+         break;
+      }
+      case RecOtherISAChange:
+      {
+         assert(rec.Other.size == sizeof(uint32_t));
+         uint32_t new_isa;
+         input->read(reinterpret_cast<char*>(&new_isa), sizeof(new_isa));
+         m_isa = new_isa; // save here new ISA mode value
+
+         break;
+      }
+      default:
+         assert(false);
+   }
+}
+
+bool Sift::Reader::skipRecord()
+{
+   // Consume one record without calling any of the handlers, except for state records.
+   // Returns whether the record was an instruction.
+   Record rec;
+   uint8_t byte = input->peek();
+   if (input->fail())
+      return false;
+
+   if (byte == 0)
+   {
+      input->read(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+      switch(rec.Other.type)
+      {
+         case RecOtherEnd:
+            m_seen_end = true;
+            break;
+         case RecOtherIcache:
+         case RecOtherIcacheVariable:
+         case RecOtherLogical2Physical:
+         case RecOtherRoutineAnnounce:
+         case RecOtherISAChange:
+            readStateRecord(rec);
+            break;
+         default:
+         {
+            char bytes[256];
+            for(uint32_t size_left = rec.Other.size; size_left > 0; )
+            {
+               uint32_t size = std::min(size_left, uint32_t(sizeof(bytes)));
+               input->read(bytes, size);
+               size_left -= size;
+            }
+            break;
+         }
+      }
+      return false;
+   }
+
+   uint8_t num_addresses;
+   if ((byte & 0xf) != 0)
+   {
+      input->read(reinterpret_cast<char*>(&rec), sizeof(rec.Instruction));
+      last_address += rec.Instruction.size;
+      num_addresses = rec.Instruction.num_addresses;
+   }
+   else
+   {
+      input->read(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt));
+      last_address = rec.InstructionExt.addr + rec.InstructionExt.size;
+      num_addresses = rec.InstructionExt.num_addresses;
+   }
+
+   uint64_t addresses[MAX_DYNAMIC_ADDRESSES];
+   input->read(reinterpret_cast<char*>(addresses), num_addresses * sizeof(uint64_t));
+
+   return true;
+}
+
+bool Sift::Reader::Seek(uint64_t icount)
+{
+   if (input == NULL)
+   {
+      if (!initStream())
+      {
+         std::cerr << "[SIFT:" << m_id << "] Error: initStream failed\n";
+         return false;
+      }
+   }
+
+   if (!m_block_input || m_block_index.empty())
+   {
+      std::cerr << "[SIFT:" << m_id << "] Error: Seek requires a block-compressed trace with block index\n";
+      return false;
+   }
+
+   // Find the last block that starts at or before icount
+   uint64_t target = 0;
+   while(target + 1 < m_block_index.size() && m_block_index[target + 1].first_instruction <= icount)
+      ++target;
+
+   // Blocks before the current one have been read completely, the current one may only have been read partially.
+   // Replay the state records (icache, address mappings, ...) of all blocks we are about to skip.
+   m_block_state = std::max(m_block_state, m_block_input->currentBlock());
+   for(uint64_t block = m_block_state; block < target; ++block)
+   {
+      if ((m_block_index[block].flags & BlockHasState) == 0)
+         continue;
+      if (!m_block_input->seekBlock(block, m_block_index[block].offset))
+         return false;
+      while(m_block_input->remainingInBlock() > 0 && !m_seen_end)
+         skipRecord();
+   }
+   m_block_state = std::max(m_block_state, target);
+
+   if (!m_block_input->seekBlock(target, m_block_index[target].offset))
+      return false;
+
+   // Blocks start with an InstructionExt record, so last_address is set by the first instruction we skip or read
+   m_seen_end = false;
+   m_icount = m_block_index[target].first_instruction;
+   while(m_icount < icount && !m_seen_end)
+   {
+      if (skipRecord())
+         ++m_icount;
+      else if (input->fail())
+         return false;
+   }
+
+   return m_icount == icount;
+}
+
+bool Sift::Reader::decodeInPlace(Instruction &inst)
+{
+   // Fast path for memory-mapped, uncompressed traces: decode instruction records straight from the mapping.
+   // Returns false for everything else (Other records, truncated records), which is handled by the generic path in Read().
+   const uint8_t *ptr = reinterpret_cast<const uint8_t*>(m_mapped->current());
+   uint64_t available = m_mapped->remaining();
+
+   if (available == 0 || ptr[0] == 0)
+      return false;
+
+   const Record *rec = reinterpret_cast<const Record*>(ptr);
+   uint8_t size;
+   uint64_t addr;
+   uint64_t length;
+
+   if ((ptr[0] & 0xf) != 0)
+   {
+      if (available < sizeof(rec->Instruction))
+         return false;
+      length = sizeof(rec->Instruction) + rec->Instruction.num_addresses * sizeof(uint64_t);
+      if (available < length)
+         return false;
+
+      size = rec->Instruction.size;
+      addr = last_address;
+      inst.num_addresses = rec->Instruction.num_addresses;
+      inst.is_branch = rec->Instruction.is_branch;
+      inst.taken = rec->Instruction.taken;
+      inst.is_predicate = false;
+      inst.executed = true;
+      memcpy(inst.addresses, ptr + sizeof(rec->Instruction), inst.num_addresses * sizeof(uint64_t));
+   }
+   else
+   {
+      if (available < sizeof(rec->InstructionExt))
+         return false;
+      length = sizeof(rec->InstructionExt) + rec->InstructionExt.num_addresses * sizeof(uint64_t);
+      if (available < length)
+         return false;
+
+      size = rec->InstructionExt.size;
+      addr = rec->InstructionExt.addr;
+      inst.num_addresses = rec->InstructionExt.num_addresses;
+      inst.is_branch = rec->InstructionExt.is_branch;
+      inst.taken = rec->InstructionExt.taken;
+      inst.is_predicate = rec->InstructionExt.is_predicate;
+      inst.executed = rec->InstructionExt.executed;
+      memcpy(inst.addresses, ptr + sizeof(rec->InstructionExt), inst.num_addresses * sizeof(uint64_t));
+   }
+   inst.isa = m_isa;
+
+   m_mapped->skip(length);
+   last_address = addr + size;
+
+   inst.sinst = getStaticInstruction(addr, size);
+   ++m_icount;
+
+   return true;
+}
+
 bool Sift::Reader::AccessMemory(MemoryLockType lock_signal, MemoryOpType mem_op, uint64_t d_addr, uint8_t *data_buffer, uint32_t data_size)
 {
    #if VERBOSE > 0
@@ -768,7 +1027,9 @@ void Sift::Reader::sendSimpleResponse(RecOtherType type, void *data, uint32_t si
 
 uint64_t Sift::Reader::getPosition()
 {
-   if (inputstream)
+   if (m_mapped)
+      return m_mapped->tell();
+   else if (inputstream)
       return inputstream->tellg();
    else
       return 0;
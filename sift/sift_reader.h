@@ -5,11 +5,14 @@
 #include "sift_format.h"
 
 #include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <cassert>
 
 class vistream;
 class vostream;
+class vimstream;
+class ibzstream;
 
 namespace Sift
 {
@@ -78,6 +81,13 @@ namespace Sift
          void *handleRoutineArg;
          uint64_t filesize;
          std::ifstream *inputstream;
+         bool m_use_mmap;
+         vimstream *m_mapped;       //< Underlying memory-mapped file, if any
+         bool m_decode_in_place;    //< m_mapped holds uncompressed records which can be decoded without copying
+         ibzstream *m_block_input;  //< Set for block-compressed traces
+         std::vector<BlockIndexEntry> m_block_index;
+         uint64_t m_block_state;    //< Number of leading blocks whose state records have all been processed
+         uint64_t m_icount;         //< Number of instructions read so far
 
          char *m_filename;
          char *m_response_filename;
@@ -96,6 +106,10 @@ namespace Sift
          int m_isa;
 
          bool initResponse();
+         bool loadBlockIndex();
+         bool decodeInPlace(Instruction &inst);
+         void readStateRecord(Record &rec);
+         bool skipRecord();
          const Sift::StaticInstruction* staticInfoInstruction(uint64_t addr, uint8_t size);
          const Sift::StaticInstruction* getStaticInstruction(uint64_t addr, uint8_t size);
          void sendSyscallResponse(uint64_t return_code);
@@ -107,6 +121,8 @@ namespace Sift
          ~Reader();
          bool initStream();
          bool Read(Instruction&);
+         // Continue reading at instruction number icount (block-compressed traces only)
+         bool Seek(uint64_t icount);
          bool AccessMemory(MemoryLockType lock_signal, MemoryOpType mem_op, uint64_t d_addr, uint8_t *data_buffer, uint32_t data_size);
 
          void setHandleInstructionCountFunc(HandleInstructionCountFunc func, void* arg = NULL) { handleInstructionCountFunc = func; handleInstructionCountArg = arg; }
@@ -119,8 +135,11 @@ namespace Sift
          void setHandleEmuFunc(HandleEmuFunc func, void* arg = NULL) { assert(func); handleEmuFunc = func; handleEmuArg = arg; }
          void setHandleRoutineFunc(HandleRoutineChange funcChange, HandleRoutineAnnounce funcAnnounce, void* arg = NULL) { assert(funcChange); assert(funcAnnounce); handleRoutineChangeFunc = funcChange; handleRoutineAnnounceFunc = funcAnnounce; handleRoutineArg = arg; }
          void setHandleForkFunc(HandleForkFunc func, void* arg = NULL) { assert(func); handleForkFunc = func; handleForkArg = arg;}
+         // Memory-map the trace when it is a regular file (must be called before the first Read)
+         void setUseMmap(bool use_mmap) { m_use_mmap = use_mmap; }
 
          uint64_t getPosition();
+         uint64_t getInstructionCount() const { return m_icount; }
          uint64_t getLength();
          bool getTraceHasPhysicalAddresses() const { return m_trace_has_pa; }
          uint64_t va2pa(uint64_t va);
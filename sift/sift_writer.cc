@@ -39,8 +39,9 @@ __sift_assert_fail(__const char *__assertion, __const char *__file,
 }
 
 
-Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data)
-   : response(NULL)
+Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data, bool useBlockCompression)
+   : m_block_output(NULL)
+   , response(NULL)
    , getCodeFunc(getCodeFunc)
    , getCodeFunc2(getCodeFunc2)
    , getCodeFunc2Data(getCodeFunc2Data)
@@ -63,8 +64,16 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    m_response_filename = strdup(response_filename);
 
    uint64_t options = 0;
+#if SIFT_USE_ZLIB || SIFT_USE_ZSTD || SIFT_USE_LZ4
+   if (useBlockCompression)
+      options |= CompressionBlock;
+#else
+   if (useBlockCompression) {
+      std::cerr << "[SIFT:" << m_id << "] Warning: Block compression disabled, ignoring request.\n";
+   }
+#endif
 #if SIFT_USE_ZLIB
-   if (useCompression)
+   if (useCompression && !(options & CompressionBlock))
       options |= CompressionZlib;
 #else
    if (useCompression) {
@@ -101,6 +110,8 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
 
    if (options & CompressionZlib)
       output = new ozstream(output);
+   else if (options & CompressionBlock)
+      output = m_block_output = new obzstream(output, sizeof(hdr));
 }
 
 // Modified from http://stackoverflow.com/questions/2203159/is-there-a-c-equivalent-to-getcwd
@@ -133,6 +144,8 @@ void Sift::Writer::End()
       rec.Other.type = RecOtherEnd;
       rec.Other.size = 0;
       output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+      if (m_block_output)
+         m_block_output->endBlock(ninstrs);
       output->flush();
    }
 
@@ -157,6 +170,7 @@ void Sift::Writer::End()
    {
       delete output;
       output = NULL;
+      m_block_output = NULL;
    }
 }
 
@@ -188,6 +202,13 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
       return;
    }
 
+   if (m_block_output && m_block_output->blockFull())
+   {
+      m_block_output->endBlock(ninstrs);
+      // Each block must be decodable on its own: make sure it starts with a full address
+      last_address = 0;
+   }
+
    if (m_requires_icache_per_insn)
    {
       if (! icache[addr])
@@ -214,6 +235,8 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
          hexdump((char*)buffer, sizeof(buffer));
          #endif
 
+         if (m_block_output)
+            m_block_output->markState();
          icache[addr] = true;
       }
    }
@@ -242,6 +265,8 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
             }
             output->write(reinterpret_cast<char*>(buffer), ICACHE_SIZE);
 
+            if (m_block_output)
+               m_block_output->markState();
             icache[base_addr] = true;
          }
       }
@@ -872,6 +897,8 @@ void Sift::Writer::RoutineAnnounce(uint64_t eip, const char *name, const char *i
    output->write(reinterpret_cast<char*>(&column), sizeof(uint32_t));
    output->write(reinterpret_cast<char*>(&len_filename), sizeof(uint16_t));
    output->write(filename, len_filename);
+   if (m_block_output)
+      m_block_output->markState();
 }
 
 void Sift::Writer::ISAChange(uint32_t new_isa)
@@ -897,6 +924,8 @@ void Sift::Writer::ISAChange(uint32_t new_isa)
 
    output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
    output->write(reinterpret_cast<char*>(&new_isa), sizeof(new_isa));
+   if (m_block_output)
+      m_block_output->markState();
 }
 
 bool Sift::Writer::IsOpen()
@@ -1080,6 +1109,8 @@ void Sift::Writer::send_va2pa(uint64_t va)
             output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
             output->write(reinterpret_cast<char*>(&vp), sizeof(uint64_t));
             output->write(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
+            if (m_block_output)
+               m_block_output->markState();
 
             m_va2pa[vp] = true;
          }
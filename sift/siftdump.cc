@@ -8,6 +8,7 @@
 #include <cstring>
 #include <map>
 #include <unordered_map>
+#include <sys/time.h>
 
 #if PIN_REV >= 67254
 extern "C" {
@@ -15,9 +16,39 @@ extern "C" {
 }
 #endif
 
+static double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void benchmark(const char *filename, bool use_mmap)
+{
+   Sift::Reader reader(filename);
+   reader.setUseMmap(use_mmap);
+
+   uint64_t icount = 0;
+   double t_start = now();
+
+   Sift::Instruction inst;
+   while(reader.Read(inst))
+      ++icount;
+
+   double t_elapsed = now() - t_start;
+   printf("%-6s %12" PRId64 " instructions in %8.3f s = %8.2f MIPS\n", use_mmap ? "mmap" : "stream",
+      icount, t_elapsed, t_elapsed > 0 ? icount / t_elapsed / 1e6 : 0.);
+}
+
 int main(int argc, char* argv[])
 {
-   if (argc > 1 && strcmp(argv[1], "-d") == 0)
+   if (argc > 2 && strcmp(argv[1], "-b") == 0)
+   {
+      // Compare decoding speed of the stream and memory-mapped read paths
+      benchmark(argv[2], false);
+      benchmark(argv[2], true);
+   }
+   else if (argc > 1 && strcmp(argv[1], "-d") == 0)
    {
       Sift::Reader reader(argv[2]);
       //const xed_syntax_enum_t syntax = XED_SYNTAX_ATT;
@@ -100,6 +131,6 @@ int main(int argc, char* argv[])
    }
    else
    {
-      printf("Usage: %s [-d] <file.sift>\n", argv[0]);
+      printf("Usage: %s [-d|-b] <file.sift>\n", argv[0]);
    }
 }
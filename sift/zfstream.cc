@@ -1,6 +1,108 @@
 #include "zfstream.h"
 
 #include <cassert>
+#include <cstring>
+
+#include <iostream>
+
+#if SIFT_USE_ZSTD
+#include <zstd.h>
+#endif
+#if SIFT_USE_LZ4
+#include <lz4.h>
+#endif
+
+#if SIFT_USE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+vimstream::vimstream(const char * filename)
+   : m_base(NULL)
+   , m_size(0)
+   , m_pos(0)
+   , m_released(0)
+   , m_fail(false)
+{
+#if SIFT_USE_MMAP
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+      return;
+
+   struct stat filestatus;
+   // Only regular files can be mapped, pipes are left to vifstream
+   if (fstat(fd, &filestatus) == 0 && S_ISREG(filestatus.st_mode) && filestatus.st_size > 0)
+   {
+      void *base = mmap(NULL, filestatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (base != MAP_FAILED)
+      {
+         m_base = (const char*)base;
+         m_size = filestatus.st_size;
+         madvise(base, m_size, MADV_SEQUENTIAL);
+      }
+   }
+   close(fd);
+#endif
+}
+
+vimstream::~vimstream()
+{
+#if SIFT_USE_MMAP
+   if (m_base)
+      munmap((void*)m_base, m_size);
+#endif
+}
+
+void vimstream::read(char* s, std::streamsize n)
+{
+   if (uint64_t(n) > remaining())
+   {
+      memcpy(s, current(), remaining());
+      m_pos = m_size;
+      m_fail = true;
+      return;
+   }
+   memcpy(s, current(), n);
+   skip(n);
+}
+
+int vimstream::peek()
+{
+   if (remaining() == 0)
+   {
+      m_fail = true;
+      return -1;
+   }
+   return (unsigned char)*current();
+}
+
+bool vimstream::seek(uint64_t offset)
+{
+   if (offset > m_size)
+      return false;
+   m_pos = offset;
+   m_fail = false;
+   if (m_released > m_pos)
+      m_released = 0;
+   return true;
+}
+
+void vimstream::release()
+{
+   // Tell the kernel we will not need the pages we have read so far, to keep the resident size of
+   // multi-GB traces bounded. The mapping is read-only so pages are simply refetched should we ever touch them again.
+#if SIFT_USE_MMAP
+   uint64_t pagesize = sysconf(_SC_PAGESIZE);
+   uint64_t end = m_pos & ~(pagesize - 1);
+   if (end > m_released)
+   {
+      madvise((void*)(m_base + m_released), end - m_released, MADV_DONTNEED);
+      m_released = end;
+   }
+#endif
+}
 
 #if !SIFT_USE_ZLIB
 
@@ -160,3 +262,331 @@ int izstream::peek()
 }
 
 #endif /*SIFT_USE_ZLIB*/
+
+
+// Codec support for block-compressed traces
+
+static uint8_t blockCodec()
+{
+#if SIFT_USE_ZSTD
+   return Sift::BlockCodecZstd;
+#elif SIFT_USE_LZ4
+   return Sift::BlockCodecLZ4;
+#elif SIFT_USE_ZLIB
+   return Sift::BlockCodecZlib;
+#else
+   return 0;
+#endif
+}
+
+static bool blockCompress(uint8_t codec, const std::vector<char> &in, std::vector<char> &out)
+{
+   switch(codec)
+   {
+#if SIFT_USE_ZSTD
+      case Sift::BlockCodecZstd:
+      {
+         out.resize(ZSTD_compressBound(in.size()));
+         size_t size = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), ZSTD_CLEVEL_DEFAULT);
+         if (ZSTD_isError(size))
+            return false;
+         out.resize(size);
+         return true;
+      }
+#endif
+#if SIFT_USE_LZ4
+      case Sift::BlockCodecLZ4:
+      {
+         out.resize(LZ4_compressBound(in.size()));
+         int size = LZ4_compress_default(in.data(), out.data(), in.size(), out.size());
+         if (size <= 0)
+            return false;
+         out.resize(size);
+         return true;
+      }
+#endif
+#if SIFT_USE_ZLIB
+      case Sift::BlockCodecZlib:
+      {
+         uLongf size = compressBound(in.size());
+         out.resize(size);
+         if (compress2((Bytef*)out.data(), &size, (const Bytef*)in.data(), in.size(), 9) != Z_OK)
+            return false;
+         out.resize(size);
+         return true;
+      }
+#endif
+      default:
+         return false;
+   }
+}
+
+static bool blockDecompress(uint8_t codec, const std::vector<char> &in, std::vector<char> &out)
+{
+   switch(codec)
+   {
+#if SIFT_USE_ZSTD
+      case Sift::BlockCodecZstd:
+         return ZSTD_decompress(out.data(), out.size(), in.data(), in.size()) == out.size();
+#endif
+#if SIFT_USE_LZ4
+      case Sift::BlockCodecLZ4:
+         return LZ4_decompress_safe(in.data(), out.data(), in.size(), out.size()) == int(out.size());
+#endif
+#if SIFT_USE_ZLIB
+      case Sift::BlockCodecZlib:
+      {
+         uLongf size = out.size();
+         return uncompress((Bytef*)out.data(), &size, (const Bytef*)in.data(), in.size()) == Z_OK && size == out.size();
+      }
+#endif
+      default:
+         std::cerr << "[SIFT] Error: Trace block compressed with codec " << int(codec) << ", which is not supported in this build\n";
+         return false;
+   }
+}
+
+
+
+obzstream::obzstream(vostream *output, uint64_t offset)
+   : output(output)
+   , m_offset(offset)
+   , m_codec(blockCodec())
+   , m_flags(0)
+   , m_first_instruction(0)
+{
+   assert(m_codec != 0);
+   m_buffer.reserve(2 * blocksize);
+}
+
+obzstream::~obzstream()
+{
+   // Data written after the owner's last endBlock() has no instruction count we can trust. Store it in a block of its
+   // own with no instructions, outside of the index: it does not necessarily start with an InstructionExt record,
+   // so it must not be a seek target.
+   if (!m_buffer.empty())
+      writeBlock(0, false);
+
+   Sift::BlockHeader end = { 0, 0, 0, 0, 0 };
+   writeOutput(reinterpret_cast<char*>(&end), sizeof(end));
+
+   Sift::BlockIndexTrailer trailer = { m_offset, m_index.size(), Sift::BlockIndexMagic };
+   writeOutput(reinterpret_cast<char*>(m_index.data()), m_index.size() * sizeof(Sift::BlockIndexEntry));
+   writeOutput(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   output->flush();
+
+   delete output;
+}
+
+void obzstream::endBlock(uint64_t icount)
+{
+   assert(icount >= m_first_instruction);
+   if (m_buffer.empty())
+      return;
+
+   writeBlock(icount - m_first_instruction, true);
+   m_first_instruction = icount;
+}
+
+void obzstream::writeBlock(uint32_t num_instructions, bool indexed)
+{
+   bool ok = blockCompress(m_codec, m_buffer, m_compressed);
+   assert(ok);
+
+   Sift::BlockHeader hdr = { uint32_t(m_compressed.size()), uint32_t(m_buffer.size()), num_instructions, m_codec, m_flags };
+   if (indexed)
+   {
+      Sift::BlockIndexEntry entry = { m_offset, m_first_instruction, num_instructions, m_flags };
+      m_index.push_back(entry);
+   }
+
+   writeOutput(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   writeOutput(m_compressed.data(), m_compressed.size());
+
+   m_buffer.clear();
+   m_flags = 0;
+}
+
+
+
+ibzstream::ibzstream(vistream *input, bool async)
+   : input(input)
+   , m_async(SIFT_USE_THREADS && async)
+   , m_fail(false)
+   , m_block(NULL)
+   , m_pos(0)
+   , m_next_block(0)
+#if SIFT_USE_THREADS
+   , m_stop(false)
+#endif
+{
+#if SIFT_USE_THREADS
+   pthread_mutex_init(&m_mutex, NULL);
+   pthread_cond_init(&m_cond, NULL);
+   if (m_async)
+      startHelper();
+#endif
+}
+
+ibzstream::~ibzstream()
+{
+#if SIFT_USE_THREADS
+   if (m_async)
+      stopHelper();
+   pthread_cond_destroy(&m_cond);
+   pthread_mutex_destroy(&m_mutex);
+#endif
+   delete m_block;
+   delete input;
+}
+
+bool ibzstream::readBlock(Block *block)
+{
+   Sift::BlockHeader hdr;
+   block->num = m_next_block;
+   block->end = true;
+   block->data.clear();
+
+   input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (input->fail() || hdr.compressed_size == 0)
+      return false;
+
+   m_compressed.resize(hdr.compressed_size);
+   input->read(m_compressed.data(), hdr.compressed_size);
+   if (input->fail())
+      return false;
+
+   block->data.resize(hdr.size);
+   if (!blockDecompress(hdr.codec, m_compressed, block->data))
+      return false;
+
+   block->end = false;
+   ++m_next_block;
+   return true;
+}
+
+#if SIFT_USE_THREADS
+void ibzstream::helper()
+{
+   while(true)
+   {
+      pthread_mutex_lock(&m_mutex);
+      while(!m_stop && m_ready.size() >= depth)
+         pthread_cond_wait(&m_cond, &m_mutex);
+      bool stop = m_stop;
+      pthread_mutex_unlock(&m_mutex);
+      if (stop)
+         return;
+
+      Block *block = new Block();
+      readBlock(block);
+
+      // Once published, the block belongs to the consumer, which may already have freed it
+      bool end = block->end;
+
+      pthread_mutex_lock(&m_mutex);
+      m_ready.push_back(block);
+      pthread_cond_broadcast(&m_cond);
+      pthread_mutex_unlock(&m_mutex);
+      if (end)
+         return;
+   }
+}
+
+void ibzstream::startHelper()
+{
+   m_stop = false;
+   pthread_create(&m_helper, NULL, __helper, this);
+}
+
+void ibzstream::stopHelper()
+{
+   pthread_mutex_lock(&m_mutex);
+   m_stop = true;
+   pthread_cond_broadcast(&m_cond);
+   pthread_mutex_unlock(&m_mutex);
+   pthread_join(m_helper, NULL);
+   for(auto it = m_ready.begin(); it != m_ready.end(); ++it)
+      delete *it;
+   m_ready.clear();
+}
+#endif
+
+bool ibzstream::nextBlock()
+{
+   if (m_block && m_block->end)
+      return false;
+
+#if SIFT_USE_THREADS
+   if (m_async)
+   {
+      delete m_block;
+      pthread_mutex_lock(&m_mutex);
+      while(m_ready.empty())
+         pthread_cond_wait(&m_cond, &m_mutex);
+      m_block = m_ready.front();
+      m_ready.pop_front();
+      pthread_cond_broadcast(&m_cond);
+      pthread_mutex_unlock(&m_mutex);
+   }
+   else
+#endif
+   {
+      if (!m_block)
+         m_block = new Block();
+      readBlock(m_block);
+   }
+
+   m_pos = 0;
+   return !m_block->end;
+}
+
+void ibzstream::read(char* s, std::streamsize n)
+{
+   while(n > 0)
+   {
+      if (remainingInBlock() == 0 && !nextBlock())
+      {
+         m_fail = true;
+         return;
+      }
+      uint64_t size = std::min(uint64_t(n), remainingInBlock());
+      memcpy(s, m_block->data.data() + m_pos, size);
+      m_pos += size;
+      s += size;
+      n -= size;
+   }
+}
+
+int ibzstream::peek()
+{
+   if (remainingInBlock() == 0 && !nextBlock())
+   {
+      m_fail = true;
+      return -1;
+   }
+   return (unsigned char)m_block->data[m_pos];
+}
+
+bool ibzstream::seekBlock(uint64_t block_num, uint64_t offset)
+{
+#if SIFT_USE_THREADS
+   if (m_async)
+      stopHelper();
+#endif
+
+   delete m_block;
+   m_block = NULL;
+   m_pos = 0;
+   m_fail = false;
+
+   bool ok = input->seek(offset);
+   m_next_block = block_num;
+
+#if SIFT_USE_THREADS
+   if (m_async)
+      startHelper();
+#endif
+
+   return ok && nextBlock();
+}
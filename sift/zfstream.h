@@ -6,6 +6,12 @@
 #include <ostream>
 #include <istream>
 #include <fstream>
+#include <vector>
+#include <deque>
+
+#if SIFT_USE_THREADS
+# include <pthread.h>
+#endif
 
 #if SIFT_USE_ZLIB
 # include <zlib.h>
@@ -64,6 +70,39 @@ class ozstream : public vostream
          { return output->is_open(); }
 };
 
+// Block-compressed output (CompressionBlock): buffers the record stream and compresses it in independent blocks.
+// The owner cuts blocks at record boundaries using blockFull()/endBlock(); the destructor writes the block index.
+class obzstream : public vostream
+{
+   private:
+      vostream *output;
+      uint64_t m_offset;         //< File offset of the next byte written to output
+      uint8_t m_codec;
+      uint8_t m_flags;
+      uint64_t m_first_instruction;
+      std::vector<char> m_buffer;
+      std::vector<char> m_compressed;
+      std::vector<Sift::BlockIndexEntry> m_index;
+      static const size_t blocksize = 1024*1024;
+      void writeOutput(const char* s, std::streamsize n)
+         { output->write(s, n); m_offset += n; }
+      void writeBlock(uint32_t num_instructions, bool indexed);
+   public:
+      obzstream(vostream *output, uint64_t offset);
+      virtual ~obzstream();
+      virtual void write(const char* s, std::streamsize n)
+         { m_buffer.insert(m_buffer.end(), s, s + n); }
+      virtual void flush()
+         { output->flush(); }
+      virtual bool fail()
+         { return output->fail(); }
+      virtual bool is_open()
+         { return output->is_open(); }
+      bool blockFull() const { return m_buffer.size() >= blocksize; }
+      void markState() { m_flags |= Sift::BlockHasState; }
+      void endBlock(uint64_t icount);   //< icount: total number of instructions written so far
+};
+
 
 
 class vistream
@@ -73,6 +112,7 @@ class vistream
       virtual void read(char* s, std::streamsize n) = 0;
       virtual int peek() = 0;
       virtual bool fail() const = 0;
+      virtual bool seek(uint64_t offset) { return false; }
 };
 
 class vifstream : public vistream
@@ -90,6 +130,37 @@ class vifstream : public vistream
       virtual int peek()
          { return stream->peek(); }
       virtual bool fail() const { return stream->fail(); }
+      virtual bool seek(uint64_t offset)
+         { stream->clear(); stream->seekg(offset); return !stream->fail(); }
+};
+
+// Read-only input stream backed by a memory-mapped (regular) file.
+// Besides the vistream interface, it allows records to be decoded in place through current()/skip().
+class vimstream : public vistream
+{
+   private:
+      const char *m_base;
+      uint64_t m_size;
+      uint64_t m_pos;
+      uint64_t m_released;
+      bool m_fail;
+      // Drop pages we have consumed from our mapping once this much has been read
+      static const uint64_t releasesize = 64*1024*1024;
+      void release();
+   public:
+      vimstream(const char * filename);
+      virtual ~vimstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual bool seek(uint64_t offset);
+      bool is_open() const { return m_base != NULL; }
+      const char* current() const { return m_base + m_pos; }
+      uint64_t remaining() const { return m_size - m_pos; }
+      void skip(uint64_t n)
+         { m_pos += n; if (m_pos - m_released >= releasesize) release(); }
+      uint64_t tell() const { return m_pos; }
+      uint64_t size() const { return m_size; }
 };
 
 class izstream : public vistream
@@ -114,4 +185,51 @@ class izstream : public vistream
       virtual bool fail() const { return m_fail; }
 };
 
+// Block-compressed input (CompressionBlock). When async is set, a helper thread reads and decompresses
+// the next blocks ahead of the reader; this requires an input that is not shared with anyone else.
+class ibzstream : public vistream
+{
+   private:
+      struct Block
+      {
+         uint64_t num;
+         bool end;
+         std::vector<char> data;
+      };
+
+      vistream *input;
+      bool m_async;
+      bool m_fail;
+      Block *m_block;            //< Block currently being read
+      uint64_t m_pos;            //< Read position within m_block
+      uint64_t m_next_block;     //< Number of the next block to be read from input
+      std::vector<char> m_compressed;
+
+#if SIFT_USE_THREADS
+      pthread_t m_helper;
+      pthread_mutex_t m_mutex;
+      pthread_cond_t m_cond;
+      std::deque<Block*> m_ready;
+      bool m_stop;
+      static const size_t depth = 2; //< Number of blocks to decompress ahead
+      static void* __helper(void *arg) { ((ibzstream*)arg)->helper(); return NULL; }
+      void helper();
+      void startHelper();
+      void stopHelper();
+#endif
+
+      bool readBlock(Block *block);
+      bool nextBlock();
+   public:
+      ibzstream(vistream *input, bool async);
+      virtual ~ibzstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      uint64_t currentBlock() const { return m_block ? m_block->num : 0; }
+      uint64_t remainingInBlock() const { return m_block ? m_block->data.size() - m_pos : 0; }
+      // Continue reading at block block_num, whose BlockHeader is at file offset offset
+      bool seekBlock(uint64_t block_num, uint64_t offset);
+};
+
 #endif // __ZFSTREAM_H
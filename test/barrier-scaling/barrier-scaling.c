@@ -0,0 +1,49 @@
+// Synthetic benchmark for the clock skew minimization barrier:
+// every thread runs an independent compute loop, so simulation speed is dominated by barrier overhead.
+
+#include "sim_api.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_THREADS 1024
+
+static long iterations = 1000000;
+static volatile double result[MAX_THREADS];
+
+void * work(void * arg)
+{
+   long id = (long)arg;
+   double sum = 0.;
+   for(long i = 0; i < iterations; ++i)
+      sum += i * .5;
+   result[id] = sum;
+   return NULL;
+}
+
+int main(int argc, char **argv)
+{
+   long nthreads = argc > 1 ? atol(argv[1]) : 1;
+   if (argc > 2)
+      iterations = atol(argv[2]);
+   if (nthreads < 1 || nthreads > MAX_THREADS)
+   {
+      fprintf(stderr, "Usage: %s <threads> [<iterations>]\n", argv[0]);
+      return 1;
+   }
+
+   pthread_t threads[MAX_THREADS];
+
+   SimRoiStart();
+
+   for(long i = 1; i < nthreads; ++i)
+      pthread_create(&threads[i], NULL, work, (void*)i);
+   work((void*)0);
+   for(long i = 1; i < nthreads; ++i)
+      pthread_join(threads[i], NULL);
+
+   SimRoiEnd();
+
+   return 0;
+}
@@ -0,0 +1,41 @@
+// Synthetic benchmark for the private L1 hit fast path: a streaming trace that misses in the L1 on every new cache line,
+// and an L1-resident trace where every access hits, so simulation speed is dominated by the L1 hit path.
+
+#include "sim_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_SIZE (64 << 20) // Much larger than any cache
+#define RESIDENT_SIZE (16 << 10) // Fits in a 32 KB L1-D
+
+int main(int argc, char **argv)
+{
+   if (argc < 2 || (strcmp(argv[1], "stream") && strcmp(argv[1], "resident")))
+   {
+      fprintf(stderr, "Usage: %s stream|resident [<accesses>]\n", argv[0]);
+      return 1;
+   }
+   long size = strcmp(argv[1], "stream") ? RESIDENT_SIZE : STREAM_SIZE;
+   long accesses = argc > 2 ? atol(argv[2]) : 10000000;
+   long elements = size / sizeof(long);
+
+   volatile long *data = malloc(size);
+   for(long i = 0; i < elements; ++i)
+      data[i] = i;
+
+   SimRoiStart();
+
+   // One load and one store per element, walking the buffer sequentially
+   for(long i = 0, j = 0; i < accesses; i += 2)
+   {
+      data[j] += 1;
+      if (++j == elements)
+         j = 0;
+   }
+
+   SimRoiEnd();
+
+   return 0;
+}
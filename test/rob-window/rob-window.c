@@ -0,0 +1,51 @@
+// Synthetic benchmark for the RobTimer issue stage: a pointer chase through a buffer much larger than the caches,
+// interleaved with independent ALU work, so the ROB fills up behind long-latency loads and most cycles are idle.
+
+#include "sim_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHASE_SIZE (64 << 20) // Much larger than any cache
+#define LINE (64 / sizeof(long))
+
+int main(int argc, char **argv)
+{
+   long iterations = argc > 1 ? atol(argv[1]) : 200000;
+   long elements = CHASE_SIZE / sizeof(long);
+   long lines = elements / LINE;
+
+   // Random cyclic permutation of cache lines
+   long *data = malloc(CHASE_SIZE);
+   long *order = malloc(lines * sizeof(long));
+   for(long i = 0; i < lines; ++i)
+      order[i] = i;
+   srand(1);
+   for(long i = lines - 1; i > 0; --i)
+   {
+      long j = rand() % (i + 1), t = order[i];
+      order[i] = order[j];
+      order[j] = t;
+   }
+   for(long i = 0; i < lines; ++i)
+      data[order[i] * LINE] = order[(i + 1) % lines] * LINE;
+   free(order);
+
+   SimRoiStart();
+
+   long p = 0, x = 1, y = 2;
+   for(long i = 0; i < iterations; ++i)
+   {
+      p = data[p];
+      for(int k = 0; k < 16; ++k)
+      {
+         x = x * 3 + k;
+         y ^= x >> 3;
+      }
+   }
+
+   SimRoiEnd();
+
+   printf("%ld %ld %ld\n", p, x, y);
+   return 0;
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env python2
+
+# Print statistics, and their rate per second of host time, for a set of runs made by a test's 'make run'
+
+import os, sys, re, getopt
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import sniper_lib
+
+def usage():
+  print 'Usage:', sys.argv[0], '[-h (help)] [-c <title>=<config key>]... [-s <title>=<expression>]... [-e <title> (error against the first run)] [-r <title> (rate per second of host time)] <resultsdir>...'
+  print '  In an expression, {<name>} is replaced by the configuration value <name> when it contains a \'/\','
+  print '  or else by statistic <name> summed over all cores (0 when the statistic does not exist)'
+
+
+columns = []
+error_column = None
+rate_column = None
+
+try:
+  opts, args = getopt.getopt(sys.argv[1:], 'hc:s:e:r:')
+except getopt.GetoptError, e:
+  print e
+  usage()
+  sys.exit(-1)
+for o, a in opts:
+  if o == '-h':
+    usage()
+    sys.exit()
+  if o in ('-c', '-s'):
+    if '=' not in a:
+      sys.stderr.write('%s <title>=<value>\n' % o)
+      usage()
+      sys.exit(-1)
+    title, value = a.split('=', 1)
+    columns.append((o, title, value))
+  if o == '-e':
+    error_column = a
+  if o == '-r':
+    rate_column = a
+
+titles = [ title for o, title, value in columns ]
+for title in (error_column, rate_column):
+  if title is not None and title not in titles:
+    sys.stderr.write('Unknown column %s\n' % title)
+    sys.exit(-1)
+if not args:
+  usage()
+  sys.exit(-1)
+
+
+def evaluate(expression, config, results):
+  def value(match):
+    name = match.group(1)
+    if '/' in name:
+      return repr(float(config[name]))
+    v = results.get(name, 0)
+    if type(v) is list:
+      v = sum(v)
+    return repr(float(v))
+  return eval(re.sub(r'\{([^}]+)\}', value, expression), { '__builtins__': {}, 'max': max, 'min': min })
+
+header = [ 'run' ]
+for o, title, value in columns:
+  header.append(title)
+  if title == error_column:
+    header.append('error(%)')
+header.append('walltime(s)')
+if rate_column:
+  header.append('%s/s' % rate_column)
+width = max([ len(title) for title in header ] + [ 12 ])
+runwidth = max([ len(os.path.basename(os.path.normpath(resultsdir))) for resultsdir in args ] + [ 3 ])
+print '%-*s' % (runwidth, header[0]), ' '.join([ '%*s' % (width, title) for title in header[1:] ])
+
+reference = None
+for resultsdir in args:
+  res = sniper_lib.get_results(resultsdir = resultsdir)
+  config, results = res['config'], res['results']
+  walltime = results['roi.walltime']
+  line = []
+  for o, title, value in columns:
+    if o == '-c':
+      line.append('%*s' % (width, config[value]))
+      continue
+    v = evaluate(value, config, results)
+    line.append('%*.2f' % (width, v))
+    if title == error_column:
+      if reference is None:
+        reference = v
+      line.append('%*.2f' % (width, 100. * (v - reference) / (reference or 1)))
+    if title == rate_column:
+      rate = v / walltime
+  line.append('%*.2f' % (width, walltime))
+  if rate_column:
+    line.append('%*.0f' % (width, rate))
+  print '%-*s' % (runwidth, os.path.basename(os.path.normpath(resultsdir))), ' '.join(line)
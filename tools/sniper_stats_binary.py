@@ -0,0 +1,147 @@
+import os, sys, struct, shutil, sqlite3, getopt, sniper_stats
+
+# Reader for sim.stats.bin, written by StatsManager when [stats] backend = binary.
+# Every metric instance is a column with a dense ID; each snapshot is one array holding the value of every column.
+# Topology and events are still kept in sim.stats.sqlite3.
+
+MAGIC = 'SNSTATS\0'
+VERSION = 1
+RECORD_NAME, RECORD_COLUMNS, RECORD_SNAPSHOT = range(1, 4)
+
+class SniperStatsBinary(sniper_stats.SniperStatsBase):
+  def __init__(self, filename = 'sim.stats.bin', dbfilename = None):
+    self.filename = filename
+    self.dbfilename = dbfilename
+    self.db = None
+    self.names = {}       # nameid -> (objectname, metricname)
+    self.columns = []     # column id -> (nameid, index)
+    self.snapshots = []   # (prefixname, file offset of the values, number of columns)
+    self.read_index()
+
+  def read_index(self):
+    fp = open(self.filename, 'rb')
+    magic, version = struct.unpack('<8sQ', fp.read(16))
+    if magic != MAGIC or version != VERSION:
+      raise ValueError('%s is not a Sniper binary statistics file' % self.filename)
+    while True:
+      header = fp.read(8)
+      if len(header) < 8:
+        break
+      rtype, size = struct.unpack('<II', header)
+      offset = fp.tell()
+      if os.fstat(fp.fileno()).st_size < offset + size:
+        # Last record is still being written
+        break
+      if rtype == RECORD_NAME:
+        data = fp.read(size)
+        nameid, = struct.unpack('<Q', data[:8])
+        objectname, metricname = data[8:].split('\0')[:2]
+        self.names[nameid] = (objectname, metricname)
+      elif rtype == RECORD_COLUMNS:
+        data = struct.unpack('<%dQ' % (size / 8), fp.read(size))
+        if data[0] != len(self.columns):
+          raise ValueError('Unexpected column ID %d in %s' % (data[0], self.filename))
+        for nameid, index in zip(data[1::2], data[2::2]):
+          # Indices are stored as UInt32, -1 is used for global metrics
+          self.columns.append((nameid, index - (1 << 32) if index >= (1 << 31) else index))
+      elif rtype == RECORD_SNAPSHOT:
+        prefixid, length = struct.unpack('<QQ', fp.read(16))
+        prefix_words = (length + 7) / 8
+        prefix = fp.read(prefix_words * 8)[:length]
+        ncolumns, = struct.unpack('<Q', fp.read(8))
+        self.snapshots.append((prefix, fp.tell(), ncolumns))
+      fp.seek(offset + size)
+    fp.close()
+
+  def get_snapshots(self):
+    return [ prefix for prefix, offset, ncolumns in self.snapshots ]
+
+  def read_values(self, prefix):
+    for _prefix, offset, ncolumns in self.snapshots:
+      if _prefix == prefix:
+        fp = open(self.filename, 'rb')
+        fp.seek(offset)
+        values = struct.unpack('<%dQ' % ncolumns, fp.read(ncolumns * 8))
+        fp.close()
+        return values
+    raise ValueError('Invalid prefix %s' % prefix)
+
+  def read_snapshot(self, prefix, metrics = None):
+    values = {}
+    for column, value in enumerate(self.read_values(prefix)):
+      # Match the sqlite backend, which does not store metrics still at their initial value
+      if not value:
+        continue
+      nameid, index = self.columns[column]
+      if metrics and '%s.%s' % self.names[nameid] not in metrics:
+        continue
+      if nameid not in values: values[nameid] = {}
+      values[nameid][index] = value
+    return values
+
+  def get_db(self):
+    if not self.db:
+      if not self.dbfilename or not os.path.exists(self.dbfilename):
+        raise ValueError('Topology and event information requires sim.stats.sqlite3')
+      import sniper_stats_sqlite
+      self.db = sniper_stats_sqlite.SniperStatsSqlite(self.dbfilename)
+    return self.db
+
+  def get_topology(self):
+    return self.get_db().get_topology()
+
+  def get_markers(self):
+    return self.get_db().get_markers()
+
+  def get_events(self):
+    return self.get_db().get_events()
+
+  def convert(self, outfilename):
+    # Write an sqlite statistics database in the format of the sqlite backend, including topology and events
+    if self.dbfilename and os.path.exists(self.dbfilename):
+      shutil.copyfile(self.dbfilename, outfilename)
+    db = sqlite3.connect(outfilename)
+    c = db.cursor()
+    for create in ('CREATE TABLE IF NOT EXISTS `names` (nameid INTEGER, objectname TEXT, metricname TEXT)',
+                   'CREATE TABLE IF NOT EXISTS `prefixes` (prefixid INTEGER, prefixname TEXT)',
+                   'CREATE TABLE IF NOT EXISTS `values` (prefixid INTEGER, nameid INTEGER, core INTEGER, value INTEGER)'):
+      c.execute(create)
+    c.executemany('INSERT INTO `names` (nameid, objectname, metricname) VALUES (?, ?, ?)',
+                  [ (nameid, objectname, metricname) for nameid, (objectname, metricname) in sorted(self.names.items()) ])
+    for prefixid, prefix in enumerate(self.get_snapshots()):
+      c.execute('INSERT INTO `prefixes` (prefixid, prefixname) VALUES (?, ?)', (prefixid + 1, prefix))
+      c.executemany('INSERT INTO `values` (prefixid, nameid, core, value) VALUES (?, ?, ?, ?)',
+                    [ (prefixid + 1, self.columns[column][0], self.columns[column][1], value)
+                      for column, value in enumerate(self.read_values(prefix)) if value ])
+    db.commit()
+    db.close()
+
+
+if __name__ == '__main__':
+  def usage():
+    print 'Usage:', sys.argv[0], '[-h|--help (help)] [-d <resultsdir (.)>] [-o <sqlite output file>]'
+    print '  Without -o, list the snapshots in sim.stats.bin; with -o, convert sim.stats.bin to an sqlite database'
+
+  resultsdir = '.'
+  outfilename = None
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hd:o:", [ "help" ])
+  except getopt.GetoptError, e:
+    print e
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o in ('-h', '--help'):
+      usage()
+      sys.exit()
+    if o == '-d':
+      resultsdir = a
+    if o == '-o':
+      outfilename = a
+
+  stats = SniperStatsBinary(os.path.join(resultsdir, 'sim.stats.bin'), os.path.join(resultsdir, 'sim.stats.sqlite3'))
+  if outfilename:
+    stats.convert(outfilename)
+  else:
+    print stats.get_snapshots()